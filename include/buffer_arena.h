@@ -0,0 +1,204 @@
+//
+// buffer_arena.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_BUFFER_ARENA_H
+#define BGL_BUFFER_ARENA_H
+
+#include <vector>
+#include <OpenGL/gltypes.h>
+#include "vertex_attribute_array.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "vertex_array_object.h"
+#include "range_allocator.h"
+
+namespace BarelyGL {
+/**
+ * @class BufferArena
+ * @brief Packs many meshes into one large VBO/IBO pair sharing a single VAO
+ *
+ * Each mesh is given a range of vertices and a range of indices in the shared
+ * buffers. Indices stay relative to the mesh's first vertex and are drawn with
+ * `glDrawElementsBaseVertex`, so switching mesh never rebinds a buffer. All
+ * meshes in an arena must use the same vertex attributes.
+ */
+class BufferArena
+{
+public:
+  /// Identifies a mesh allocated in the arena
+  typedef size_t Handle;
+
+  /**
+   * @struct Range
+   * @brief Where a mesh lives in the shared buffers
+   */
+  struct Range
+  {
+    /// The first vertex of the mesh (added to every index when drawing)
+    GLint base_vertex;
+    /// The number of vertices in the mesh
+    GLsizei vertex_count;
+    /// The first index of the mesh
+    GLsizei first_index;
+    /// The number of indices in the mesh
+    GLsizei index_count;
+  };
+
+  /**
+   * @struct Stats
+   * @brief Usage statistics of the arena
+   */
+  struct Stats
+  {
+    /// The number of live allocations
+    size_t allocations;
+    /// The number of vertices the arena can hold
+    size_t vertex_capacity;
+    /// The number of vertices in use
+    size_t vertices_used;
+    /// The number of indices the arena can hold
+    size_t index_capacity;
+    /// The number of indices in use
+    size_t indices_used;
+    /// How fragmented the free vertex space is (0 is not at all)
+    float vertex_fragmentation;
+    /// How fragmented the free index space is (0 is not at all)
+    float index_fragmentation;
+    /// The fraction of vertex and index storage in use (by bytes)
+    float utilization;
+  };
+
+  /**
+   * @brief Creates the shared buffers and the VAO describing them
+   *
+   * @param attributes the vertex attributes of every mesh in the arena
+   * @param vertex_capacity the number of vertices to allocate space for
+   * @param index_capacity the number of indices to allocate space for
+   * @param usage usage pattern of the buffers (GL_STATIC_DRAW etc)
+   *
+   * @throws GL::Exception if the buffers fail to be constructed
+   */
+  BufferArena(const VertexAttributeArray& attributes, size_t vertex_capacity,
+              size_t index_capacity, GLenum usage);
+
+  /**
+   * @brief Allocates space for a mesh and uploads it
+   *
+   * If the free space is too fragmented to fit the mesh the arena is
+   * defragmented first. Whatever VAO was bound is bound again afterwards.
+   *
+   * @param vertices the vertex data (laid out as described by the attributes)
+   * @param indices the indices, relative to the first vertex of the mesh
+   *
+   * @return a handle to the mesh
+   *
+   * @throws GL::Exception if the mesh is empty or has a partial vertex, or
+   * there is not enough free space
+   */
+  Handle allocate(const std::vector<float>& vertices, const std::vector<int>& indices);
+
+  /**
+   * @brief Releases the space used by a mesh
+   *
+   * @param handle the mesh to release
+   */
+  void free(Handle handle);
+
+  /**
+   * @brief Gets where a mesh lives in the shared buffers
+   *
+   * Note: Ranges change when the arena is defragmented, handles do not
+   *
+   * @param handle the mesh
+   *
+   * @return the range of the mesh
+   */
+  const Range& range(Handle handle) const { return entries_[handle].range; }
+
+  /**
+   * @brief Binds the shared VAO (call before drawing any meshes)
+   */
+  void bind() const;
+
+  /**
+   * @brief Draws one mesh from the arena
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param mode drawing mode (usually GL_TRIANGLES)
+   * @param handle the mesh to draw
+   */
+  void draw(GLenum mode, Handle handle) const;
+
+  /**
+   * @brief Unbinds the shared VAO
+   */
+  void unbind() const;
+
+  /**
+   * @brief Packs all live meshes to the start of the buffers
+   *
+   * The data is copied on the GPU into a fresh pair of buffers, which then
+   * replace the old ones. Whatever VAO was bound is bound again afterwards.
+   */
+  void defragment();
+
+  /**
+   * @brief Gets fragmentation and utilization statistics
+   *
+   * @return the current statistics
+   */
+  Stats stats() const;
+
+  /**
+   * @brief Gets the shared vertex buffer
+   */
+  const VertexBufferObject& vertex_buffer() const { return vertex_buffer_; }
+
+  /**
+   * @brief Gets the shared index buffer
+   */
+  const IndexBufferObject& index_buffer() const { return index_buffer_; }
+
+private:
+  /**
+   * @struct Entry
+   * @brief Book-keeping for a single handle
+   */
+  struct Entry
+  {
+    /// Where the mesh lives
+    Range range;
+    /// Whether the handle is in use
+    bool live;
+  };
+
+  /**
+   * @brief Sets up the VAO to read from the current buffers
+   */
+  void setup_array();
+
+  /// The attributes of each vertex
+  VertexAttributeArray attributes_;
+  /// The usage pattern of the buffers
+  GLenum usage_;
+  /// The shared vertex buffer
+  VertexBufferObject vertex_buffer_;
+  /// The shared index buffer
+  IndexBufferObject index_buffer_;
+  /// The VAO describing the shared buffers
+  VertexArrayObject array_;
+  /// The allocator for vertex ranges (in vertices)
+  RangeAllocator vertex_ranges_;
+  /// The allocator for index ranges (in indices)
+  RangeAllocator index_ranges_;
+  /// Every handle ever given out, indexed by handle
+  std::vector<Entry> entries_;
+  /// Handles that have been freed and can be reused
+  std::vector<Handle> free_handles_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_BUFFER_ARENA_H)
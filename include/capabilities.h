@@ -0,0 +1,115 @@
+//
+// capabilities.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_CAPABILITIES_H
+#define BGL_CAPABILITIES_H
+
+#include <string>
+#include <unordered_set>
+
+namespace BarelyGL {
+/**
+ * @class Capabilities
+ * @brief The OpenGL version and extensions of the current context
+ *
+ * Features newer than the headers the library is built against are compiled
+ * out entirely; this is for choosing between the paths that are compiled in
+ * at runtime.
+ */
+class Capabilities
+{
+public:
+  /**
+   * @brief Gets the capabilities, querying them the first time
+   *
+   * Note: Must be first called with a context current, and assumes every
+   * context the library is used with has the same capabilities
+   *
+   * @return the capabilities of the context
+   */
+  static const Capabilities& get();
+
+  /**
+   * @brief Gets the major version of the context
+   */
+  int major_version() const { return major_; }
+
+  /**
+   * @brief Gets the minor version of the context
+   */
+  int minor_version() const { return minor_; }
+
+  /**
+   * @brief Whether the context is at least the given version
+   *
+   * @param major the major version
+   * @param minor the minor version
+   *
+   * @return true if the context's version is the same or newer
+   */
+  bool version_at_least(int major, int minor) const
+  {
+    return major_ > major || (major_ == major && minor_ >= minor);
+  }
+
+  /**
+   * @brief Whether the context supports an extension
+   *
+   * @param name the name of the extension (e.g. "GL_ARB_multi_bind")
+   *
+   * @return true if the extension is supported
+   */
+  bool has_extension(const std::string& name) const { return extensions_.count(name) > 0; }
+
+  /**
+   * @brief Whether the wrappers edit objects with direct state access
+   *
+   * True when built against GL 4.5 headers and the context is 4.5 or has
+   * ARB_direct_state_access. Buffers and vertex arrays are then edited by
+   * name, and buffers get immutable storage where they can. Textures only
+   * get immutable storage (and are only edited by name) when they have a
+   * sized internal format; ones with an unsized format (e.g. GL_RGBA) stay
+   * mutable and still have to be bound to edit.
+   */
+  bool direct_state_access() const { return direct_state_access_; }
+
+  /**
+   * @brief Whether compute shaders and shader storage buffers can be used
+   *
+   * True when built against GL 4.3 headers and the context is 4.3 or has both
+   * ARB_compute_shader and ARB_shader_storage_buffer_object.
+   */
+  bool compute_shaders() const { return compute_shaders_; }
+
+  /**
+   * @brief Whether vertex formats can be set apart from buffer bindings
+   *
+   * True when built against GL 4.3 headers and the context is 4.3 or has
+   * ARB_vertex_attrib_binding.
+   */
+  bool vertex_attrib_binding() const { return vertex_attrib_binding_; }
+
+private:
+  /**
+   * @brief Queries the current context
+   */
+  Capabilities();
+
+  /// The major version of the context
+  int major_ = 0;
+  /// The minor version of the context
+  int minor_ = 0;
+  /// The names of the supported extensions
+  std::unordered_set<std::string> extensions_;
+  /// Whether direct state access is compiled in and supported
+  bool direct_state_access_ = false;
+  /// Whether compute shaders are compiled in and supported
+  bool compute_shaders_ = false;
+  /// Whether separate vertex formats are compiled in and supported
+  bool vertex_attrib_binding_ = false;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_CAPABILITIES_H)
@@ -0,0 +1,111 @@
+//
+// fence.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_FENCE_H
+#define BGL_FENCE_H
+
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class Fence
+ * @brief Wrapper around an OpenGL fence sync object
+ *
+ * A fence placed in the command stream is signalled once the GPU has finished
+ * every command before it, which makes it the way to tell when a buffer the
+ * GPU was reading or writing can be touched again. An empty fence (never
+ * placed, or already seen signalled) counts as signalled.
+ */
+class Fence
+{
+public:
+  /**
+   * @brief Creates an empty fence
+   */
+  Fence() {};
+  ~Fence();
+
+  /**
+   * @brief Takes ownership of another fence's sync object
+   *
+   * @param other the fence to move from (left empty)
+   */
+  Fence(Fence&& other) noexcept;
+
+  /**
+   * @brief Deletes the current sync object and takes ownership of another fence's
+   *
+   * @param other the fence to move from (left empty)
+   */
+  Fence& operator=(Fence&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Fence(const Fence&) = delete;
+  Fence& operator=(const Fence&) = delete;
+
+  /**
+   * @brief Places the fence after every command issued so far
+   *
+   * Replaces the sync object if the fence was already placed.
+   *
+   * @param flush whether to flush the commands, so the fence is guaranteed to
+   *              signal even if nothing else flushes (needed before polling it)
+   *
+   * @throws GL::Exception if the sync object could not be created
+   */
+  void place(bool flush = true);
+
+  /**
+   * @brief Checks whether the GPU has reached the fence, without waiting
+   *
+   * @return true if the fence has been signalled (or is empty)
+   *
+   * @throws GL::Exception if the wait fails
+   */
+  bool signalled();
+
+  /**
+   * @brief Blocks the calling thread until the GPU reaches the fence
+   *
+   * @param timeout the most nanoseconds to wait for
+   *
+   * @return true if the fence has been signalled, false if the wait timed out
+   *
+   * @throws GL::Exception if the wait fails
+   */
+  bool wait(GLuint64 timeout);
+
+  /**
+   * @brief Blocks the calling thread until the GPU reaches the fence, however long it takes
+   *
+   * @throws GL::Exception if the wait fails
+   */
+  void wait();
+
+  /**
+   * @brief Makes the GPU wait for the fence before running later commands
+   *
+   * Doesn't block the calling thread; useful when the fence was placed on
+   * another (shared) context.
+   */
+  void gpu_wait() const;
+
+  /**
+   * @brief Deletes the sync object, leaving the fence empty
+   */
+  void reset();
+
+  /**
+   * @brief Whether the fence has no sync object
+   */
+  bool empty() const { return sync_ == nullptr; }
+
+private:
+  /// The underlying sync object (or `nullptr`)
+  GLsync sync_ = nullptr;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_FENCE_H)
@@ -0,0 +1,112 @@
+//
+// frame_pacer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_FRAME_PACER_H
+#define BGL_FRAME_PACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "fence.h"
+
+namespace BarelyGL {
+/**
+ * @class FramePacer
+ * @brief Bounds how many frames the CPU can queue ahead of the GPU
+ *
+ * A fence is placed at the end of every frame. Before starting frame N, the
+ * pacer waits for the fence of frame N - `frames_in_flight`, so at most that
+ * many frames are ever queued. The time spent waiting is measured, and shows
+ * when the application is GPU bound.
+ *
+ * Ring-buffered resources can keep `frames_in_flight()` regions and write to
+ * region `slot()` each frame: by the time `begin_frame()` returns, the GPU is
+ * done with whatever was in that region. `is_complete()` answers the same
+ * question for any earlier frame.
+ *
+ * Usage:
+ *    pacer.begin_frame();
+ *    // ... update and draw ...
+ *    pacer.end_frame();
+ *    // ... swap buffers ...
+ */
+class FramePacer
+{
+public:
+  /**
+   * @brief Creates a pacer with no frames in flight
+   *
+   * @param frames_in_flight the most frames the GPU may be behind (at least 1)
+   */
+  explicit FramePacer(size_t frames_in_flight = 2);
+
+  /**
+   * @brief Waits until the GPU has finished the frame whose slot is about to be reused
+   *
+   * @throws GL::Exception if the wait fails
+   */
+  void begin_frame();
+
+  /**
+   * @brief Places the fence for the current frame and moves to the next
+   *
+   * @throws GL::Exception if the fence could not be created
+   */
+  void end_frame();
+
+  /**
+   * @brief Checks whether the GPU has finished a frame, without waiting
+   *
+   * @param frame the number of the frame (as returned by `frame()` during it)
+   *
+   * @return true if every command of the frame has finished
+   */
+  bool is_complete(uint64_t frame);
+
+  /**
+   * @brief Gets the number of the current frame (starting from 0)
+   */
+  uint64_t frame() const { return frame_; }
+
+  /**
+   * @brief Gets the ring slot of the current frame, in [0, `frames_in_flight()`)
+   */
+  size_t slot() const { return static_cast<size_t>(frame_ % fences_.size()); }
+
+  /**
+   * @brief Gets the most frames the GPU may be behind
+   */
+  size_t frames_in_flight() const { return fences_.size(); }
+
+  /**
+   * @brief Gets how long the last `begin_frame()` waited on the GPU
+   */
+  std::chrono::nanoseconds last_wait() const { return last_wait_; }
+
+  /**
+   * @brief Gets how long `begin_frame()` has waited on the GPU in total
+   */
+  std::chrono::nanoseconds total_wait() const { return total_wait_; }
+
+  /**
+   * @brief Gets the number of frames where `begin_frame()` had to wait
+   */
+  uint64_t stalled_frames() const { return stalled_frames_; }
+
+private:
+  /// The fence placed at the end of the last frame to use each slot
+  std::vector<Fence> fences_;
+  /// The number of the current frame
+  uint64_t frame_ = 0;
+  /// The time the last `begin_frame()` waited
+  std::chrono::nanoseconds last_wait_{0};
+  /// The time every `begin_frame()` has waited
+  std::chrono::nanoseconds total_wait_{0};
+  /// The number of frames that waited
+  uint64_t stalled_frames_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_FRAME_PACER_H)
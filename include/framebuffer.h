@@ -0,0 +1,183 @@
+//
+// framebuffer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_FRAMEBUFFER_H
+#define BGL_FRAMEBUFFER_H
+
+#include <vector>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+class Texture;
+class Renderbuffer;
+
+/**
+ * @class Framebuffer
+ * @brief Wrapper around OpenGL framebuffer
+ *
+ * The framebuffer doesn't own its attachments, so they must outlive it (or be
+ * replaced before they are destroyed).
+ */
+class Framebuffer
+{
+public:
+  /**
+   * @brief Creates a new framebuffer with no attachments
+   *
+   * @throws GL::Exception if the object fails to be constructed
+   */
+  Framebuffer();
+
+  ~Framebuffer();
+
+  /**
+   * @brief Takes ownership of another framebuffer's underlying object
+   *
+   * @param other the framebuffer to move from (left without an object)
+   */
+  Framebuffer(Framebuffer&& other) noexcept;
+
+  /**
+   * @brief Destroys the current object and takes ownership of another framebuffer's
+   *
+   * @param other the framebuffer to move from (left without an object)
+   */
+  Framebuffer& operator=(Framebuffer&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Framebuffer(const Framebuffer&) = delete;
+  Framebuffer& operator=(const Framebuffer&) = delete;
+
+  /**
+   * @brief Binds the framebuffer for both drawing and reading
+   */
+  void bind() const;
+
+  /**
+   * @brief Binds the default framebuffer
+   */
+  void unbind() const;
+
+  /**
+   * @brief Attaches a level of a texture
+   *
+   * Array and 3D textures are attached whole, for layered rendering (the layer
+   * is picked with `gl_Layer` in a geometry shader).
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param attachment the attachment point (e.g. GL_COLOR_ATTACHMENT0)
+   * @param texture the texture to render into
+   * @param level the mipmap level to render into
+   */
+  void attach(GLenum attachment, const Texture& texture, int level = 0);
+
+  /**
+   * @brief Attaches a single layer of an array or 3D texture
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param attachment the attachment point (e.g. GL_COLOR_ATTACHMENT0)
+   * @param texture the texture to render into
+   * @param layer the layer (or depth slice) to render into
+   * @param level the mipmap level to render into
+   */
+  void attach_layer(GLenum attachment, const Texture& texture, int layer, int level = 0);
+
+  /**
+   * @brief Attaches a renderbuffer
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param attachment the attachment point (e.g. GL_DEPTH_ATTACHMENT)
+   * @param renderbuffer the renderbuffer to render into
+   */
+  void attach(GLenum attachment, const Renderbuffer& renderbuffer);
+
+  /**
+   * @brief Detaches whatever is at an attachment point
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param attachment the attachment point to clear
+   */
+  void detach(GLenum attachment);
+
+  /**
+   * @brief Sets which color attachments fragment outputs are written to
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param buffers the color attachments, in fragment output order
+   */
+  void set_draw_buffers(const std::vector<GLenum>& buffers);
+
+  /**
+   * @brief Checks that the framebuffer can be rendered to
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @throws GL::Exception with the reason if the framebuffer is incomplete
+   */
+  void check() const;
+
+  /**
+   * @brief Copies a region of this framebuffer to another
+   *
+   * Leaves the default framebuffer bound afterwards.
+   *
+   * @param destination the framebuffer to copy to (`nullptr` for the default framebuffer)
+   * @param width the width of both regions
+   * @param height the height of both regions
+   * @param mask which buffers to copy (e.g. GL_COLOR_BUFFER_BIT)
+   * @param filter the filter for when the regions differ in size (GL_NEAREST for depth)
+   */
+  void blit_to(const Framebuffer* destination, int width, int height, GLbitfield mask,
+               GLenum filter) const;
+
+  /**
+   * @brief Resolves the multisampled color of this framebuffer into another
+   *
+   * Leaves the default framebuffer bound afterwards.
+   *
+   * @param destination the single sampled framebuffer (`nullptr` for the default framebuffer)
+   * @param width the width of both framebuffers (must be the same for a resolve)
+   * @param height the height of both framebuffers
+   */
+  void resolve_to(const Framebuffer* destination, int width, int height) const;
+
+  /**
+   * @brief Tells OpenGL the contents of some attachments are no longer needed
+   *
+   * Call at the end of a pass for anything that won't be read again (e.g.
+   * depth, or multisampled color after it has been resolved) so it isn't
+   * written back to memory. This is only a hint, so it does nothing where
+   * `glInvalidateFramebuffer` isn't available.
+   *
+   * Note: Must call `bind()` first!
+   *
+   * @param attachments the attachment points to invalidate
+   */
+  void invalidate(const std::vector<GLenum>& attachments);
+
+  /**
+   * @brief Gets the id assigned by OpenGL for this framebuffer
+   *
+   * @return GLuint representing the id
+   */
+  GLuint id() const { return id_; }
+
+private:
+  /**
+   * @brief Destroys the framebuffer
+   */
+  void destroy();
+
+  /// The ID of underlying framebuffer object
+  GLuint id_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_FRAMEBUFFER_H)
@@ -0,0 +1,110 @@
+//
+// frustum_culler.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_FRUSTUM_CULLER_H
+#define BGL_FRUSTUM_CULLER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/fwd.hpp>
+
+namespace BarelyGL {
+/**
+ * @class FrustumCuller
+ * @brief Tests large numbers of bounding volumes against the view frustum
+ *
+ * Bounds are stored as structure-of-arrays so that several objects are
+ * tested per instruction (8 with AVX2, 4 with SSE2 or NEON). On x86 the
+ * widest kernel the CPU supports is picked at runtime. Each object has an
+ * AABB and the bounding sphere around it; an object is visible if both are
+ * at least partly inside all six planes. Large sets are split across threads.
+ *
+ * The result is a list of object indices, in order, to draw with
+ * `VertexArrayObject::draw` or `BufferArena::draw`.
+ */
+class FrustumCuller
+{
+public:
+  /**
+   * @brief Creates an empty culler
+   *
+   * @param thread_count the most threads to use (0 uses one per core)
+   */
+  FrustumCuller(size_t thread_count = 0);
+
+  /**
+   * @brief Adds an object bounded by an axis-aligned box
+   *
+   * @param min the minimum corner of the box
+   * @param max the maximum corner of the box
+   *
+   * @return the index of the object
+   */
+  uint32_t add(const glm::vec3& min, const glm::vec3& max);
+
+  /**
+   * @brief Adds an object bounded by a sphere
+   *
+   * @param center the center of the sphere
+   * @param radius the radius of the sphere
+   *
+   * @return the index of the object
+   */
+  uint32_t add_sphere(const glm::vec3& center, float radius);
+
+  /**
+   * @brief Changes the bounds of an object (when it moves)
+   *
+   * @param index the index of the object
+   * @param min the minimum corner of the box
+   * @param max the maximum corner of the box
+   */
+  void set_bounds(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+
+  /**
+   * @brief Removes every object
+   */
+  void clear();
+
+  /**
+   * @brief Gets the number of objects
+   */
+  size_t size() const { return radius_.size(); }
+
+  /**
+   * @brief Finds the objects inside the frustum of a view-projection matrix
+   *
+   * @param view_projection the combined view and projection matrix
+   * @param visible filled with the indices of the visible objects, in order
+   */
+  void cull(const glm::mat4& view_projection, std::vector<uint32_t>& visible) const;
+
+private:
+  /**
+   * @brief Tests the objects in [first, last) against the planes
+   *
+   * @param planes the frustum planes as (a, b, c, d) with normals pointing in
+   * @param first the first object to test
+   * @param last one past the last object to test
+   * @param visible the visible objects are appended to this
+   */
+  void cull_range(const float* planes, size_t first, size_t last,
+                  std::vector<uint32_t>& visible) const;
+
+  /// The most threads to use
+  size_t thread_count_;
+  /// Box minimum corners
+  std::vector<float> min_x_, min_y_, min_z_;
+  /// Box maximum corners
+  std::vector<float> max_x_, max_y_, max_z_;
+  /// Sphere centers
+  std::vector<float> center_x_, center_y_, center_z_;
+  /// Sphere radii
+  std::vector<float> radius_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_FRUSTUM_CULLER_H)
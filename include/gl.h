@@ -13,6 +13,35 @@
 #include "vertex_buffer_object.h"
 #include "index_buffer_object.h"
 #include "vertex_attribute_array.h"
+#include "handle_pool.h"
+#include "buffer_arena.h"
+#include "mesh_optimizer.h"
+#include "vertex_welder.h"
+#include "frustum_culler.h"
+#include "lod_generator.h"
+#include "sprite_batch.h"
+#include "glyph_cache.h"
+#include "capabilities.h"
+#include "renderbuffer.h"
+#include "framebuffer.h"
+#include "render_target.h"
+#include "render_target_pool.h"
+#include "readback_queue.h"
+#include "occlusion_culler.h"
+#include "texture_units.h"
+#include "sampler.h"
+#include "sampler_cache.h"
+#include "mipmap_generator.h"
+#include "pixel_converter.h"
+#include "shader_storage_buffer.h"
+#include "fence.h"
+#include "frame_pacer.h"
+#include "memory_tracker.h"
+#include "texture_residency.h"
+#include "mesh_file.h"
+#include "vertex_array_cache.h"
+#include "stripifier.h"
+#include "static_batcher.h"
 #include "exception.h"
 
 #endif // defined(BGL_GL_H)
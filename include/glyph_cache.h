@@ -0,0 +1,214 @@
+//
+// glyph_cache.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_GLYPH_CACHE_H
+#define BGL_GLYPH_CACHE_H
+
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+#include "texture.h"
+
+namespace BarelyGL {
+class SpriteBatch;
+
+/**
+ * @struct GlyphBitmap
+ * @brief A rasterized glyph, as produced by a `GlyphCache::Rasterizer`
+ */
+struct GlyphBitmap
+{
+  /// The size of the bitmap in pixels
+  int width = 0, height = 0;
+  /// The offset from the pen position to the top left of the bitmap
+  int bearing_x = 0, bearing_y = 0;
+  /// How far to move the pen after drawing the glyph
+  float advance = 0.0f;
+  /// 8-bit coverage values, `width * height` of them, top row first
+  std::vector<uint8_t> pixels;
+};
+
+/**
+ * @class GlyphCache
+ * @brief Rasterizes glyphs on demand into a shared atlas texture
+ *
+ * Glyphs are packed into a single-channel `Texture` with a shelf allocator
+ * (rows of similar height, filled left to right). When the atlas is full the
+ * least recently used glyphs are evicted to make room. The rasterizer is
+ * supplied by the caller, so any font library can be plugged in.
+ *
+ * Text is drawn through a `SpriteBatch` using the atlas, so all of the text
+ * in a frame ends up in one vertex buffer and one draw. Coordinates are in
+ * pixels with y growing downwards, and the atlas only has a red channel, so
+ * the batch's shader should use it as coverage.
+ */
+class GlyphCache
+{
+public:
+  /**
+   * @brief Rasterizes a codepoint, returning false if the font doesn't have it
+   */
+  typedef std::function<bool(uint32_t codepoint, GlyphBitmap& glyph)> Rasterizer;
+
+  /**
+   * @struct Glyph
+   * @brief Where a cached glyph lives in the atlas and how to place it
+   */
+  struct Glyph
+  {
+    /// The position of the glyph in the atlas, in pixels
+    int x, y;
+    /// The size of the glyph, in pixels
+    int width, height;
+    /// The offset from the pen position to the top left of the glyph
+    int bearing_x, bearing_y;
+    /// How far to move the pen after drawing the glyph
+    float advance;
+  };
+
+  /**
+   * @brief Creates the atlas texture
+   *
+   * @param rasterizer the function used to rasterize glyphs
+   * @param line_height the distance between lines of text, in pixels
+   * @param width the width of the atlas
+   * @param height the height of the atlas
+   *
+   * @throws GL::Exception if the texture fails to be constructed
+   */
+  GlyphCache(Rasterizer rasterizer, float line_height, int width = 1024, int height = 1024);
+
+  /**
+   * @brief Gets a glyph, rasterizing it if it isn't cached
+   *
+   * Note: This may evict any other glyph, including ones already added to a
+   * batch that hasn't been flushed. `draw_text` takes care of that.
+   *
+   * @param codepoint the unicode codepoint of the glyph
+   *
+   * @return the glyph, or nullptr if the rasterizer doesn't have it
+   *
+   * @throws GL::Exception if the glyph is too big to fit in the atlas
+   */
+  const Glyph* get(uint32_t codepoint);
+
+  /**
+   * @brief Adds a string of text to a sprite batch
+   *
+   * If a glyph in the batch has to be evicted, the batch is flushed first.
+   *
+   * @param batch the batch to add the glyphs to
+   * @param text the UTF-8 text to draw (\n starts a new line)
+   * @param x the x position of the pen at the start of the first line
+   * @param y the y position of the baseline of the first line
+   * @param scale the scale to draw the glyphs at
+   * @param r the red component of the text color
+   * @param g the green component of the text color
+   * @param b the blue component of the text color
+   * @param a the alpha component of the text color
+   *
+   * @return the x position of the pen after the text
+   */
+  float draw_text(SpriteBatch& batch, const std::string& text, float x, float y,
+                  float scale = 1.0f, float r = 1.0f, float g = 1.0f, float b = 1.0f,
+                  float a = 1.0f);
+
+  /**
+   * @brief Gets the atlas texture
+   */
+  const Texture& texture() const { return texture_; }
+
+  /**
+   * @brief Gets the number of glyphs in the cache
+   */
+  size_t size() const { return glyphs_.size(); }
+
+  /**
+   * @brief Gets the number of glyphs evicted since the cache was created
+   */
+  size_t evictions() const { return evictions_; }
+
+private:
+  /**
+   * @struct Shelf
+   * @brief A row of the atlas
+   */
+  struct Shelf
+  {
+    /// The top of the shelf
+    int y;
+    /// The height of the shelf
+    int height;
+    /// The end of the used part of the shelf
+    int used;
+    /// Gaps left by evicted glyphs, as (x, width)
+    std::vector<std::pair<int, int>> gaps;
+  };
+
+  /**
+   * @struct Entry
+   * @brief A cached glyph and its book-keeping
+   */
+  struct Entry
+  {
+    /// The glyph
+    Glyph glyph;
+    /// The shelf the glyph is on (-1 for empty glyphs, like spaces)
+    int shelf;
+    /// The glyph's position in the LRU list
+    std::list<uint32_t>::iterator lru;
+    /// The `SpriteBatch::generation()` the glyph was last added in
+    uint64_t generation;
+  };
+
+  /**
+   * @brief Looks up or rasterizes a glyph, flushing `batch` before evicting
+   *        anything it uses (if a batch is given)
+   */
+  Entry* find(uint32_t codepoint, SpriteBatch* batch);
+
+  /**
+   * @brief Finds space for a glyph, returning the shelf index or -1
+   */
+  int allocate(int width, int height, int& x, int& y);
+
+  /**
+   * @brief Returns a glyph's space to its shelf
+   */
+  void release(const Entry& entry);
+
+  /**
+   * @brief Evicts the least recently used glyph
+   *
+   * @return false if there was nothing to evict
+   */
+  bool evict_one(SpriteBatch* batch);
+
+  /// The function used to rasterize glyphs
+  Rasterizer rasterizer_;
+  /// The distance between lines of text
+  float line_height_;
+  /// The atlas
+  Texture texture_;
+  /// The rows of the atlas, top to bottom
+  std::vector<Shelf> shelves_;
+  /// The top of the unused space below the last shelf
+  int next_shelf_y_ = 0;
+  /// The cached glyphs, by codepoint
+  std::unordered_map<uint32_t, Entry> glyphs_;
+  /// Codepoints the rasterizer doesn't have
+  std::unordered_set<uint32_t> missing_;
+  /// Cached codepoints, most recently used first
+  std::list<uint32_t> lru_;
+  /// The number of glyphs evicted
+  size_t evictions_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_GLYPH_CACHE_H)
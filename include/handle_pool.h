@@ -0,0 +1,164 @@
+//
+// handle_pool.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_HANDLE_POOL_H
+#define BGL_HANDLE_POOL_H
+
+#include <vector>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class HandlePool
+ * @brief Reserves OpenGL object names in batches and recycles them
+ *
+ * Rather than calling `glGen*` once per object, the pool generates
+ * `batch_size` names at a time and hands them out one by one. Released names
+ * go back on the free list for the next wrapper that needs one.
+ *
+ * Note: A recycled name still refers to the object it named before, so any
+ * data store it had is kept until the next owner respecifies it (all of the
+ * wrappers do this before use). Call `trim()` to actually delete free names.
+ * Objects with immutable storage can't be respecified, so they must be
+ * deleted rather than released back to the pool. Vertex array names are only
+ * generated in batches; released ones are deleted, since their stale state
+ * would leak into the next owner.
+ */
+class HandlePool
+{
+public:
+  /**
+   * @brief The kind of OpenGL object the pool generates names for
+   */
+  enum class Type
+  {
+    Buffer,
+    Texture,
+    VertexArray,
+    Renderbuffer,
+    Query
+  };
+
+  /**
+   * @brief Creates an empty pool (no names are generated until needed)
+   *
+   * @param type the kind of object to generate names for
+   * @param batch_size how many names to generate with each `glGen*` call
+   * @param texture_target the target texture names are created for with
+   *                       direct state access (0 for GL_TEXTURE_2D)
+   */
+  HandlePool(Type type, size_t batch_size = 64, GLenum texture_target = 0);
+
+  // Names are owned by the pool, so it must not be copied
+  HandlePool(const HandlePool&) = delete;
+  HandlePool& operator=(const HandlePool&) = delete;
+
+  /**
+   * @brief The shared pool of buffer names
+   */
+  static HandlePool& buffers();
+
+  /**
+   * @brief The shared pool of texture names
+   */
+  static HandlePool& textures();
+
+  /**
+   * @brief The shared pool of texture names for a target
+   *
+   * A texture name is tied to the first target it is bound to, so each target
+   * needs its own pool.
+   *
+   * @param target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_3D
+   *
+   * @throws GL::Exception if the target has no pool
+   */
+  static HandlePool& textures(GLenum target);
+
+  /**
+   * @brief The shared pool of vertex array names
+   */
+  static HandlePool& vertex_arrays();
+
+  /**
+   * @brief The shared pool of renderbuffer names
+   */
+  static HandlePool& renderbuffers();
+
+  /**
+   * @brief The shared pool of query names
+   */
+  static HandlePool& queries();
+
+  /**
+   * @brief Takes a name from the pool, generating a new batch if it is empty
+   *
+   * @return a name suitable for binding
+   *
+   * @throws GL::Exception if no names could be generated
+   */
+  GLuint acquire();
+
+  /**
+   * @brief Returns a name to the pool so it can be handed out again
+   *
+   * If the free list grows past four batches, the surplus is deleted with a
+   * single `glDelete*` call. Vertex array names are deleted immediately.
+   *
+   * @param id the name to return (0 is ignored)
+   */
+  void release(GLuint id);
+
+  /**
+   * @brief Makes sure at least `count` names are free, in one `glGen*` call
+   *
+   * Useful before a level load that is about to create many objects.
+   *
+   * @param count the number of free names required
+   */
+  void reserve(size_t count);
+
+  /**
+   * @brief Deletes every free name in the pool
+   */
+  void trim();
+
+  /**
+   * @brief Sets how many names are generated at a time
+   *
+   * @param batch_size the new batch size (at least 1)
+   */
+  void set_batch_size(size_t batch_size) { batch_size_ = batch_size > 0 ? batch_size : 1; }
+
+  /**
+   * @brief Gets the number of names ready to be handed out
+   *
+   * @return the number of free names
+   */
+  size_t available() const { return free_.size(); }
+
+private:
+  /**
+   * @brief Generates `count` new names onto the free list
+   */
+  void generate(size_t count);
+
+  /**
+   * @brief Deletes `count` names from the end of the free list
+   */
+  void destroy(size_t count);
+
+  /// The kind of object the names are for
+  Type type_;
+  /// The target texture names are created for
+  GLenum texture_target_;
+  /// The number of names generated per `glGen*` call
+  size_t batch_size_;
+  /// The names ready to be handed out
+  std::vector<GLuint> free_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_HANDLE_POOL_H)
@@ -29,6 +29,24 @@ public:
   IndexBufferObject(GLenum target, GLenum usage);
   ~IndexBufferObject();
 
+  /**
+   * @brief Takes ownership of another IBO's underlying buffer
+   *
+   * @param other the IBO to move from (left without a buffer)
+   */
+  IndexBufferObject(IndexBufferObject&& other) noexcept;
+
+  /**
+   * @brief Destroys the current buffer and takes ownership of another IBO's
+   *
+   * @param other the IBO to move from (left without a buffer)
+   */
+  IndexBufferObject& operator=(IndexBufferObject&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  IndexBufferObject(const IndexBufferObject&) = delete;
+  IndexBufferObject& operator=(const IndexBufferObject&) = delete;
+
   /**
    * @brief Binds the buffer
    */
@@ -44,14 +62,105 @@ public:
    *
    * @returns the number of indices
    */
-  size_t size() const { return indices_.size(); }
+  size_t size() const { return index_count_; }
+
+  /**
+   * @brief Initialize the buffer data store without uploading any data
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param count the number of indices to allocate space for
+   *
+   * @throws GL::Exception if the buffer has immutable storage
+   */
+  void init_buffer(GLsizeiptr count);
+
+  /**
+   * @brief Set the indices for the buffer, recreating the data store
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param indices array of ints to be used as indices
+   *
+   * @throws GL::Exception if the buffer has immutable storage
+   */
+  void set_indices(const std::vector<int>& indices);
+
+  /**
+   * @brief Set the indices for the buffer from memory it doesn't own, recreating the data store
+   *
+   * Useful for uploading straight from a memory-mapped file.
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param indices pointer to the first index
+   * @param count the number of indices
+   *
+   * @throws GL::Exception if the buffer has immutable storage
+   */
+  void set_indices(const int* indices, size_t count);
+
+  /**
+   * @brief Set the indices for the buffer in a data store that can't be resized
+   *
+   * With direct state access this allocates immutable storage, after which
+   * only `sub_indices` can change the contents. Otherwise it is the same as
+   * `set_indices`.
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param indices array of ints to be used as indices
+   *
+   * @throws GL::Exception if the buffer already has immutable storage
+   */
+  void set_storage(const std::vector<int>& indices);
+
+  /**
+   * @brief Set the indices from memory it doesn't own, in a data store that can't be resized
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param indices pointer to the first index
+   * @param count the number of indices
+   *
+   * @throws GL::Exception if the buffer already has immutable storage
+   */
+  void set_storage(const int* indices, size_t count);
+
+  /**
+   * @brief Set the indices for part of the buffer, replacing data in the store
+   *
+   * Note: Unlike `set_indices`, this does not change `size()`. Must call
+   * `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param indices array of ints to be used as indices
+   * @param offset the offset into the buffer (in indices, not bytes)
+   */
+  void sub_indices(const std::vector<int>& indices, GLintptr offset = 0);
 
   /**
-   * @brief Set the vertices for the buffer
+   * @brief Sets whether the indices contain `Stripifier::restart_index`
+   *
+   * `VertexArrayObject::draw` enables primitive restart for such buffers.
    *
-   * @param vertices array of floats to be used as vertices
+   * @param enabled whether restarting at 0xFFFFFFFF is needed
+   */
+  void set_primitive_restart(bool enabled) { primitive_restart_ = enabled; }
+
+  /**
+   * @brief Whether the indices contain `Stripifier::restart_index`
+   */
+  bool primitive_restart() const { return primitive_restart_; }
+
+  /**
+   * @brief Gets the size of the data store in bytes
    */
-  void set_indices(const std::vector<int> indices);
+  size_t byte_size() const { return byte_size_; }
+
+  /**
+   * @brief The ID of the underlying OpenGL object
+   */
+  GLuint id() const { return id_; }
 
 private:
   /**
@@ -59,6 +168,14 @@ private:
    */
   void generate_buffer();
 
+  /**
+   * @brief Recreates the (mutable) data store
+   *
+   * @param size the size of the data store in bytes
+   * @param data the data to fill it with (or `nullptr`)
+   */
+  void set_data(GLsizeiptr size, const void* data);
+
   /**
    * @brief Destroy the buffer
    */
@@ -70,8 +187,14 @@ private:
   GLenum target_;
   /// The usage partter of the buffer
   GLenum usage_;
-  /// The list of vertices
-  std::vector<int> indices_;
+  /// The number of indices in the buffer
+  size_t index_count_ = 0;
+  /// Whether the buffer has immutable storage (and so can't go back to the pool)
+  bool immutable_ = false;
+  /// The size of the data store in bytes
+  size_t byte_size_ = 0;
+  /// Whether the indices need primitive restart
+  bool primitive_restart_ = false;
 };
 }
 
@@ -0,0 +1,155 @@
+//
+// lod_generator.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_LOD_GENERATOR_H
+#define BGL_LOD_GENERATOR_H
+
+#include <vector>
+#include <cstddef>
+#include <OpenGL/gltypes.h>
+#include "vertex_attribute_array.h"
+#include "index_buffer_object.h"
+
+namespace BarelyGL {
+/**
+ * @class LodChain
+ * @brief A mesh's levels of detail, all indexing the same vertex buffer
+ *
+ * Level 0 is the original mesh and each level after it is coarser. Each
+ * level records the geometric error it introduces (in the units of the
+ * vertex positions), which is what `select` projects onto the screen.
+ */
+class LodChain
+{
+public:
+  /**
+   * @brief Adds a coarser level to the end of the chain
+   *
+   * @param indices the triangle list of the level
+   * @param error the geometric error of the level
+   */
+  void add_level(std::vector<int> indices, float error);
+
+  /**
+   * @brief Uploads every level into its own IBO
+   *
+   * Note: Binds GL_ELEMENT_ARRAY_BUFFER, so call with no VAO bound
+   *
+   * @param usage usage pattern of the buffers (usually GL_STATIC_DRAW)
+   */
+  void upload(GLenum usage);
+
+  /**
+   * @brief Picks the coarsest level that looks the same at a distance
+   *
+   * @param distance the distance from the camera to the mesh
+   * @param screen_height the height of the viewport in pixels
+   * @param fov_y the vertical field of view in radians
+   * @param max_pixel_error the most error allowed on screen, in pixels
+   *
+   * @return the index of the level to draw
+   */
+  size_t select(float distance, float screen_height, float fov_y,
+                float max_pixel_error = 1.0f) const;
+
+  /**
+   * @brief Gets the number of levels
+   */
+  size_t size() const { return levels_.size(); }
+
+  /**
+   * @brief Gets the triangle list of a level
+   */
+  const std::vector<int>& indices(size_t level) const { return levels_[level].indices; }
+
+  /**
+   * @brief Gets the geometric error of a level
+   */
+  float error(size_t level) const { return levels_[level].error; }
+
+  /**
+   * @brief Gets the IBO of a level (only valid after `upload`)
+   */
+  const IndexBufferObject& buffer(size_t level) const { return buffers_[level]; }
+
+private:
+  /**
+   * @struct Level
+   * @brief A single level of detail
+   */
+  struct Level
+  {
+    /// The triangle list
+    std::vector<int> indices;
+    /// The geometric error
+    float error;
+  };
+
+  /// The levels, finest first
+  std::vector<Level> levels_;
+  /// One IBO per level, once uploaded
+  std::vector<IndexBufferObject> buffers_;
+};
+
+/**
+ * @class LodGenerator
+ * @brief Simplifies meshes with quadric error edge collapse
+ *
+ * Edges are collapsed onto one of their existing vertices (rather than an
+ * optimal new position), so every level indexes the original vertex data
+ * and the chain can share the mesh's VBO. Positions are read from the first
+ * attribute. Vertices on open borders and on attribute seams (several
+ * vertices at the same position) are never moved, so the outline and UV
+ * layout of the mesh survive.
+ */
+class LodGenerator
+{
+public:
+  /**
+   * @brief Prepares to simplify meshes using some vertex data
+   *
+   * @param vertices the vertex data shared by every level
+   * @param attributes the attributes describing the vertex data
+   */
+  LodGenerator(const std::vector<float>& vertices, const VertexAttributeArray& attributes);
+
+  /**
+   * @brief Simplifies a triangle list
+   *
+   * @param indices the triangle list to simplify
+   * @param target_index_count the number of indices to aim for (the result
+   *                           may be larger if nothing else can collapse)
+   * @param error set to the geometric error of the result
+   *
+   * @return the simplified triangle list
+   */
+  std::vector<int> simplify(const std::vector<int>& indices, size_t target_index_count,
+                            float& error) const;
+
+  /**
+   * @brief Generates a chain of levels, each about `ratio` the size of the last
+   *
+   * Stops early once a level fails to get meaningfully smaller.
+   *
+   * @param indices the triangle list of the full detail mesh
+   * @param max_levels the most levels to generate (including the original)
+   * @param ratio the fraction of indices each level keeps from the last
+   *
+   * @return the chain of levels
+   */
+  LodChain generate(const std::vector<int>& indices, size_t max_levels = 4,
+                    float ratio = 0.5f) const;
+
+private:
+  /// The positions of the vertices (x, y, z)
+  std::vector<float> positions_;
+  /// For each vertex, the first vertex with the same position
+  std::vector<int> position_group_;
+  /// Whether more than one vertex shares each vertex's position
+  std::vector<bool> seam_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_LOD_GENERATOR_H)
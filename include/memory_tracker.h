@@ -0,0 +1,102 @@
+//
+// memory_tracker.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_MEMORY_TRACKER_H
+#define BGL_MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class MemoryTracker
+ * @brief Totals the GPU memory held by the wrappers, by category
+ *
+ * Every wrapper with a data store reports its size here when the store is
+ * (re)specified and when it is destroyed, and exposes it as `byte_size()`.
+ * The numbers are estimates of what was asked for: drivers pad and align
+ * allocations, and names released back to a `HandlePool` keep their old data
+ * store until reused or trimmed (which isn't counted).
+ */
+class MemoryTracker
+{
+public:
+  /**
+   * @brief The kinds of object memory is counted for
+   */
+  enum class Category
+  {
+    VertexBuffers,
+    IndexBuffers,
+    StorageBuffers,
+    Textures,
+    Renderbuffers,
+    PixelBuffers
+  };
+
+  /// The number of categories
+  static const size_t category_count = 6;
+
+  /**
+   * @brief Gets the shared tracker
+   */
+  static MemoryTracker& get();
+
+  MemoryTracker() = default;
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  /**
+   * @brief Replaces an object's old size with its new size
+   *
+   * @param category the kind of object
+   * @param old_size the size the object was counted as (0 if new)
+   * @param new_size the size of the object now (0 if destroyed)
+   */
+  void resize(Category category, size_t old_size, size_t new_size);
+
+  /**
+   * @brief Gets the bytes held by one kind of object
+   */
+  size_t bytes(Category category) const { return bytes_[static_cast<size_t>(category)]; }
+
+  /**
+   * @brief Gets the number of objects of one kind with a data store
+   */
+  size_t objects(Category category) const { return objects_[static_cast<size_t>(category)]; }
+
+  /**
+   * @brief Gets the bytes held by every kind of object
+   */
+  size_t total_bytes() const;
+
+  /**
+   * @brief Gets the highest `total_bytes()` has been
+   */
+  size_t peak_bytes() const { return peak_; }
+
+  /**
+   * @brief Estimates the bytes per texel of an internal format
+   *
+   * Three component formats are counted as four, since that is how drivers
+   * store them.
+   *
+   * @param internal_format a sized or unsized internal format (e.g. GL_RGBA8)
+   *
+   * @return the bytes per texel (4 for formats it doesn't know)
+   */
+  static size_t texel_size(GLenum internal_format);
+
+private:
+  /// The bytes held by each category
+  size_t bytes_[category_count] = {};
+  /// The number of objects with a data store in each category
+  size_t objects_[category_count] = {};
+  /// The most bytes held at once
+  size_t peak_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_MEMORY_TRACKER_H)
@@ -0,0 +1,189 @@
+//
+// mesh_file.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_MESH_FILE_H
+#define BGL_MESH_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vertex_attribute_array.h"
+
+namespace BarelyGL {
+class VertexBufferObject;
+class IndexBufferObject;
+
+/**
+ * @struct MeshSubmesh
+ * @brief A range of a mesh's indices drawn on its own (e.g. with one material)
+ */
+struct MeshSubmesh
+{
+  /// The first index of the range
+  uint32_t first_index;
+  /// The number of indices in the range
+  uint32_t index_count;
+  /// The minimum corner of the range's bounding box
+  float min[3];
+  /// The maximum corner of the range's bounding box
+  float max[3];
+};
+
+/**
+ * @class MeshFile
+ * @brief A precooked mesh, memory-mapped so it can be uploaded without parsing
+ *
+ * The file is a fixed header followed by three blobs, each aligned to 64
+ * bytes: the interleaved float vertices, the int indices and the submeshes.
+ * The header holds the vertex layout (the size of each attribute) and where
+ * each blob starts. Everything is in native byte order, so files are cooked
+ * for the platform they are loaded on.
+ *
+ * Loading only maps the file and checks the header; `vertices()` and
+ * `indices()` point straight into the mapping, and `upload()` hands those
+ * pointers to OpenGL. Indices are trusted, so only load files this library
+ * wrote.
+ */
+class MeshFile
+{
+public:
+  /**
+   * @brief Maps a mesh file into memory
+   *
+   * @param file_path path to the mesh file
+   *
+   * @throws GL::Exception if the file can't be mapped or isn't a valid mesh file
+   */
+  explicit MeshFile(const std::string& file_path);
+  ~MeshFile();
+
+  /**
+   * @brief Takes ownership of another file's mapping
+   *
+   * @param other the file to move from (left unmapped)
+   */
+  MeshFile(MeshFile&& other) noexcept;
+
+  /**
+   * @brief Unmaps the current file and takes ownership of another file's mapping
+   *
+   * @param other the file to move from (left unmapped)
+   */
+  MeshFile& operator=(MeshFile&& other) noexcept;
+
+  // Copying would leave two wrappers unmapping the same memory
+  MeshFile(const MeshFile&) = delete;
+  MeshFile& operator=(const MeshFile&) = delete;
+
+  /**
+   * @brief Writes a mesh to a file in the format `MeshFile` maps
+   *
+   * @param file_path path to write to (replaced if it exists)
+   * @param attributes the attributes describing the vertex data
+   * @param vertices the interleaved vertex data
+   * @param indices the triangle indices
+   * @param submeshes the ranges of indices (if empty, one range covering every index)
+   *
+   * @throws GL::Exception if the layout isn't supported or the file can't be written
+   */
+  static void write(const std::string& file_path, const VertexAttributeArray& attributes,
+                    const std::vector<float>& vertices, const std::vector<int>& indices,
+                    const std::vector<MeshSubmesh>& submeshes = {});
+
+  /**
+   * @brief Describes a range of indices, with a bounding box around the positions it uses
+   *
+   * The first attribute is taken to be the position (at least three values).
+   *
+   * @param attributes the attributes describing the vertex data
+   * @param vertices the interleaved vertex data
+   * @param indices the triangle indices
+   * @param first_index the first index of the range
+   * @param index_count the number of indices in the range
+   *
+   * @return the submesh
+   */
+  static MeshSubmesh make_submesh(const VertexAttributeArray& attributes,
+                                  const std::vector<float>& vertices,
+                                  const std::vector<int>& indices, uint32_t first_index,
+                                  uint32_t index_count);
+
+  /**
+   * @brief Uploads the vertices and indices straight from the mapping
+   *
+   * Uses immutable storage where available, since cooked meshes are static.
+   *
+   * Note: Must call `bind()` on both buffers first, unless
+   * `Capabilities::direct_state_access()`
+   *
+   * @param vertex_buffer the VBO to upload the vertices to
+   * @param index_buffer the IBO to upload the indices to
+   */
+  void upload(VertexBufferObject& vertex_buffer, IndexBufferObject& index_buffer) const;
+
+  /**
+   * @brief Gets the attributes describing the vertex data
+   */
+  const VertexAttributeArray& attributes() const { return attributes_; }
+
+  /**
+   * @brief Gets the interleaved vertex data (inside the mapping)
+   */
+  const float* vertices() const { return vertices_; }
+
+  /**
+   * @brief Gets the number of vertices
+   */
+  size_t vertex_count() const { return vertex_count_; }
+
+  /**
+   * @brief Gets the indices (inside the mapping)
+   */
+  const int* indices() const { return indices_; }
+
+  /**
+   * @brief Gets the number of indices
+   */
+  size_t index_count() const { return index_count_; }
+
+  /**
+   * @brief Gets the submeshes (inside the mapping)
+   */
+  const MeshSubmesh* submeshes() const { return submeshes_; }
+
+  /**
+   * @brief Gets the number of submeshes
+   */
+  size_t submesh_count() const { return submesh_count_; }
+
+private:
+  /**
+   * @brief Unmaps the file
+   */
+  void destroy();
+
+  /// The start of the mapping (or `nullptr`)
+  void* mapping_ = nullptr;
+  /// The size of the mapping in bytes
+  size_t mapping_size_ = 0;
+  /// The attributes describing the vertex data
+  VertexAttributeArray attributes_;
+  /// The vertex data
+  const float* vertices_ = nullptr;
+  /// The number of vertices
+  size_t vertex_count_ = 0;
+  /// The indices
+  const int* indices_ = nullptr;
+  /// The number of indices
+  size_t index_count_ = 0;
+  /// The submeshes
+  const MeshSubmesh* submeshes_ = nullptr;
+  /// The number of submeshes
+  size_t submesh_count_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_MESH_FILE_H)
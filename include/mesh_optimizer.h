@@ -0,0 +1,133 @@
+//
+// mesh_optimizer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_MESH_OPTIMIZER_H
+#define BGL_MESH_OPTIMIZER_H
+
+#include <vector>
+#include <cstddef>
+#include "vertex_attribute_array.h"
+
+namespace BarelyGL {
+/**
+ * @class MeshOptimizer
+ * @brief Reorders mesh data for the GPU's vertex caches before it is uploaded
+ *
+ * This is an optional step between loading a mesh and calling
+ * `VertexBufferObject::set_vertices` / `IndexBufferObject::set_indices`. The
+ * stages are, in the order `optimize` runs them:
+ *    1. Triangle reordering for the post-transform cache (Forsyth)
+ *    2. Cluster reordering to reduce overdraw (Sander et al, "Tipsify")
+ *    3. Vertex reordering to match the index order for the pre-transform
+ *       (vertex fetch) cache
+ *
+ * Positions are read from the first attribute of the vertex data.
+ */
+class MeshOptimizer
+{
+public:
+  /**
+   * @struct CacheStats
+   * @brief Post-transform cache efficiency of an index buffer
+   */
+  struct CacheStats
+  {
+    /// Average cache miss ratio (transformed vertices per triangle, 0.5 - 3)
+    float acmr;
+    /// Average transformed to vertex ratio (1 is optimal)
+    float atvr;
+  };
+
+  /**
+   * @struct Report
+   * @brief Cache efficiency before and after optimization
+   */
+  struct Report
+  {
+    /// Statistics of the indices as given
+    CacheStats before;
+    /// Statistics of the optimized indices
+    CacheStats after;
+  };
+
+  /**
+   * @brief Creates an optimizer
+   *
+   * @param cache_size the size of the FIFO cache used when measuring (most
+   *                   hardware is somewhere between 16 and 32)
+   * @param overdraw_threshold how much worse than the cache-optimized ACMR
+   *                           the overdraw stage is allowed to make it (1.05
+   *                           allows 5%)
+   */
+  MeshOptimizer(size_t cache_size = 16, float overdraw_threshold = 1.05f);
+
+  /**
+   * @brief Runs every stage on a triangle list
+   *
+   * @param vertices the vertex data, rewritten in fetch order (unreferenced
+   *                 vertices are removed)
+   * @param attributes the attributes describing the vertex data
+   * @param indices the triangle list, rewritten in optimized order
+   *
+   * @return the cache statistics before and after
+   */
+  Report optimize(std::vector<float>& vertices, const VertexAttributeArray& attributes,
+                  std::vector<int>& indices) const;
+
+  /**
+   * @brief Reorders triangles to make the most of the post-transform cache
+   *
+   * @param indices the triangle list to reorder
+   * @param vertex_count the number of vertices the indices refer to
+   *
+   * @throws GL::Exception if an index is out of range of the vertices
+   */
+  void optimize_vertex_cache(std::vector<int>& indices, size_t vertex_count) const;
+
+  /**
+   * @brief Reorders clusters of triangles so outer surfaces are drawn first
+   *
+   * Should be run on the output of `optimize_vertex_cache`, as clusters are
+   * only split where it doesn't undo the cache optimization.
+   *
+   * @param indices the triangle list to reorder
+   * @param vertices the vertex data
+   * @param attributes the attributes describing the vertex data
+   */
+  void optimize_overdraw(std::vector<int>& indices, const std::vector<float>& vertices,
+                         const VertexAttributeArray& attributes) const;
+
+  /**
+   * @brief Reorders vertices in the order the indices first use them
+   *
+   * @param vertices the vertex data to reorder (unreferenced vertices are
+   *                 removed)
+   * @param attributes the attributes describing the vertex data
+   * @param indices the indices, remapped to the new vertex order
+   */
+  void optimize_vertex_fetch(std::vector<float>& vertices, const VertexAttributeArray& attributes,
+                             std::vector<int>& indices) const;
+
+  /**
+   * @brief Measures how well a triangle list uses a FIFO vertex cache
+   *
+   * @param indices the triangle list to measure
+   * @param vertex_count the number of vertices the indices refer to
+   *
+   * @return the cache statistics
+   *
+   * @throws GL::Exception if an index is out of range of the vertices
+   */
+  CacheStats analyze(const std::vector<int>& indices, size_t vertex_count) const;
+
+private:
+  /// The size of the simulated FIFO cache
+  size_t cache_size_;
+  /// How much the overdraw stage may increase the ACMR
+  float overdraw_threshold_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_MESH_OPTIMIZER_H)
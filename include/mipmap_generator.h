@@ -0,0 +1,111 @@
+//
+// mipmap_generator.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_MIPMAP_GENERATOR_H
+#define BGL_MIPMAP_GENERATOR_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace BarelyGL {
+/**
+ * @class MipmapGenerator
+ * @brief Builds mipmap chains for 8-bit images on the CPU
+ *
+ * Each level is filtered from the one above it in linear float, so nothing
+ * is lost to rounding until each level is converted back to bytes. With
+ * sRGB enabled, color channels are converted to linear light before
+ * filtering (alpha never is), so that averages don't come out too dark.
+ *
+ * Rows of each level are split across threads for large images, and
+ * four-channel images are filtered a pixel at a time with SIMD.
+ */
+class MipmapGenerator
+{
+public:
+  /**
+   * @brief The filter used to halve each level
+   */
+  enum class Filter
+  {
+    /// Averages each 2x2 block (fast, slightly blurry)
+    Box,
+    /// An 8-tap Kaiser-windowed sinc (sharper, may ring slightly at hard edges)
+    Kaiser
+  };
+
+  /**
+   * @brief Creates a generator
+   *
+   * @param filter the filter used to halve each level
+   * @param srgb whether the color channels are sRGB encoded
+   * @param thread_count the most threads to use (0 uses one per core)
+   */
+  MipmapGenerator(Filter filter = Filter::Box, bool srgb = false, size_t thread_count = 0);
+
+  /**
+   * @brief Generates every level below the image, down to 1x1
+   *
+   * Odd sizes are rounded down, so the last row or column of a level only
+   * contributes through the filter's neighbouring taps.
+   *
+   * @param pixels the tightly packed pixels of level 0
+   * @param width the width of level 0
+   * @param height the height of level 0
+   * @param channels the number of 8-bit channels per pixel (1 to 4)
+   *
+   * @return the tightly packed pixels of levels 1 and below, in order
+   *
+   * @throws GL::Exception if the size or channel count is invalid
+   */
+  std::vector<std::vector<uint8_t>> generate(const uint8_t* pixels, int width, int height,
+                                             int channels) const;
+
+  /**
+   * @brief Gets the number of levels in a full chain, including level 0
+   *
+   * @param width the width of level 0
+   * @param height the height of level 0
+   */
+  static int level_count(int width, int height);
+
+private:
+  /**
+   * @brief Halves `source` into `destination` with the box filter
+   */
+  void box(const float* source, int width, int height, int channels, float* destination,
+           int destination_width, int first_row, int last_row) const;
+
+  /**
+   * @brief Filters the rows [first_row, last_row) of `source` horizontally with the Kaiser taps
+   */
+  void kaiser_rows(const float* source, int width, int channels, float* destination,
+                   int destination_width, int first_row, int last_row) const;
+
+  /**
+   * @brief Filters the output rows [first_row, last_row) vertically with the Kaiser taps
+   */
+  void kaiser_columns(const float* source, int height, int width, int channels,
+                      float* destination, int first_row, int last_row) const;
+
+  /**
+   * @brief Calls `function(first_row, last_row)` over `rows`, split across threads if large
+   */
+  template <typename Function>
+  void for_rows(int rows, size_t pixels, Function function) const;
+
+  /// The filter used to halve each level
+  Filter filter_;
+  /// Whether the color channels are sRGB encoded
+  bool srgb_;
+  /// The most threads to use
+  size_t thread_count_;
+  /// The Kaiser filter taps (normalized)
+  float taps_[8];
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_MIPMAP_GENERATOR_H)
@@ -0,0 +1,181 @@
+//
+// occlusion_culler.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_OCCLUSION_CULLER_H
+#define BGL_OCCLUSION_CULLER_H
+
+#include <vector>
+#include <cstdint>
+#include <OpenGL/gltypes.h>
+#include <glm/fwd.hpp>
+#include "shader.h"
+#include "shader_program.h"
+#include "vertex_attribute_array.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "vertex_array_object.h"
+
+namespace BarelyGL {
+/**
+ * @class OcclusionCuller
+ * @brief Skips drawing objects hidden behind others, using occlusion queries
+ *
+ * Each object's bounding box is drawn (without writing color or depth)
+ * inside an occlusion query once the occluders have been drawn. The results
+ * are only read once OpenGL has them, so they are usually a frame old; an
+ * object that comes into view may pop in a frame late, but the CPU never
+ * waits for the GPU.
+ *
+ * There are two ways to use the results:
+ * - `visible()` gives the last result, so hidden objects can be skipped
+ *   entirely (draw calls and all).
+ * - `begin_conditional()` lets the GPU skip the draw itself if the latest
+ *   query says the object is hidden, which catches objects hidden this frame.
+ *
+ * A typical frame is `collect()`, draw the occluders, `issue_queries()`,
+ * then draw everything else checking `visible()` or wrapping the draws in
+ * `begin_conditional()`/`end_conditional()`.
+ */
+class OcclusionCuller
+{
+public:
+  /**
+   * @brief Creates the proxy box and the shader used to draw it
+   *
+   * @param near_plane the distance to the near plane, since boxes closer to
+   *                   the camera than this may be clipped and are always visible
+   *
+   * @throws GL::Exception if the shader or buffers could not be created
+   */
+  explicit OcclusionCuller(float near_plane = 0.1f);
+
+  ~OcclusionCuller();
+
+  OcclusionCuller(const OcclusionCuller&) = delete;
+  OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+  /**
+   * @brief Adds an object bounded by a box
+   *
+   * Objects are visible until their first query comes back.
+   *
+   * @param min the minimum corner of the box
+   * @param max the maximum corner of the box
+   *
+   * @return the index of the object
+   */
+  uint32_t add(const glm::vec3& min, const glm::vec3& max);
+
+  /**
+   * @brief Changes the bounds of an object (when it moves)
+   *
+   * @param index the index of the object
+   * @param min the minimum corner of the box
+   * @param max the maximum corner of the box
+   */
+  void set_bounds(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+
+  /**
+   * @brief Removes every object
+   */
+  void clear();
+
+  /**
+   * @brief Gets the number of objects
+   */
+  size_t size() const { return objects_.size(); }
+
+  /**
+   * @brief Reads the results of any queries that have finished
+   *
+   * Never waits on the GPU. Call once per frame, before checking `visible()`.
+   */
+  void collect();
+
+  /**
+   * @brief Draws the bounding box of each object inside a query
+   *
+   * Objects whose last query hasn't finished yet are skipped. Color and
+   * depth writes are disabled while the boxes are drawn and re-enabled
+   * afterwards, and the program and vertex array are unbound.
+   *
+   * Note: Draw the occluders first, with depth testing enabled!
+   *
+   * @param view_projection the combined view and projection matrix
+   * @param eye the position of the camera
+   */
+  void issue_queries(const glm::mat4& view_projection, const glm::vec3& eye);
+
+  /**
+   * @brief Whether an object was visible in the last finished query
+   *
+   * @param index the index of the object
+   */
+  bool visible(uint32_t index) const { return objects_[index].visible; }
+
+  /**
+   * @brief Starts rendering that the GPU skips if the object is hidden
+   *
+   * Uses the latest query without waiting for it, so if the result isn't
+   * ready the draws happen anyway.
+   *
+   * @param index the index of the object
+   *
+   * @return true if conditional rendering began, in which case
+   *         `end_conditional()` must be called after the draws
+   */
+  bool begin_conditional(uint32_t index) const;
+
+  /**
+   * @brief Ends rendering started by `begin_conditional()`
+   */
+  void end_conditional() const;
+
+private:
+  /**
+   * @brief An object and its query
+   */
+  struct Object
+  {
+    /// The minimum corner of the box
+    float min[3];
+    /// The maximum corner of the box
+    float max[3];
+    /// The query object
+    GLuint query;
+    /// Whether the query has been issued and the result not read yet
+    bool pending;
+    /// Whether the query has ever been issued (and can be used for conditional rendering)
+    bool issued;
+    /// The result of the last finished query
+    bool visible;
+  };
+
+  /// The distance boxes are expanded by when checking if the camera is in them
+  float near_plane_;
+  /// The query target (conservative if supported)
+  GLenum query_target_;
+  /// The shader that transforms the proxy box
+  Shader vertex_shader_;
+  /// The shader that outputs nothing of interest
+  Shader fragment_shader_;
+  /// The program the proxy box is drawn with
+  ShaderProgram program_;
+  /// The location of the `mvp` uniform
+  GLint mvp_location_;
+  /// The attributes of the proxy box (just position)
+  VertexAttributeArray attributes_;
+  /// The corners of the unit cube
+  VertexBufferObject vertex_buffer_;
+  /// The triangles of the unit cube
+  IndexBufferObject index_buffer_;
+  /// The vertex array of the proxy box
+  VertexArrayObject array_;
+  /// The objects being culled
+  std::vector<Object> objects_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_OCCLUSION_CULLER_H)
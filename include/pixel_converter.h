@@ -0,0 +1,117 @@
+//
+// pixel_converter.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_PIXEL_CONVERTER_H
+#define BGL_PIXEL_CONVERTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class PixelConverter
+ * @brief Converts decoded 8-bit images into what a texture's internal format wants
+ *
+ * The output is always four channels in RGBA order, as either bytes or
+ * normalized half floats. The steps (expanding RGB, swizzling BGRA,
+ * premultiplying alpha, converting to half float) are run together on
+ * small blocks of pixels, so the image is streamed through memory once.
+ *
+ * Each step has SIMD kernels with a scalar fallback. On x86 the fastest
+ * kernels the CPU supports (AVX2, or SSSE3/SSE4.1 and F16C) are chosen at
+ * runtime; on ARM, NEON is used when compiled for it.
+ */
+class PixelConverter
+{
+public:
+  /**
+   * @brief The channel layout of the source pixels
+   */
+  enum class Source
+  {
+    RGB,
+    RGBA,
+    BGRA
+  };
+
+  /**
+   * @brief Describes a conversion
+   *
+   * @param source the channel layout of the source pixels
+   * @param premultiply whether to multiply the color channels by alpha
+   * @param half_float whether to output normalized half floats instead of bytes
+   */
+  PixelConverter(Source source, bool premultiply = false, bool half_float = false);
+
+  /**
+   * @brief Converts pixels
+   *
+   * @param source the source pixels, tightly packed
+   * @param destination where to write the converted pixels (`output_size()` bytes)
+   * @param pixel_count the number of pixels to convert
+   */
+  void convert(const uint8_t* source, void* destination, size_t pixel_count) const;
+
+  /**
+   * @brief Gets the number of bytes the converted pixels take up
+   *
+   * @param pixel_count the number of pixels
+   */
+  size_t output_size(size_t pixel_count) const { return pixel_count * (half_float_ ? 8 : 4); }
+
+  /**
+   * @brief Gets the number of bytes each source pixel takes up
+   */
+  size_t source_pixel_size() const { return source_ == Source::RGB ? 3 : 4; }
+
+  /**
+   * @brief Gets the pixel format to upload the converted pixels as (always GL_RGBA)
+   */
+  GLenum format() const;
+
+  /**
+   * @brief Gets the data type to upload the converted pixels as
+   *
+   * @return GL_HALF_FLOAT or GL_UNSIGNED_BYTE
+   */
+  GLenum type() const;
+
+  /**
+   * @brief Expands RGB pixels to RGBA with an opaque alpha
+   */
+  static void rgb_to_rgba(const uint8_t* source, uint8_t* destination, size_t pixel_count);
+
+  /**
+   * @brief Swaps the red and blue channels of four channel pixels (BGRA to RGBA or back)
+   */
+  static void swap_red_blue(const uint8_t* source, uint8_t* destination, size_t pixel_count);
+
+  /**
+   * @brief Multiplies the color channels of RGBA pixels by alpha (rounded exactly)
+   */
+  static void premultiply_alpha(const uint8_t* source, uint8_t* destination, size_t pixel_count);
+
+  /**
+   * @brief Converts bytes to half floats, mapping 0-255 to 0-1
+   */
+  static void to_half_float(const uint8_t* source, uint16_t* destination, size_t value_count);
+
+  /**
+   * @brief Gets the name of the instruction set the kernels use on this machine
+   */
+  static const char* instruction_set();
+
+private:
+  /// The channel layout of the source pixels
+  Source source_;
+  /// Whether to premultiply alpha
+  bool premultiply_;
+  /// Whether to output half floats
+  bool half_float_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_PIXEL_CONVERTER_H)
@@ -0,0 +1,98 @@
+//
+// range_allocator.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_RANGE_ALLOCATOR_H
+#define BGL_RANGE_ALLOCATOR_H
+
+#include <map>
+#include <cstddef>
+
+namespace BarelyGL {
+/**
+ * @class RangeAllocator
+ * @brief First-fit free-list allocator for ranges of a fixed-size store
+ *
+ * Only does the bookkeeping (offsets and sizes are in whatever unit the caller
+ * uses), so it can be used to carve up vertex and index buffers alike. Free
+ * ranges are coalesced with their neighbours as they are released.
+ */
+class RangeAllocator
+{
+public:
+  /// Returned by `allocate` when there is no free range large enough
+  static const size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @brief Creates an allocator with the whole store free
+   *
+   * @param capacity the size of the store being managed
+   */
+  explicit RangeAllocator(size_t capacity);
+
+  /**
+   * @brief Reserves a range of the store
+   *
+   * @param size the size of the range
+   *
+   * @return the offset of the range, or `npos` if there is no room
+   */
+  size_t allocate(size_t size);
+
+  /**
+   * @brief Releases a range previously returned by `allocate`
+   *
+   * @param offset the offset of the range
+   * @param size the size of the range
+   */
+  void free(size_t offset, size_t size);
+
+  /**
+   * @brief Marks everything up to `used` as allocated and the rest as free
+   *
+   * Used after the store has been compacted.
+   *
+   * @param used the size of the (contiguous) allocated prefix
+   */
+  void reset(size_t used);
+
+  /**
+   * @brief Gets the size of the store being managed
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Gets the total amount of free space
+   */
+  size_t free_size() const { return free_size_; }
+
+  /**
+   * @brief Gets the size of the largest free range
+   */
+  size_t largest_free() const;
+
+  /**
+   * @brief Gets the number of separate free ranges
+   */
+  size_t free_ranges() const { return free_.size(); }
+
+  /**
+   * @brief Gets how fragmented the free space is
+   *
+   * @return 0 when all free space is one range, approaching 1 as it is split
+   *         into many small ranges
+   */
+  float fragmentation() const;
+
+private:
+  /// The size of the store being managed
+  size_t capacity_;
+  /// The total amount of free space
+  size_t free_size_;
+  /// The free ranges, keyed by offset
+  std::map<size_t, size_t> free_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_RANGE_ALLOCATOR_H)
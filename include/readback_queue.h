@@ -0,0 +1,178 @@
+//
+// readback_queue.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_READBACK_QUEUE_H
+#define BGL_READBACK_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <OpenGL/gltypes.h>
+#include "fence.h"
+
+namespace BarelyGL {
+/**
+ * @struct ReadbackResult
+ * @brief Pixels read back from a framebuffer
+ */
+struct ReadbackResult
+{
+  /// The value passed to `capture()`, for telling results apart (e.g. a frame number)
+  uint64_t tag;
+  /// The width of the region in pixels
+  int width;
+  /// The height of the region in pixels
+  int height;
+  /// The pixel format the region was read as
+  GLenum format;
+  /// The data type the region was read as
+  GLenum type;
+  /// The tightly packed pixels, bottom row first
+  std::vector<uint8_t> pixels;
+};
+
+/**
+ * @class ReadbackQueue
+ * @brief Reads framebuffers back without stalling the render thread
+ *
+ * `capture()` has OpenGL copy the pixels into one of a ring of pixel pack
+ * buffers and places a fence after it, so `glReadPixels` returns straight
+ * away. `poll()` checks the fences on later frames and copies out whatever
+ * has finished, then hands it to a worker thread where the callback can
+ * convert or encode it.
+ *
+ * If every buffer in the ring is still waiting on the GPU, the capture is
+ * dropped instead of waiting, so the ring should be a frame or two deeper
+ * than the GPU is expected to lag behind.
+ *
+ * Note: `capture()` and `poll()` must be called on the thread with the context.
+ */
+class ReadbackQueue
+{
+public:
+  /**
+   * @brief Called on the worker thread with each finished readback
+   *
+   * Exceptions it throws are caught and rethrown by the next `poll()`.
+   */
+  typedef std::function<void(const ReadbackResult&)> Callback;
+
+  /**
+   * @brief Creates the ring of buffers and starts the worker thread
+   *
+   * @param callback the function results are handed to
+   * @param ring_size the number of readbacks that can be in flight at once
+   *
+   * @throws GL::Exception if the buffers could not be created
+   */
+  ReadbackQueue(Callback callback, size_t ring_size = 3);
+
+  /**
+   * @brief Finishes handing over results already copied out, then stops the worker
+   *
+   * Readbacks the GPU hasn't finished yet are discarded.
+   */
+  ~ReadbackQueue();
+
+  ReadbackQueue(const ReadbackQueue&) = delete;
+  ReadbackQueue& operator=(const ReadbackQueue&) = delete;
+
+  /**
+   * @brief Starts reading a region of the bound read framebuffer
+   *
+   * Note: Bind the framebuffer to read from (and set its read buffer) first!
+   *
+   * @param x the left edge of the region
+   * @param y the bottom edge of the region
+   * @param width the width of the region
+   * @param height the height of the region
+   * @param format the pixel format to read as (e.g. GL_RGBA, GL_BGRA)
+   * @param type the data type to read as (e.g. GL_UNSIGNED_BYTE)
+   * @param tag a value passed through to the result
+   *
+   * @return false if the capture was dropped because the ring is full
+   *
+   * @throws GL::Exception if the format or type isn't supported
+   */
+  bool capture(int x, int y, int width, int height, GLenum format, GLenum type, uint64_t tag);
+
+  /**
+   * @brief Copies out every finished readback and queues it for the worker
+   *
+   * Never waits on the GPU. Call once per frame.
+   *
+   * @return the number of readbacks that finished
+   *
+   * @throws GL::Exception if checking a fence fails
+   * @throws whatever the callback threw on the worker thread since the last
+   * call (the worker carries on with the next result)
+   */
+  size_t poll();
+
+  /**
+   * @brief Gets the number of readbacks the GPU is still working on
+   */
+  size_t pending() const { return pending_; }
+
+  /**
+   * @brief Gets the number of captures dropped because the ring was full
+   */
+  size_t dropped() const { return dropped_; }
+
+private:
+  /**
+   * @brief A pixel pack buffer and the readback using it
+   */
+  struct Slot
+  {
+    /// The pixel pack buffer
+    GLuint buffer;
+    /// The size of the buffer's data store
+    size_t capacity;
+    /// Signalled once the readback into the buffer has finished
+    Fence fence;
+    /// The description of the readback (without pixels)
+    ReadbackResult result;
+  };
+
+  /**
+   * @brief Runs callbacks for results as they are queued
+   */
+  void work();
+
+  /// The function results are handed to
+  Callback callback_;
+  /// The ring of buffers
+  std::vector<Slot> slots_;
+  /// The slot the oldest pending readback is in
+  size_t head_ = 0;
+  /// The number of pending readbacks
+  size_t pending_ = 0;
+  /// The number of dropped captures
+  size_t dropped_ = 0;
+
+  /// Guards everything below, which is shared with the worker
+  std::mutex mutex_;
+  /// Signalled when a result is queued or the worker should stop
+  std::condition_variable ready_;
+  /// Results waiting for the callback
+  std::deque<ReadbackResult> results_;
+  /// Pixel storage handed back by the worker, to be reused
+  std::vector<std::vector<uint8_t>> spare_;
+  /// The first exception the callback threw, waiting to be rethrown by `poll()`
+  std::exception_ptr error_;
+  /// Whether the worker should stop once the queue is empty
+  bool stopping_ = false;
+  /// The worker thread
+  std::thread worker_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_READBACK_QUEUE_H)
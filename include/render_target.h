@@ -0,0 +1,133 @@
+//
+// render_target.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_RENDER_TARGET_H
+#define BGL_RENDER_TARGET_H
+
+#include <memory>
+#include <OpenGL/gltypes.h>
+#include "framebuffer.h"
+#include "renderbuffer.h"
+#include "texture.h"
+
+namespace BarelyGL {
+/**
+ * @brief The size and formats of a render target
+ */
+struct RenderTargetDescription
+{
+  /// The width of the target in pixels
+  int width;
+  /// The height of the target in pixels
+  int height;
+  /// The format color is stored as (e.g. GL_RGBA8)
+  GLenum color_format;
+  /// The format depth is stored as (0 for no depth buffer)
+  GLenum depth_format;
+  /// The number of samples per pixel (0 for no multisampling)
+  int samples;
+  /// Whether the color texture has mipmaps (single sampled targets only)
+  bool mipmaps;
+
+  bool operator==(const RenderTargetDescription& other) const
+  {
+    return width == other.width && height == other.height && color_format == other.color_format
+      && depth_format == other.depth_format && samples == other.samples
+      && mipmaps == other.mipmaps;
+  }
+};
+
+/**
+ * @class RenderTarget
+ * @brief A framebuffer along with the color and depth buffers attached to it
+ *
+ * Single sampled targets render color into a texture that can be sampled by
+ * later passes. Multisampled targets render into renderbuffers and must be
+ * resolved into a single sampled target to be read. Depth is always a
+ * renderbuffer.
+ */
+class RenderTarget
+{
+public:
+  /**
+   * @brief Creates the framebuffer and its attachments
+   *
+   * @param description the size and formats of the target
+   *
+   * @throws GL::Exception if the framebuffer is incomplete
+   */
+  explicit RenderTarget(const RenderTargetDescription& description);
+
+  RenderTarget(RenderTarget&&) = default;
+  RenderTarget& operator=(RenderTarget&&) = default;
+
+  /**
+   * @brief Binds the framebuffer and sets the viewport to cover it
+   */
+  void bind() const;
+
+  /**
+   * @brief Binds the default framebuffer
+   */
+  void unbind() const;
+
+  /**
+   * @brief Resolves the color into a single sampled target
+   *
+   * This target's color and depth are invalidated afterwards, since they
+   * shouldn't be needed once resolved. Leaves the default framebuffer bound.
+   *
+   * @param destination the target to resolve into (must be the same size)
+   */
+  void resolve_to(RenderTarget& destination);
+
+  /**
+   * @brief Fills the mipmaps of the color texture from what was rendered
+   *
+   * Does nothing unless the target was described with mipmaps.
+   */
+  void generate_mipmaps();
+
+  /**
+   * @brief Invalidates the depth buffer, for once a pass is finished with it
+   *
+   * Note: Must call `bind()` first!
+   */
+  void discard_depth();
+
+  /**
+   * @brief Gets the size and formats of the target
+   */
+  const RenderTargetDescription& description() const { return description_; }
+
+  /**
+   * @brief Gets the framebuffer
+   */
+  Framebuffer& framebuffer() { return framebuffer_; }
+
+  /**
+   * @brief Gets the color texture
+   *
+   * @return the texture, or `nullptr` if the target is multisampled
+   */
+  const Texture* color_texture() const { return color_texture_.get(); }
+
+private:
+  /// The size and formats of the target
+  RenderTargetDescription description_;
+  /// The framebuffer everything is attached to
+  Framebuffer framebuffer_;
+  /// The color texture (single sampled targets only)
+  std::unique_ptr<Texture> color_texture_;
+  /// The color renderbuffer (multisampled targets only)
+  std::unique_ptr<Renderbuffer> color_buffer_;
+  /// The depth renderbuffer (if the target has depth)
+  std::unique_ptr<Renderbuffer> depth_buffer_;
+  /// The attachment point depth is attached to
+  GLenum depth_attachment_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_RENDER_TARGET_H)
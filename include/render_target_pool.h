@@ -0,0 +1,97 @@
+//
+// render_target_pool.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_RENDER_TARGET_POOL_H
+#define BGL_RENDER_TARGET_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "render_target.h"
+
+namespace BarelyGL {
+/**
+ * @class RenderTargetPool
+ * @brief Hands out render targets, reusing ones with the same description
+ *
+ * Passes acquire a target, render into it, and release it once nothing else
+ * needs to read it, so a later pass that wants the same size and formats
+ * gets it back without reallocating. Targets that go unused for a few frames
+ * (e.g. after a resize) are destroyed by `end_frame()`.
+ */
+class RenderTargetPool
+{
+public:
+  /**
+   * @brief Creates an empty pool
+   *
+   * @param max_idle_frames how many frames a free target is kept for
+   */
+  explicit RenderTargetPool(unsigned max_idle_frames = 2);
+
+  /**
+   * @brief Gets a free target matching the description, creating one if needed
+   *
+   * @param description the size and formats of the target
+   *
+   * @return the target, which stays valid until released and destroyed
+   *
+   * @throws GL::Exception if a new target could not be created
+   */
+  RenderTarget& acquire(const RenderTargetDescription& description);
+
+  /**
+   * @brief Returns a target to the pool so it can be acquired again
+   *
+   * @param target a target acquired from this pool
+   *
+   * @throws GL::Exception if the target isn't from this pool
+   */
+  void release(const RenderTarget& target);
+
+  /**
+   * @brief Advances the frame and destroys targets that have been free for too long
+   */
+  void end_frame();
+
+  /**
+   * @brief Destroys every free target
+   */
+  void trim();
+
+  /**
+   * @brief Gets the number of targets the pool owns
+   */
+  size_t size() const { return entries_.size(); }
+
+  /**
+   * @brief Gets the number of targets currently acquired
+   */
+  size_t in_use() const;
+
+private:
+  /**
+   * @brief A target owned by the pool
+   */
+  struct Entry
+  {
+    /// The target (heap allocated so references to it stay valid)
+    std::unique_ptr<RenderTarget> target;
+    /// Whether the target is currently acquired
+    bool in_use;
+    /// The frame the target was last acquired in
+    uint64_t last_used;
+  };
+
+  /// How many frames a free target is kept for
+  unsigned max_idle_frames_;
+  /// The current frame
+  uint64_t frame_ = 0;
+  /// The targets owned by the pool
+  std::vector<Entry> entries_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_RENDER_TARGET_POOL_H)
@@ -0,0 +1,115 @@
+//
+// renderbuffer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_RENDERBUFFER_H
+#define BGL_RENDERBUFFER_H
+
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class Renderbuffer
+ * @brief Wrapper around OpenGL renderbuffer
+ *
+ * Renderbuffers can't be sampled, but they are the only way to get
+ * multisampled storage that can be resolved into a texture.
+ */
+class Renderbuffer
+{
+public:
+  /**
+   * @brief Creates a new renderbuffer and allocates its storage
+   *
+   * @param width width of the renderbuffer
+   * @param height height of the renderbuffer
+   * @param internal_format format the renderbuffer should be stored as
+   * @param samples number of samples per pixel (0 for no multisampling)
+   *
+   * @throws GL::Exception if the object fails to be constructed
+   */
+  Renderbuffer(int width, int height, GLenum internal_format, int samples = 0);
+
+  ~Renderbuffer();
+
+  /**
+   * @brief Takes ownership of another renderbuffer's underlying object
+   *
+   * @param other the renderbuffer to move from (left without an object)
+   */
+  Renderbuffer(Renderbuffer&& other) noexcept;
+
+  /**
+   * @brief Destroys the current object and takes ownership of another renderbuffer's
+   *
+   * @param other the renderbuffer to move from (left without an object)
+   */
+  Renderbuffer& operator=(Renderbuffer&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Renderbuffer(const Renderbuffer&) = delete;
+  Renderbuffer& operator=(const Renderbuffer&) = delete;
+
+  /**
+   * @brief Binds the renderbuffer for use
+   */
+  void bind() const;
+
+  /**
+   * @brief Unbinds the renderbuffer
+   */
+  void unbind() const;
+
+  /**
+   * @brief Gets the width of the renderbuffer
+   */
+  int width() const { return width_; }
+
+  /**
+   * @brief Gets the height of the renderbuffer
+   */
+  int height() const { return height_; }
+
+  /**
+   * @brief Gets the number of samples per pixel (0 if not multisampled)
+   */
+  int samples() const { return samples_; }
+
+  /**
+   * @brief Gets the format the renderbuffer is stored as
+   */
+  GLenum internal_format() const { return internal_format_; }
+
+  /**
+   * @brief Gets the estimated size of the storage in bytes (every sample counted)
+   */
+  size_t byte_size() const;
+
+  /**
+   * @brief Gets the id assigned by OpenGL for this renderbuffer
+   *
+   * @return GLuint representing the id
+   */
+  GLuint id() const { return id_; }
+
+private:
+  /**
+   * @brief Destroys the renderbuffer
+   */
+  void destroy();
+
+  /// The ID of underlying renderbuffer object
+  GLuint id_ = 0;
+  /// The width of the renderbuffer
+  int width_;
+  /// The height of the renderbuffer
+  int height_;
+  /// The format the renderbuffer is stored as
+  GLenum internal_format_;
+  /// The number of samples per pixel
+  int samples_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_RENDERBUFFER_H)
@@ -0,0 +1,160 @@
+//
+// sampler.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_SAMPLER_H
+#define BGL_SAMPLER_H
+
+#include <cstddef>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @struct SamplerState
+ * @brief How a texture is filtered and wrapped when sampled
+ *
+ * Start from one of the presets and change what is needed, since the
+ * members have no defaults.
+ */
+struct SamplerState
+{
+  /// The minification filter (e.g. GL_LINEAR_MIPMAP_LINEAR)
+  GLenum min_filter;
+  /// The magnification filter (GL_NEAREST or GL_LINEAR)
+  GLenum mag_filter;
+  /// The wrap mode for the s coordinate (e.g. GL_REPEAT)
+  GLenum wrap_s;
+  /// The wrap mode for the t coordinate
+  GLenum wrap_t;
+  /// The wrap mode for the r coordinate
+  GLenum wrap_r;
+  /// The most anisotropy to use (1 for none, clamped to what is supported)
+  float max_anisotropy;
+  /// The bias added to the mipmap level
+  float lod_bias;
+  /// The color used outside the texture with GL_CLAMP_TO_BORDER
+  float border_color[4];
+
+  /**
+   * @brief Nearest filtering, no mipmaps, clamped to a transparent border
+   *
+   * This matches what `Texture` sets on itself.
+   */
+  static SamplerState nearest_clamp();
+
+  /**
+   * @brief Bilinear filtering, no mipmaps, clamped to the edge
+   */
+  static SamplerState linear_clamp();
+
+  /**
+   * @brief Trilinear filtering, repeating
+   */
+  static SamplerState trilinear_repeat();
+
+  /**
+   * @brief Trilinear filtering with anisotropy, repeating
+   *
+   * @param max_anisotropy the most anisotropy to use (e.g. 16)
+   */
+  static SamplerState anisotropic_repeat(float max_anisotropy);
+
+  bool operator==(const SamplerState& other) const;
+  bool operator!=(const SamplerState& other) const { return !(*this == other); }
+};
+
+/**
+ * @struct SamplerStateHash
+ * @brief Hashes a `SamplerState` for use as an unordered key
+ */
+struct SamplerStateHash
+{
+  size_t operator()(const SamplerState& state) const;
+};
+
+/**
+ * @class Sampler
+ * @brief Wrapper around an OpenGL sampler object
+ *
+ * A sampler bound to a unit overrides the filtering and wrapping of
+ * whichever texture is bound there. Samplers are usually shared through
+ * `SamplerCache` rather than created directly.
+ */
+class Sampler
+{
+public:
+  /**
+   * @brief Creates a sampler and sets its parameters
+   *
+   * @param state the filtering and wrapping to use
+   *
+   * @throws GL::Exception if the object fails to be constructed
+   */
+  explicit Sampler(const SamplerState& state);
+
+  ~Sampler();
+
+  /**
+   * @brief Takes ownership of another sampler's underlying object
+   *
+   * @param other the sampler to move from (left without an object)
+   */
+  Sampler(Sampler&& other) noexcept;
+
+  /**
+   * @brief Destroys the current object and takes ownership of another sampler's
+   *
+   * @param other the sampler to move from (left without an object)
+   */
+  Sampler& operator=(Sampler&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  /**
+   * @brief Binds the sampler to a texture unit
+   *
+   * @param unit the texture unit (0 for GL_TEXTURE0)
+   */
+  void bind(GLuint unit) const;
+
+  /**
+   * @brief Unbinds whatever sampler is bound to a texture unit
+   *
+   * @param unit the texture unit (0 for GL_TEXTURE0)
+   */
+  void unbind(GLuint unit) const;
+
+  /**
+   * @brief Gets the filtering and wrapping of the sampler
+   */
+  const SamplerState& state() const { return state_; }
+
+  /**
+   * @brief Gets the id assigned by OpenGL for this sampler
+   *
+   * @return GLuint representing the id
+   */
+  GLuint id() const { return id_; }
+
+private:
+  /**
+   * @brief Sets the sampler parameters from `state_`
+   */
+  void set_parameters();
+
+  /**
+   * @brief Destroys the sampler
+   */
+  void destroy();
+
+  /// The ID of underlying sampler object
+  GLuint id_ = 0;
+  /// The filtering and wrapping of the sampler
+  SamplerState state_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_SAMPLER_H)
@@ -0,0 +1,65 @@
+//
+// sampler_cache.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_SAMPLER_CACHE_H
+#define BGL_SAMPLER_CACHE_H
+
+#include <unordered_map>
+#include "sampler.h"
+
+namespace BarelyGL {
+/**
+ * @class SamplerCache
+ * @brief Shares one sampler object between everything with the same state
+ *
+ * Scenes only ever use a handful of distinct sampler states, so however many
+ * textures there are, only that many sampler objects are created.
+ *
+ * Note: The cache lives until the program exits, which is after the context
+ * is gone. Call `clear()` before destroying the context.
+ */
+class SamplerCache
+{
+public:
+  /**
+   * @brief Gets the shared cache
+   */
+  static SamplerCache& get();
+
+  SamplerCache() = default;
+  SamplerCache(const SamplerCache&) = delete;
+  SamplerCache& operator=(const SamplerCache&) = delete;
+
+  /**
+   * @brief Gets the sampler for a state, creating it the first time
+   *
+   * @param state the filtering and wrapping wanted
+   *
+   * @return the sampler, which stays valid until `clear()`
+   *
+   * @throws GL::Exception if a new sampler could not be created
+   */
+  const Sampler& sampler(const SamplerState& state);
+
+  /**
+   * @brief Destroys every sampler
+   *
+   * Note: Must be called while the context is still current, before it is
+   * destroyed, or the samplers are deleted during static destruction.
+   */
+  void clear() { samplers_.clear(); }
+
+  /**
+   * @brief Gets the number of distinct samplers
+   */
+  size_t size() const { return samplers_.size(); }
+
+private:
+  /// The samplers, keyed by their state
+  std::unordered_map<SamplerState, Sampler, SamplerStateHash> samplers_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_SAMPLER_CACHE_H)
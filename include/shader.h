@@ -21,19 +21,64 @@ public:
    * @brief Loads and compiles the shader
    *
    * @param file_path path to the shader
-   * @param shader_type type of shader (either GL_FRAGMENT_SHADER or GL_VERTEX_SHADER)
+   * @param shader_type type of shader (e.g. GL_VERTEX_SHADER or GL_COMPUTE_SHADER)
    *
    * @throws GL::Exception if the object fails to be constructed
    */
   Shader(const std::string& file_path, GLenum shader_type);
   ~Shader();
 
+  /**
+   * @brief Compiles a shader from source held in memory
+   *
+   * Useful for the small shaders the library needs itself, which shouldn't
+   * depend on files being shipped alongside it.
+   *
+   * @param source the GLSL source of the shader
+   * @param shader_type type of shader (e.g. GL_VERTEX_SHADER or GL_COMPUTE_SHADER)
+   *
+   * @return the compiled shader
+   *
+   * @throws GL::Exception if the shader fails to compile
+   */
+  static Shader from_source(const std::string& source, GLenum shader_type);
+
+  /**
+   * @brief Takes ownership of another shader's underlying shader object
+   *
+   * @param other the shader to move from (left without a shader object)
+   */
+  Shader(Shader&& other) noexcept;
+
+  /**
+   * @brief Destroys the current shader object and takes ownership of another shader's
+   *
+   * @param other the shader to move from (left without a shader object)
+   */
+  Shader& operator=(Shader&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Shader(const Shader&) = delete;
+  Shader& operator=(const Shader&) = delete;
+
   /**
    * @brief The ID of the underlying OpenGL object
    */
   GLuint id() const { return id_; }
 
+  /**
+   * @brief The stage of the shader (e.g. GL_VERTEX_SHADER)
+   */
+  GLenum type() const { return shader_type_; }
+
 private:
+  /**
+   * @brief Sets up the shader type without loading anything
+   *
+   * @param shader_type type of shader
+   */
+  explicit Shader(GLenum shader_type);
+
   /**
    * @brief Creates an empty shader object
    */
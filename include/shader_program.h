@@ -8,6 +8,7 @@
 
 #include <OpenGL/gltypes.h>
 #include <string>
+#include <vector>
 #include <glm/fwd.hpp>
 
 namespace BarelyGL {
@@ -24,8 +25,38 @@ public:
    * @brief Creates and links a new program with the provided vertex and fragment shaders
    */
   ShaderProgram(const Shader* vertex_shader, const Shader* fragment_shader);
+
+  /**
+   * @brief Creates and links a new program from any set of stages
+   *
+   * A compute shader can't be linked with any other stage, so a compute
+   * program is made from a single compute shader.
+   *
+   * @param shaders the shaders to link (only needed until the constructor returns)
+   *
+   * @throws GL::Exception if a compute shader is mixed with other stages or linking fails
+   */
+  explicit ShaderProgram(const std::vector<const Shader*>& shaders);
   ~ShaderProgram();
 
+  /**
+   * @brief Takes ownership of another program's underlying program object
+   *
+   * @param other the program to move from (left without a program object)
+   */
+  ShaderProgram(ShaderProgram&& other) noexcept;
+
+  /**
+   * @brief Destroys the current program object and takes ownership of another program's
+   *
+   * @param other the program to move from (left without a program object)
+   */
+  ShaderProgram& operator=(ShaderProgram&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  ShaderProgram(const ShaderProgram&) = delete;
+  ShaderProgram& operator=(const ShaderProgram&) = delete;
+
   /**
    * @brief Start using this program for the following commands
    */
@@ -39,6 +70,35 @@ public:
    */
   void set_uniform(const std::string& name, glm::mat4 matrix);
 
+  /**
+   * @brief Runs a compute program over a grid of work groups
+   *
+   * Note: Must call `use()` first! Follow with `memory_barrier()` before
+   * reading what the shader wrote.
+   *
+   * @param x the number of work groups in x
+   * @param y the number of work groups in y
+   * @param z the number of work groups in z
+   *
+   * @throws GL::Exception if the program isn't a compute program
+   */
+  void dispatch(GLuint x, GLuint y = 1, GLuint z = 1) const;
+
+  /**
+   * @brief Makes incoherent writes by shaders visible to later commands
+   *
+   * Does nothing on contexts without shader writes (before GL 4.2).
+   *
+   * @param barriers the ways the written data will be read (e.g.
+   *                 GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT)
+   */
+  static void memory_barrier(GLbitfield barriers);
+
+  /**
+   * @brief Whether the program was linked from a compute shader
+   */
+  bool is_compute() const { return compute_; }
+
   /**
    * @brief Stops using this program
    */
@@ -52,6 +112,8 @@ public:
 private:
   /**
    * @brief Attaches and links the shaders.
+   *
+   * @throws GL::Exception if a compute shader is mixed with other stages or linking fails
    */
   void link();
 
@@ -71,10 +133,10 @@ private:
 
   /// The ID of the underlying shader object
   GLuint id_ = 0;
-  /// A pointer to the vertex shader
-  const Shader* vertex_shader_;
-  /// A pointer to the fragment shader
-  const Shader* fragment_shader_;
+  /// The shaders to link (only valid during construction)
+  std::vector<const Shader*> shaders_;
+  /// Whether the program is a compute program
+  bool compute_ = false;
 };
 }
 
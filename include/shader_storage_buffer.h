@@ -0,0 +1,142 @@
+//
+// shader_storage_buffer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_SHADER_STORAGE_BUFFER_H
+#define BGL_SHADER_STORAGE_BUFFER_H
+
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+/**
+ * @class ShaderStorageBuffer
+ * @brief Wrapper around a buffer that shaders can read and write (SSBO)
+ *
+ * Bound to an indexed `buffer` block in a shader with `bind_base()`. The same
+ * buffer can also be bound to any other target, e.g. GL_ARRAY_BUFFER to draw
+ * particles a compute shader has just simulated.
+ *
+ * Needs GL 4.3 (see `Capabilities::compute_shaders()`). Edits go through
+ * GL_COPY_WRITE_BUFFER (or direct state access), so they never disturb the
+ * buffers bound for drawing.
+ */
+class ShaderStorageBuffer
+{
+public:
+  /**
+   * @brief Creates a buffer with a data store of `size` bytes
+   *
+   * @param size the size of the data store in bytes
+   * @param usage usage pattern of the buffer (e.g. GL_DYNAMIC_COPY when only the GPU writes it)
+   * @param data the data to fill it with (or `nullptr` to leave it undefined)
+   *
+   * @throws GL::Exception if shader storage buffers are unsupported or the object fails to
+   *         be constructed
+   */
+  ShaderStorageBuffer(GLsizeiptr size, GLenum usage, const void* data = nullptr);
+  ~ShaderStorageBuffer();
+
+  /**
+   * @brief Takes ownership of another buffer's underlying buffer object
+   *
+   * @param other the buffer to move from (left without a buffer object)
+   */
+  ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept;
+
+  /**
+   * @brief Destroys the current buffer object and takes ownership of another buffer's
+   *
+   * @param other the buffer to move from (left without a buffer object)
+   */
+  ShaderStorageBuffer& operator=(ShaderStorageBuffer&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+  ShaderStorageBuffer& operator=(const ShaderStorageBuffer&) = delete;
+
+  /**
+   * @brief Binds the whole buffer to an indexed shader storage binding point
+   *
+   * @param index the binding point (matching `layout(binding = index)` in the shader)
+   */
+  void bind_base(GLuint index) const;
+
+  /**
+   * @brief Binds part of the buffer to an indexed shader storage binding point
+   *
+   * @param index the binding point
+   * @param offset the offset into the buffer in bytes (a multiple of
+   *               GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT)
+   * @param size the size of the range in bytes
+   */
+  void bind_range(GLuint index, GLintptr offset, GLsizeiptr size) const;
+
+  /**
+   * @brief Binds the buffer to a non-indexed target
+   *
+   * @param target the target to bind to (e.g. GL_ARRAY_BUFFER)
+   */
+  void bind(GLenum target) const;
+
+  /**
+   * @brief Recreates the data store
+   *
+   * @param size the size of the data store in bytes
+   * @param data the data to fill it with (or `nullptr`)
+   */
+  void set_data(GLsizeiptr size, const void* data);
+
+  /**
+   * @brief Replaces part of the data store
+   *
+   * @param offset the offset into the buffer in bytes
+   * @param size the number of bytes to replace
+   * @param data the new data
+   */
+  void sub_data(GLintptr offset, GLsizeiptr size, const void* data);
+
+  /**
+   * @brief Copies part of the data store back to the CPU
+   *
+   * Stalls until the GPU has finished writing the buffer, so is meant for
+   * tests and tools. Call `ShaderProgram::memory_barrier()` with
+   * GL_BUFFER_UPDATE_BARRIER_BIT after a dispatch that wrote it.
+   *
+   * @param offset the offset into the buffer in bytes
+   * @param size the number of bytes to read
+   * @param data where to write the bytes
+   */
+  void read(GLintptr offset, GLsizeiptr size, void* data) const;
+
+  /**
+   * @brief Gets the size of the data store in bytes
+   */
+  GLsizeiptr size() const { return size_; }
+
+  /**
+   * @brief Gets the size of the data store in bytes (the same as `size()`)
+   */
+  size_t byte_size() const { return static_cast<size_t>(size_); }
+
+  /**
+   * @brief The ID of the underlying OpenGL object
+   */
+  GLuint id() const { return id_; }
+
+private:
+  /**
+   * @brief Destroys the buffer
+   */
+  void destroy();
+
+  /// The ID of underlying buffer object
+  GLuint id_ = 0;
+  /// The usage pattern of the buffer
+  GLenum usage_;
+  /// The size of the data store in bytes
+  GLsizeiptr size_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_SHADER_STORAGE_BUFFER_H)
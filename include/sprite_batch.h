@@ -0,0 +1,181 @@
+//
+// sprite_batch.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_SPRITE_BATCH_H
+#define BGL_SPRITE_BATCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <OpenGL/gltypes.h>
+#include "vertex_attribute_array.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "vertex_array_object.h"
+
+namespace BarelyGL {
+class Texture;
+
+/**
+ * @struct Sprite
+ * @brief A textured, colored and rotated quad
+ */
+struct Sprite
+{
+  /**
+   * @brief Creates an untinted sprite showing the whole texture
+   *
+   * @param x the x position of the sprite's origin
+   * @param y the y position of the sprite's origin
+   * @param width the width of the sprite
+   * @param height the height of the sprite
+   */
+  Sprite(float x, float y, float width, float height)
+    : x(x), y(y), width(width), height(height) {};
+
+  /// The position of the origin
+  float x, y;
+  /// The size of the quad
+  float width, height;
+  /// The rotation around the origin, in radians
+  float rotation = 0.0f;
+  /// The origin as a fraction of the size (0.5, 0.5 is the centre)
+  float origin_x = 0.5f, origin_y = 0.5f;
+  /// The region of the texture to show
+  float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+  /// The tint color
+  float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+};
+
+/**
+ * @class SpriteBatch
+ * @brief Draws large numbers of sprites with one draw call per texture
+ *
+ * Sprites are collected between `begin()` and `end()` and expanded into
+ * vertices all at once (four corners at a time with SSE or NEON). They are
+ * uploaded into a single streamed VBO and drawn against a static index
+ * buffer shared by every quad, with one draw for each run of sprites using
+ * the same texture.
+ *
+ * The batch doesn't own a shader; use a program before calling `end()` with
+ * the vertex layout:
+ *    (location = 0) vec2 position;
+ *    (location = 1) vec2 uv;
+ *    (location = 2) vec4 color;
+ */
+class SpriteBatch
+{
+public:
+  /**
+   * @brief How sprites are ordered when drawn
+   */
+  enum class SortMode
+  {
+    /// In the order they were submitted (a draw per texture change)
+    Submission,
+    /// Grouped by texture (one draw per texture, ignores submission order)
+    Texture
+  };
+
+  /**
+   * @brief Creates the streamed vertex buffer and the shared index buffer
+   *
+   * @param max_sprites the most sprites uploaded at once (more are drawn in
+   *                    several flushes)
+   *
+   * @throws GL::Exception if the buffers fail to be constructed
+   */
+  SpriteBatch(size_t max_sprites = 16384);
+
+  /**
+   * @brief Starts collecting sprites
+   *
+   * @param sort_mode how the sprites should be ordered
+   */
+  void begin(SortMode sort_mode = SortMode::Submission);
+
+  /**
+   * @brief Adds a sprite to the batch
+   *
+   * @param texture the texture to draw the sprite with
+   * @param sprite the sprite to draw
+   */
+  void draw(const Texture* texture, const Sprite& sprite);
+
+  /**
+   * @brief Draws every sprite collected so far and empties the batch
+   */
+  void flush();
+
+  /**
+   * @brief Draws the remaining sprites and stops collecting
+   */
+  void end();
+
+  /**
+   * @brief Gets the number of draw calls made since `begin()`
+   */
+  size_t draw_calls() const { return draw_calls_; }
+
+  /**
+   * @brief Gets the number of sprites waiting to be drawn
+   */
+  size_t size() const { return sprites_.size(); }
+
+  /**
+   * @brief Gets a counter that changes whenever the waiting sprites are drawn
+   *        or dropped (by `flush()`, `end()` or `begin()`)
+   *
+   * Anything added with an older generation is no longer waiting to be drawn.
+   */
+  uint64_t generation() const { return generation_; }
+
+private:
+  /**
+   * @struct Entry
+   * @brief A sprite and the texture it is drawn with
+   */
+  struct Entry
+  {
+    /// The texture
+    const Texture* texture;
+    /// The sprite
+    Sprite sprite;
+  };
+
+  /**
+   * @brief Expands, uploads and draws the sprites in [first, last)
+   */
+  void draw_range(size_t first, size_t last);
+
+  /**
+   * @brief Writes the four vertices of a sprite into `vertices`
+   */
+  static void expand(const Sprite& sprite, float* vertices);
+
+  /// The most sprites uploaded at once
+  size_t max_sprites_;
+  /// The layout of each vertex
+  VertexAttributeArray attributes_;
+  /// The streamed vertex buffer
+  VertexBufferObject vertex_buffer_;
+  /// The static quad index buffer
+  IndexBufferObject index_buffer_;
+  /// The VAO describing the buffers
+  VertexArrayObject array_;
+  /// The sprites waiting to be drawn
+  std::vector<Entry> sprites_;
+  /// CPU staging for the expanded vertices
+  std::vector<float> vertices_;
+  /// How sprites are ordered when drawn
+  SortMode sort_mode_ = SortMode::Submission;
+  /// The number of draw calls since `begin()`
+  size_t draw_calls_ = 0;
+  /// Bumped whenever the waiting sprites are drawn or dropped
+  uint64_t generation_ = 1;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_SPRITE_BATCH_H)
@@ -0,0 +1,217 @@
+//
+// static_batcher.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_STATIC_BATCHER_H
+#define BGL_STATIC_BATCHER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/fwd.hpp>
+#include <OpenGL/gltypes.h>
+#include "vertex_attribute_array.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "vertex_array_object.h"
+#include "frustum_culler.h"
+
+namespace BarelyGL {
+class ShaderProgram;
+class Texture;
+
+/**
+ * @class StaticBatcher
+ * @brief Merges many small static meshes into a few large draws
+ *
+ * Meshes that never move are added with their model matrix. `build()` groups
+ * them by program and textures, transforms their positions (and normals) into
+ * world space, and packs every group into one shared VBO/IBO pair, so each
+ * group is drawn with a single `glMultiDrawElements`. Meshes are sorted along
+ * a Morton curve within each group and split into chunks of roughly
+ * `chunk_indices` indices, each with its own bounds, so the chunks outside
+ * the frustum are skipped without culling every mesh.
+ *
+ * Every mesh must use the same vertex attributes. Positions are read from the
+ * first attribute, which must have 3 values.
+ */
+class StaticBatcher
+{
+public:
+  /**
+   * @brief Creates an empty batcher
+   *
+   * @param attributes the vertex attributes of every mesh
+   * @param normal_attribute the index of the normal attribute (or -1 if none)
+   * @param chunk_indices the number of indices to aim for in each chunk
+   * @param thread_count the most threads to use (0 uses one per core)
+   *
+   * @throws GL::Exception if the attributes have no 3 value position, or the
+   * normal attribute isn't 3 values
+   */
+  StaticBatcher(const VertexAttributeArray& attributes, int normal_attribute = -1,
+                size_t chunk_indices = 16384, size_t thread_count = 0);
+
+  /**
+   * @brief Adds a mesh to be merged on the next `build()`
+   *
+   * The data is copied, so it can be freed straight away.
+   *
+   * @param program the program to draw the mesh with
+   * @param textures the textures to bind, from unit 0
+   * @param vertices the vertex data in model space
+   * @param indices the indices, relative to the first vertex of the mesh
+   * @param model the matrix placing the mesh in the world
+   *
+   * @throws GL::Exception if the mesh is empty or has a partial vertex
+   */
+  void add(const ShaderProgram* program, const std::vector<const Texture*>& textures,
+           const std::vector<float>& vertices, const std::vector<int>& indices,
+           const glm::mat4& model);
+
+  /**
+   * @brief Transforms, merges and uploads every mesh added so far
+   *
+   * Replaces whatever was built before. The copied mesh data is freed
+   * afterwards, so meshes have to be added again to rebuild.
+   *
+   * @throws GL::Exception if the merged meshes have too many vertices to index
+   */
+  void build();
+
+  /**
+   * @brief Draws the chunks inside the frustum of a view-projection matrix
+   *
+   * Each batch uses its program and binds its textures before drawing, and
+   * is skipped entirely if none of its chunks are visible.
+   *
+   * @param view_projection the combined view and projection matrix
+   */
+  void draw(const glm::mat4& view_projection);
+
+  /**
+   * @brief Gets the number of batches (distinct program and textures)
+   */
+  size_t batch_count() const { return batches_.size(); }
+
+  /**
+   * @brief Gets the number of chunks over all batches
+   */
+  size_t chunk_count() const { return chunks_.size(); }
+
+  /**
+   * @brief Gets the number of chunks drawn by the last `draw()`
+   */
+  size_t visible_chunks() const { return visible_.size(); }
+
+  /**
+   * @brief Gets the number of draw calls made by the last `draw()`
+   */
+  size_t draw_calls() const { return draw_calls_; }
+
+  /**
+   * @brief Gets the shared vertex buffer
+   */
+  const VertexBufferObject& vertex_buffer() const { return vertex_buffer_; }
+
+  /**
+   * @brief Gets the shared index buffer
+   */
+  const IndexBufferObject& index_buffer() const { return index_buffer_; }
+
+private:
+  /**
+   * @struct Batch
+   * @brief Meshes that share a program and textures
+   */
+  struct Batch
+  {
+    /// The program to draw with
+    const ShaderProgram* program;
+    /// The textures to bind, from unit 0
+    std::vector<const Texture*> textures;
+    /// The meshes waiting for `build()`
+    std::vector<size_t> meshes;
+    /// The first chunk of the batch
+    size_t first_chunk;
+    /// The number of chunks in the batch
+    size_t chunk_count;
+  };
+
+  /**
+   * @struct Mesh
+   * @brief A copied mesh waiting for `build()`
+   */
+  struct Mesh
+  {
+    /// The vertex data in model space
+    std::vector<float> vertices;
+    /// The indices, relative to the first vertex
+    std::vector<int> indices;
+    /// The model matrix (column major)
+    float model[16];
+    /// The world space bounds (filled in by `build()`)
+    float min[3], max[3];
+    /// Where the mesh goes in the shared buffers (filled in by `build()`)
+    size_t first_vertex, first_index;
+  };
+
+  /**
+   * @struct Chunk
+   * @brief A run of indices drawn and culled together
+   */
+  struct Chunk
+  {
+    /// The first index of the chunk
+    size_t first_index;
+    /// The number of indices in the chunk
+    size_t index_count;
+  };
+
+  /**
+   * @brief Transforms the meshes in [first, last) into the staging buffers
+   *
+   * @param order the meshes, in the order they are packed
+   * @param first the first entry of `order` to transform
+   * @param last one past the last entry of `order` to transform
+   * @param vertices the merged vertex data
+   * @param indices the merged indices
+   */
+  void transform_range(const std::vector<size_t>& order, size_t first, size_t last,
+                       std::vector<float>& vertices, std::vector<int>& indices);
+
+  /// The attributes of each vertex
+  VertexAttributeArray attributes_;
+  /// The offset of the normal in each vertex (in floats, or -1 if none)
+  int normal_offset_;
+  /// The number of indices to aim for in each chunk
+  size_t chunk_indices_;
+  /// The most threads to use
+  size_t thread_count_;
+  /// The batches, in the order they were first added to
+  std::vector<Batch> batches_;
+  /// The meshes waiting for `build()`
+  std::vector<Mesh> meshes_;
+  /// Every chunk, grouped by batch (index matches the culler)
+  std::vector<Chunk> chunks_;
+  /// The bounds of every chunk
+  FrustumCuller culler_;
+  /// The shared vertex buffer
+  VertexBufferObject vertex_buffer_;
+  /// The shared index buffer
+  IndexBufferObject index_buffer_;
+  /// The VAO describing the shared buffers
+  VertexArrayObject array_;
+  /// The chunks visible in the last `draw()`
+  std::vector<uint32_t> visible_;
+  /// The index counts passed to `glMultiDrawElements`
+  std::vector<GLsizei> counts_;
+  /// The index byte offsets passed to `glMultiDrawElements`
+  std::vector<const void*> offsets_;
+  /// The number of draw calls made by the last `draw()`
+  size_t draw_calls_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_STATIC_BATCHER_H)
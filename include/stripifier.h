@@ -0,0 +1,58 @@
+//
+// stripifier.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_STRIPIFIER_H
+#define BGL_STRIPIFIER_H
+
+#include <vector>
+#include <cstddef>
+
+namespace BarelyGL {
+/**
+ * @class Stripifier
+ * @brief Converts indexed triangle lists into triangle strips joined by restarts
+ *
+ * A strip of n triangles needs n + 2 indices rather than 3n, so long strips
+ * come close to a third of the indices. Strips are joined with
+ * `restart_index` rather than degenerate triangles; an IBO holding the
+ * result should have `IndexBufferObject::set_primitive_restart()` set and
+ * be drawn with GL_TRIANGLE_STRIP.
+ *
+ * Strips are grown greedily, starting from the triangle with the fewest
+ * unvisited neighbours so that few triangles are left isolated. Winding is
+ * kept, so every strip starts on an even triangle and only continues over
+ * edges that keep the alternating order consistent. Degenerate triangles are
+ * dropped.
+ *
+ * Meshes with little connectivity (e.g. triangle soups) can come out larger
+ * than the list they came from, so compare sizes before using the strips.
+ */
+class Stripifier
+{
+public:
+  /// The index joining strips (0xFFFFFFFF as an unsigned int, the fixed restart index)
+  static const int restart_index = -1;
+
+  /**
+   * @brief Converts a triangle list into strips
+   *
+   * @param indices the triangle list (three indices per triangle)
+   *
+   * @return the strips, separated by `restart_index`
+   */
+  std::vector<int> stripify(const std::vector<int>& indices) const;
+
+  /**
+   * @brief Counts the triangles a strip index buffer draws
+   *
+   * @param strips strips separated by `restart_index`
+   *
+   * @return the number of triangles (including degenerate ones)
+   */
+  static size_t triangle_count(const std::vector<int>& strips);
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_STRIPIFIER_H)
@@ -10,6 +10,8 @@
 #include <OpenGL/gltypes.h>
 
 namespace BarelyGL {
+class PixelConverter;
+
 /**
  * @class Texture
  * @brief Wrapper around OpenGL texture
@@ -57,17 +59,99 @@ public:
    */
   Texture(int width, int height, GLenum format, const void* pixels);
 
+  /**
+   * @brief Converts the pixels to RGBA (bytes or half floats) and uploads them
+   *
+   * @param width width of the texture
+   * @param height height of the texture
+   * @param internal_format format the texture should be stored as (e.g.
+   *                        GL_RGBA8, or GL_RGBA16F for half float output)
+   * @param converter the conversion to run on the pixels
+   * @param pixels raw pixel data of the texture, in the converter's source layout
+   *
+   * @throws GL::Exception if the object fails to be constructed
+   */
+  Texture(int width, int height, GLenum internal_format, const PixelConverter& converter,
+          const uint8_t* pixels);
+
+  /**
+   * @brief Creates a new texture and uploads a full or partial mipmap chain
+   *
+   * The texture samples its mipmaps with trilinear filtering. Levels can be
+   * made with `MipmapGenerator`; an empty level is allocated but left
+   * undefined (for filling with `generate_mipmaps()`).
+   *
+   * @param width width of the texture
+   * @param height height of the texture
+   * @param format pixel format of the data
+   * @param internal_format format the texture should be stored as
+   * @param pixels raw pixel data of level 0 (tightly packed)
+   * @param mipmaps raw pixel data of levels 1 and below (tightly packed)
+   *
+   * @throws GL::Exception if there are too many levels or the object fails to be constructed
+   */
+  Texture(int width, int height, GLenum format, GLenum internal_format, const void* pixels,
+          const std::vector<std::vector<uint8_t>>& mipmaps);
+
+  /**
+   * @brief Creates a new array or 3D texture
+   *
+   * An array keeps its layers apart (no filtering or mipmapping between them),
+   * so many same-sized materials can be sampled from one binding.
+   *
+   * @param target GL_TEXTURE_2D_ARRAY or GL_TEXTURE_3D
+   * @param width width of the texture
+   * @param height height of the texture
+   * @param depth number of layers (arrays) or depth (3D textures)
+   * @param format pixel format of the data
+   * @param internal_format format the texture should be stored as
+   * @param pixels raw pixel data of every layer, one after another (or `nullptr`
+   *               to fill them later with `set_layer()`)
+   *
+   * @throws GL::Exception if the target is unsupported or the object fails to be constructed
+   */
+  Texture(GLenum target, int width, int height, int depth, GLenum format, GLenum internal_format,
+          const void* pixels);
+
   ~Texture();
 
+  /**
+   * @brief Takes ownership of another texture's underlying texture object
+   *
+   * @param other the texture to move from (left without a texture object)
+   */
+  Texture(Texture&& other) noexcept;
+
+  /**
+   * @brief Destroys the current texture object and takes ownership of another texture's
+   *
+   * @param other the texture to move from (left without a texture object)
+   */
+  Texture& operator=(Texture&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  Texture(const Texture&) = delete;
+  Texture& operator=(const Texture&) = delete;
+
   /**
    * @brief Binds the texture for use
    */
   void bind() const;
 
+  /**
+   * @brief Makes a texture unit active and binds the texture to it
+   *
+   * Note: Leaves `unit` as the active texture unit, and bypasses the
+   * `TextureUnits` cache (call `TextureUnits::get().invalidate()` if mixing them)
+   *
+   * @param unit the texture unit to bind to (0 for GL_TEXTURE0)
+   */
+  void bind(GLuint unit) const;
+
   /**
    * @brief Uploads raw data to part of the texture
    *
-   * Note: Must call `bind()` first!
+   * Note: Must call `bind()` first, unless the texture is `immutable()`
    *
    * @param x_offset the x offset into texture
    * @param y_offset the y offset into texture
@@ -77,11 +161,60 @@ public:
    */
   void sub_data(int x_offset, int y_offset, int width, int height, const void* data);
 
+  /**
+   * @brief Uploads raw data to a box of an array or 3D texture
+   *
+   * Note: Must call `bind()` first, unless the texture is `immutable()`
+   *
+   * @param x_offset the x offset into texture
+   * @param y_offset the y offset into texture
+   * @param z_offset the first layer (or depth offset) to upload to
+   * @param width the width of the data being uploaded
+   * @param height the height of the data being uploaded
+   * @param depth the number of layers (or depth) being uploaded
+   * @param data the raw pixel data to upload
+   *
+   * @throws GL::Exception if a 2D texture is given more than one layer
+   */
+  void sub_data(int x_offset, int y_offset, int z_offset, int width, int height, int depth,
+                const void* data);
+
+  /**
+   * @brief Replaces a whole layer of an array or 3D texture
+   *
+   * Note: Must call `bind()` first, unless the texture is `immutable()`
+   *
+   * @param layer the layer to replace
+   * @param data the raw pixel data of the layer
+   *
+   * @throws GL::Exception if the layer is out of range
+   */
+  void set_layer(int layer, const void* data);
+
+  /**
+   * @brief Fills the mipmap levels from level 0 on the GPU
+   *
+   * Useful for render targets, whose contents never reach the CPU. Textures
+   * with immutable storage only fill the levels they were created with.
+   *
+   * Note: Must call `bind()` first, unless the texture is `immutable()`
+   */
+  void generate_mipmaps();
+
   /**
    * @brief Unbinds the texture
    */
   void unbind() const;
 
+  /**
+   * @brief Deletes the texture now instead of returning its name to the pool
+   *
+   * A released name keeps its data store until it is reused, so this is the
+   * way to actually give the memory back (see `TextureResidency`). The
+   * texture is left empty.
+   */
+  void purge();
+
   /**
    * @brief Gets the width of the texture
    *
@@ -96,6 +229,20 @@ public:
    */
   int height() const { return height_; }
 
+  /**
+   * @brief Gets the number of layers (or depth) of the texture, 1 for 2D textures
+   *
+   * @return int representing the depth
+   */
+  int depth() const { return depth_; }
+
+  /**
+   * @brief Gets the target the texture binds to (e.g. GL_TEXTURE_2D_ARRAY)
+   *
+   * @return GLenum representing the target
+   */
+  GLenum target() const { return target_; }
+
   /**
    * @brief Gets the id assigned by OpenGL for this texture
    *
@@ -103,12 +250,66 @@ public:
    */
   GLuint id() const { return id_; }
 
+  /**
+   * @brief Gets the number of mipmap levels, including level 0
+   */
+  int levels() const { return levels_; }
+
+  /**
+   * @brief Whether the texture has immutable storage
+   *
+   * Only textures created with a sized internal format while
+   * `Capabilities::direct_state_access()` is true are immutable. They are
+   * edited by name, so they never need to be bound first.
+   */
+  bool immutable() const { return immutable_; }
+
+  /**
+   * @brief Gets the estimated size of every level in bytes
+   */
+  size_t byte_size() const { return byte_size_; }
+
+  /**
+   * @brief Gets the format the texture is stored as
+   */
+  GLenum internal_format() const { return internal_format_; }
+
 private:
+  /**
+   * @brief Creates a new texture of any target and uploads pixel data of any type
+   *
+   * @param target target of the texture (GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_3D)
+   * @param width width of the texture
+   * @param height height of the texture
+   * @param depth number of layers (or depth) of the texture, 1 for 2D textures
+   * @param format pixel format of the data
+   * @param type data type of the pixels (e.g. GL_UNSIGNED_BYTE)
+   * @param internal_format format the texture should be stored as
+   * @param unpack_alignment the unpack alignment OpenGL uses (usually 4)
+   * @param pixels raw pixel data of the texture
+   */
+  Texture(GLenum target, int width, int height, int depth, GLenum format, GLenum type,
+          GLenum internal_format, uint8_t unpack_alignment, const void* pixels);
+
+  /**
+   * @brief Runs pixels through a converter into a new buffer
+   */
+  static std::vector<uint8_t> convert(const PixelConverter& converter, const uint8_t* pixels,
+                                      size_t pixel_count);
+
   /**
    * @brief Generates a new texture
    */
   void generate();
 
+  /**
+   * @brief Creates the texture with immutable storage using direct state access
+   *
+   * @param internal_format the (sized) format the texture should be stored as
+   * @param data the raw pixel data to upload (or `nullptr`)
+   */
+  void create_storage(GLenum internal_format, const void* data);
+
   /**
    * @brief Sets the raw data of the texture
    *
@@ -117,26 +318,50 @@ private:
    */
   void set_data(GLenum internal_format, const void* data);
 
+  /**
+   * @brief Recomputes `byte_size_` and updates the memory tracker
+   */
+  void account();
+
   /**
    * @brief Sets the parameters for the texture
+   *
+   * These are only used when no sampler is bound to the unit.
    */
   void set_parameters();
 
   /**
    * @brief Destroys the texture
+   *
+   * @param recycle whether a mutable texture's name goes back to the pool
+   *                (immutable textures are always deleted)
    */
-  void destroy();
+  void destroy(bool recycle = true);
 
   /// The ID of underlying texture object
   GLuint id_ = 0;
+  /// The target the texture binds to
+  GLenum target_;
   /// The width of the texture
   int width_;
   /// The height of the texture
   int height_;
+  /// The number of layers (or depth) of the texture
+  int depth_ = 1;
   /// The pixel format of the texture
   GLenum format_;
+  /// The format the texture is stored as
+  GLenum internal_format_;
+  /// The data type of the pixels uploaded to the texture
+  GLenum type_;
   /// The alignment used to unpack the data (usually 4)
   uint8_t unpack_alignment_;
+  /// The number of mipmap levels
+  int levels_ = 1;
+  /// Whether the texture has immutable storage (and so can't go back to the pool)
+  bool immutable_ = false;
+  /// The estimated size of every level in bytes
+  size_t byte_size_ = 0;
 };
 }
 
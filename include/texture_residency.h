@@ -0,0 +1,186 @@
+//
+// texture_residency.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_TEXTURE_RESIDENCY_H
+#define BGL_TEXTURE_RESIDENCY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <OpenGL/gltypes.h>
+#include "texture.h"
+
+namespace BarelyGL {
+/**
+ * @class TextureResidency
+ * @brief Keeps the textures on the GPU within a memory budget
+ *
+ * The manager keeps every texture's pixels on the CPU and decides how much of
+ * each is resident. At the end of a frame, if the resident textures are over
+ * budget, the least recently bound ones are shrunk: first by dropping their
+ * top mip levels (each one dropped saves three quarters of what is left),
+ * then by evicting them entirely. A texture is restreamed at full size the
+ * next time it is bound. Nothing is ever read back from the GPU.
+ *
+ * Textures bound during the current frame are never shrunk, so the budget
+ * can be exceeded by a frame whose working set is larger than it.
+ *
+ * Note: Textures are 2D with the given mipmap chain (e.g. from
+ * `MipmapGenerator`). A texture without mipmaps can only be evicted.
+ */
+class TextureResidency
+{
+public:
+  /**
+   * @brief Identifies a texture added to the manager
+   */
+  typedef size_t Handle;
+
+  /**
+   * @brief Creates a manager with nothing resident
+   *
+   * @param budget the most bytes of texture memory to keep resident
+   * @param max_dropped_levels the most mip levels dropped before a texture is evicted
+   */
+  explicit TextureResidency(size_t budget, int max_dropped_levels = 2);
+
+  TextureResidency(const TextureResidency&) = delete;
+  TextureResidency& operator=(const TextureResidency&) = delete;
+
+  /**
+   * @brief Adds a texture, without uploading it until it is first bound
+   *
+   * @param width width of level 0
+   * @param height height of level 0
+   * @param format pixel format of the data
+   * @param internal_format format the texture should be stored as
+   * @param pixels the tightly packed pixels of level 0
+   * @param mipmaps the tightly packed pixels of levels 1 and below
+   *
+   * @return the handle to bind the texture with
+   */
+  Handle add(int width, int height, GLenum format, GLenum internal_format,
+             std::vector<uint8_t> pixels, std::vector<std::vector<uint8_t>> mipmaps = {});
+
+  /**
+   * @brief Destroys a texture and forgets its pixels
+   *
+   * @param handle the texture to remove (its handle may be reused)
+   */
+  void remove(Handle handle);
+
+  /**
+   * @brief Makes a texture fully resident and binds it to a unit
+   *
+   * @param handle the texture to bind
+   * @param unit the texture unit to bind to (via `TextureUnits`)
+   *
+   * @return the texture, which stays valid until the next `end_frame()`
+   *
+   * @throws GL::Exception if the handle is invalid or the texture fails to upload
+   */
+  const Texture& bind(Handle handle, GLuint unit);
+
+  /**
+   * @brief Shrinks the least recently bound textures until within budget, then
+   *        moves to the next frame
+   */
+  void end_frame();
+
+  /**
+   * @brief Sets the budget, taking effect at the next `end_frame()`
+   *
+   * @param budget the most bytes of texture memory to keep resident
+   */
+  void set_budget(size_t budget) { budget_ = budget; }
+
+  /**
+   * @brief Gets the most bytes of texture memory to keep resident
+   */
+  size_t budget() const { return budget_; }
+
+  /**
+   * @brief Gets the bytes of texture memory resident now
+   */
+  size_t resident_bytes() const;
+
+  /**
+   * @brief Gets how many top mip levels of a texture are dropped (0 if fully
+   *        resident or evicted)
+   */
+  int dropped_levels(Handle handle) const;
+
+  /**
+   * @brief Whether any of a texture is on the GPU
+   */
+  bool resident(Handle handle) const;
+
+  /**
+   * @brief Gets the number of times a texture has been restreamed after being shrunk
+   */
+  size_t restreams() const { return restreams_; }
+
+private:
+  /**
+   * @brief A texture's pixels and whatever of it is resident
+   */
+  struct Entry
+  {
+    /// The width of level 0
+    int width;
+    /// The height of level 0
+    int height;
+    /// The pixel format of the data
+    GLenum format;
+    /// The format the texture is stored as
+    GLenum internal_format;
+    /// The pixels of level 0
+    std::vector<uint8_t> pixels;
+    /// The pixels of levels 1 and below
+    std::vector<std::vector<uint8_t>> mipmaps;
+    /// The resident texture (or `nullptr` if evicted)
+    std::unique_ptr<Texture> texture;
+    /// The number of top levels left out of the resident texture
+    int dropped;
+    /// The frame the texture was last bound in
+    uint64_t last_used;
+    /// Whether the entry holds a texture (false once removed)
+    bool live;
+  };
+
+  /**
+   * @brief Gets a live entry
+   *
+   * @throws GL::Exception if the handle is invalid
+   */
+  Entry& entry(Handle handle);
+  const Entry& entry(Handle handle) const;
+
+  /**
+   * @brief Replaces the resident texture with one missing the top `dropped` levels
+   */
+  void upload(Entry& entry, int dropped);
+
+  /**
+   * @brief Destroys the resident texture, keeping the pixels
+   */
+  void evict(Entry& entry);
+
+  /// The most bytes to keep resident
+  size_t budget_;
+  /// The most mip levels dropped before evicting
+  int max_dropped_levels_;
+  /// The textures (removed ones are reused through `free_`)
+  std::vector<Entry> entries_;
+  /// The handles of removed entries
+  std::vector<Handle> free_;
+  /// The current frame
+  uint64_t frame_ = 0;
+  /// The number of restreams
+  size_t restreams_ = 0;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_TEXTURE_RESIDENCY_H)
@@ -0,0 +1,155 @@
+//
+// texture_units.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_TEXTURE_UNITS_H
+#define BGL_TEXTURE_UNITS_H
+
+#include <vector>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyGL {
+class Texture;
+class Sampler;
+
+/**
+ * @class TextureUnits
+ * @brief Binds textures and samplers to texture units, skipping bindings that haven't changed
+ *
+ * Keeps a copy of what is bound to each unit so a material that uses the
+ * same textures as the last one costs nothing to bind. Where
+ * `glBindTextures` (GL 4.4 or ARB_multi_bind) is available, a set of
+ * textures or samplers is bound in one call.
+ *
+ * Note: The cache only knows about bindings made through it, and the
+ * textures it binds. Creating a mutable `Texture` tells the cache that the
+ * active unit was rebound, and deleting a texture name (from a `Texture` or
+ * the `HandlePool`) or a `Sampler` which units it was bound to. Call `invalidate()` after
+ * binding textures any other way (including `Texture::bind()`).
+ */
+class TextureUnits
+{
+public:
+  /**
+   * @brief Gets the texture units of the current context
+   *
+   * Note: Must be first called with a context current
+   */
+  static TextureUnits& get();
+
+  TextureUnits(const TextureUnits&) = delete;
+  TextureUnits& operator=(const TextureUnits&) = delete;
+
+  /**
+   * @brief Binds a texture to a unit, unless it is already bound there
+   *
+   * May leave any unit active.
+   *
+   * @param unit the texture unit (0 for GL_TEXTURE0)
+   * @param texture the texture to bind (`nullptr` to unbind)
+   */
+  void bind(GLuint unit, const Texture* texture);
+
+  /**
+   * @brief Binds a texture and the sampler it should be read with to a unit
+   *
+   * @param unit the texture unit (0 for GL_TEXTURE0)
+   * @param texture the texture to bind (`nullptr` to unbind)
+   * @param sampler the sampler to bind (`nullptr` to use the texture's own parameters)
+   */
+  void bind(GLuint unit, const Texture* texture, const Sampler* sampler);
+
+  /**
+   * @brief Binds a set of textures to consecutive units
+   *
+   * Only the units whose texture changed are rebound. May leave any unit
+   * active.
+   *
+   * @param textures the textures to bind, in unit order (`nullptr` to unbind a unit)
+   * @param first_unit the unit the first texture is bound to
+   */
+  void bind(const std::vector<const Texture*>& textures, GLuint first_unit = 0);
+
+  /**
+   * @brief Binds a sampler to a unit, unless it is already bound there
+   *
+   * @param unit the texture unit (0 for GL_TEXTURE0)
+   * @param sampler the sampler to bind (`nullptr` to use the texture's own parameters)
+   */
+  void bind_sampler(GLuint unit, const Sampler* sampler);
+
+  /**
+   * @brief Binds a set of samplers to consecutive units
+   *
+   * @param samplers the samplers to bind, in unit order (`nullptr` to unbind a unit)
+   * @param first_unit the unit the first sampler is bound to
+   */
+  void bind_samplers(const std::vector<const Sampler*>& samplers, GLuint first_unit = 0);
+
+  /**
+   * @brief Forgets what is bound, so the next bind of each unit goes to OpenGL
+   */
+  void invalidate();
+
+  /**
+   * @brief Forgets what is bound to the active unit (or every unit, if the
+   *        active unit isn't known)
+   */
+  void invalidate_active();
+
+  /**
+   * @brief Forgets every unit a texture name is bound to, e.g. because it is
+   *        being deleted (which unbinds it, and the name may be reused)
+   *
+   * @param texture the texture name
+   */
+  void invalidate(GLuint texture);
+
+  /**
+   * @brief Forgets every unit a sampler name is bound to, e.g. because it is
+   *        being deleted
+   *
+   * @param sampler the sampler name
+   */
+  void invalidate_sampler(GLuint sampler);
+
+  /**
+   * @brief Gets the number of texture units
+   */
+  GLuint unit_count() const { return static_cast<GLuint>(bound_.size()); }
+
+private:
+  /**
+   * @brief Queries the number of units and whether multi-bind is supported
+   */
+  TextureUnits();
+
+  /**
+   * @brief Binds a texture to a unit with `glActiveTexture` and `glBindTexture`
+   *
+   * Binding a texture of a different target unbinds the unit's old target, so
+   * only one texture is ever bound per unit. A `nullptr` unbinds the old target.
+   */
+  void bind_single(GLuint unit, const Texture* texture);
+
+  /// The texture name bound to each unit (as far as the cache knows)
+  std::vector<GLuint> bound_;
+  /// Whether each entry of `bound_` is known (false after `invalidate()`)
+  std::vector<bool> known_;
+  /// The target of the texture bound to each unit
+  std::vector<GLenum> targets_;
+  /// The sampler name bound to each unit
+  std::vector<GLuint> samplers_;
+  /// Whether each entry of `samplers_` is known
+  std::vector<bool> samplers_known_;
+  /// The active texture unit (or -1 if unknown)
+  GLint active_unit_ = -1;
+  /// Whether `glBindTextures` can be used
+  bool multi_bind_ = false;
+  /// Scratch space for the names passed to `glBindTextures`
+  std::vector<GLuint> names_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_TEXTURE_UNITS_H)
@@ -0,0 +1,76 @@
+//
+// vertex_array_cache.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_VERTEX_ARRAY_CACHE_H
+#define BGL_VERTEX_ARRAY_CACHE_H
+
+#include <unordered_map>
+#include "vertex_array_object.h"
+#include "vertex_attribute_array.h"
+
+namespace BarelyGL {
+/**
+ * @class VertexArrayCache
+ * @brief Shares one VAO between every mesh with the same vertex format
+ *
+ * The VAO for a layout is created and has its format set the first time it
+ * is asked for. Drawing a mesh then only needs its buffers swapped in:
+ *    VertexArrayObject& vao = VertexArrayCache::get().vertex_array(layout);
+ *    vao.bind();
+ *    vao.bind_buffers(vertex_buffer, &index_buffer);
+ *    vao.draw(GL_TRIANGLES, &index_buffer);
+ *
+ * Note: The cache lives until the program exits, which is after the context
+ * is gone. Call `clear()` before destroying the context.
+ */
+class VertexArrayCache
+{
+public:
+  /**
+   * @brief Gets the shared cache
+   */
+  static VertexArrayCache& get();
+
+  /**
+   * @brief Creates an empty cache
+   */
+  VertexArrayCache();
+  VertexArrayCache(const VertexArrayCache&) = delete;
+  VertexArrayCache& operator=(const VertexArrayCache&) = delete;
+
+  /**
+   * @brief Gets the VAO for a layout, creating it the first time
+   *
+   * Note: Leaves no VAO bound if one was created
+   *
+   * @param attributes the layout of each vertex
+   *
+   * @return the VAO, which stays valid until `clear()`
+   *
+   * @throws GL::Exception if a new VAO could not be created
+   */
+  VertexArrayObject& vertex_array(const VertexAttributeArray& attributes);
+
+  /**
+   * @brief Destroys every VAO
+   *
+   * Note: Must be called while the context is still current, before it is
+   * destroyed, or the VAOs are deleted during static destruction.
+   */
+  void clear() { vertex_arrays_.clear(); }
+
+  /**
+   * @brief Gets the number of distinct formats
+   */
+  size_t size() const { return vertex_arrays_.size(); }
+
+private:
+  /// The VAOs, keyed by their layout
+  std::unordered_map<VertexAttributeArray, VertexArrayObject, VertexAttributeArrayHash>
+    vertex_arrays_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_VERTEX_ARRAY_CACHE_H)
@@ -40,18 +40,87 @@ public:
                     const IndexBufferObject* index_buffer = nullptr);
   ~VertexArrayObject();
 
+  /**
+   * @brief Takes ownership of another VAO's underlying vertex array
+   *
+   * @param other the VAO to move from (left without a vertex array)
+   */
+  VertexArrayObject(VertexArrayObject&& other) noexcept;
+
+  /**
+   * @brief Destroys the current vertex array and takes ownership of another VAO's
+   *
+   * @param other the VAO to move from (left without a vertex array)
+   */
+  VertexArrayObject& operator=(VertexArrayObject&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  VertexArrayObject(const VertexArrayObject&) = delete;
+  VertexArrayObject& operator=(const VertexArrayObject&) = delete;
+
   /**
    * @brief Binds the vertex array object
    */
   void bind() const;
 
+  /**
+   * @brief Points the VAO at a VBO (and optionally an IBO) with the given layout
+   *
+   * Unlike the setters below this configures the vertex array itself, so
+   * nothing needs to be bound first. With direct state access no bindings
+   * are changed at all; otherwise the VAO and VBO are bound to set it up and
+   * left unbound.
+   *
+   * @param attributes the layout of each vertex in the VBO
+   * @param vertex_buffer the VBO to read vertices from
+   * @param index_buffer the IBO to read indices from (or `nullptr`)
+   */
+  void attach(const VertexAttributeArray& attributes, const VertexBufferObject& vertex_buffer,
+              const IndexBufferObject* index_buffer = nullptr);
+
+  /**
+   * @brief Records the layout and sets the VAO's vertex format, reading from binding 0
+   *
+   * With `Capabilities::vertex_attrib_binding()` the format is set once and
+   * kept however often the buffers change. Otherwise it is only recorded, and
+   * `bind_buffers()` reissues it for each buffer.
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param attributes the layout of each vertex
+   */
+  void set_format(const VertexAttributeArray& attributes);
+
+  /**
+   * @brief Points the VAO's format at a VBO (and optionally an IBO)
+   *
+   * Only swaps buffer bindings, so switching between meshes with the same
+   * format is cheap (see `VertexArrayCache`).
+   *
+   * Note: Must call `bind()` and `set_format()` first, unless
+   * `Capabilities::direct_state_access()`. Without
+   * `Capabilities::vertex_attrib_binding()` this leaves the VBO bound.
+   *
+   * @param vertex_buffer the VBO to read vertices from
+   * @param index_buffer the IBO to read indices from (or `nullptr`)
+   */
+  void bind_buffers(const VertexBufferObject& vertex_buffer,
+                    const IndexBufferObject* index_buffer = nullptr);
+
   /**
    * @brief Sets the attributes associated with the VAO
    *
+   * Only records the layout; use `set_format()` to also configure the VAO.
+   *
    * @param attributes to vertext attribute array to be associated with the VAO
    */
   void set_attributes(const VertexAttributeArray& attributes);
 
+  /**
+   * @brief Gets the layout recorded for the VAO
+   */
+  const VertexAttributeArray& attributes() const { return attributes_; }
+
   /**
    * @brief Sets the VBO associated with the VAO
    *
@@ -109,9 +178,11 @@ private:
   /// The ID of underlying vertext array object
   GLuint id_ = 0;
   /// The VBO associated with the VAO
-  const VertexBufferObject* vertex_buffer_;
+  const VertexBufferObject* vertex_buffer_ = nullptr;
   /// The IBO associated with the VAO
-  const IndexBufferObject* index_buffer_;
+  const IndexBufferObject* index_buffer_ = nullptr;
+  /// The layout of each vertex
+  VertexAttributeArray attributes_;
   /// The amount of attributes per vertex
   int vertex_size_ = 0;
 };
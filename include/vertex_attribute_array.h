@@ -7,6 +7,9 @@
 #define BGL_VERTEX_ATTRIBUTE_ARRAY_H
 
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <OpenGL/gltypes.h>
 
 namespace BarelyGL {
 /**
@@ -54,6 +57,13 @@ public:
    */
   uint8_t size() const { return size_; }
 
+  /**
+   * @brief Gets the attributes in the array
+   *
+   * @return the list of vertex attributes, in order
+   */
+  const std::vector<VertexAttribute>& attributes() const { return attributes_; }
+
   /**
    * @brief Set the attributes in the vertex attribute array
    *
@@ -63,8 +73,35 @@ public:
 
   /**
    * @brief Enable and set the pointers for each attribute in the array
+   *
+   * Ties the format to the buffer bound to GL_ARRAY_BUFFER, so it must be
+   * reissued whenever the buffer changes.
+   */
+  void enable() const;
+
+  /**
+   * @brief Enable each attribute and set its format, reading from one binding point
+   *
+   * The format doesn't refer to a buffer, so the bound VAO keeps it while the
+   * buffer at `binding` is swapped with `glBindVertexBuffer`.
+   *
+   * Note: Needs `Capabilities::vertex_attrib_binding()`
+   *
+   * @param binding the vertex buffer binding point every attribute reads from
    */
-  void enable();
+  void set_format(GLuint binding = 0) const;
+
+  /**
+   * @brief Whether two arrays describe the same layout
+   */
+  bool operator==(const VertexAttributeArray& other) const;
+
+  /**
+   * @brief Hashes the layout
+   *
+   * @return a hash of the attribute sizes, in order
+   */
+  size_t hash() const;
 
 private:
   /// The list of vertext attributes in the array
@@ -72,6 +109,15 @@ private:
   /// The number of vertices described by the attribute array
   uint8_t size_;
 };
+
+/**
+ * @struct VertexAttributeArrayHash
+ * @brief Hashes a `VertexAttributeArray` for use as an unordered map key
+ */
+struct VertexAttributeArrayHash
+{
+  size_t operator()(const VertexAttributeArray& attributes) const { return attributes.hash(); }
+};
 } // end of namespace BarelyGL
 
 #endif // defined(BGL_VERTEX_ATTRIBUTE_ARRAY_H)
@@ -31,6 +31,24 @@ public:
   VertexBufferObject(GLenum target, GLenum usage);
   ~VertexBufferObject();
 
+  /**
+   * @brief Takes ownership of another VBO's underlying buffer
+   *
+   * @param other the VBO to move from (left without a buffer)
+   */
+  VertexBufferObject(VertexBufferObject&& other) noexcept;
+
+  /**
+   * @brief Destroys the current buffer and takes ownership of another VBO's
+   *
+   * @param other the VBO to move from (left without a buffer)
+   */
+  VertexBufferObject& operator=(VertexBufferObject&& other) noexcept;
+
+  // Copying would leave two wrappers deleting the same OpenGL object
+  VertexBufferObject(const VertexBufferObject&) = delete;
+  VertexBufferObject& operator=(const VertexBufferObject&) = delete;
+
   /**
    * @brief Binds the buffer
    */
@@ -39,21 +57,73 @@ public:
   /**
    * @brief Initialize the buffer data store without uploading any data
    *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
    * @param size the size of data store to allocate
+   *
+   * @throws GL::Exception if the buffer has immutable storage
    */
   void init_buffer(GLsizeiptr size);
 
   /**
    * @brief Set the vertices for the buffer, recreating the data store
    *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
    * @param vertices array of floats to be used as vertices
+   *
+   * @throws GL::Exception if the buffer has immutable storage
    */
   void set_vertices(const std::vector<float>& vertices);
 
+  /**
+   * @brief Set the vertices from memory it doesn't own, recreating the data store
+   *
+   * Useful for uploading straight from a memory-mapped file.
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param vertices pointer to the first float
+   * @param count the number of floats
+   *
+   * @throws GL::Exception if the buffer has immutable storage
+   */
+  void set_vertices(const float* vertices, size_t count);
+
+  /**
+   * @brief Set the vertices for the buffer in a data store that can't be resized
+   *
+   * With direct state access this allocates immutable storage, after which
+   * only `sub_vertices` can change the contents. Otherwise it is the same as
+   * `set_vertices`.
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param vertices array of floats to be used as vertices
+   *
+   * @throws GL::Exception if the buffer already has immutable storage
+   */
+  void set_storage(const std::vector<float>& vertices);
+
+  /**
+   * @brief Set the vertices from memory it doesn't own, in a data store that can't be resized
+   *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
+   * @param vertices pointer to the first float
+   * @param count the number of floats
+   *
+   * @throws GL::Exception if the buffer already has immutable storage
+   */
+  void set_storage(const float* vertices, size_t count);
+
   /**
    * @brief Set the vertices for the buffer, replacing data in the store
    *
+   * Note: Must call `bind()` first, unless `Capabilities::direct_state_access()`
+   *
    * @param vertices array of floats to be used as vertices
+   * @param offset the offset into the buffer (in bytes)
    */
   void sub_vertices(const std::vector<float>& vertices, GLintptr offset = 0);
 
@@ -69,12 +139,30 @@ public:
    */
   size_t size() const { return vertex_count_; }
 
+  /**
+   * @brief Gets the size of the data store in bytes
+   */
+  size_t byte_size() const { return byte_size_; }
+
+  /**
+   * @brief The ID of the underlying OpenGL object
+   */
+  GLuint id() const { return id_; }
+
 private:
   /**
    * @brief Generate the buffer
    */
   void generate_buffer();
 
+  /**
+   * @brief Recreates the (mutable) data store
+   *
+   * @param size the size of the data store in bytes
+   * @param data the data to fill it with (or `nullptr`)
+   */
+  void set_data(GLsizeiptr size, const void* data);
+
   /**
    * @brief Destroy the buffer
    */
@@ -87,7 +175,11 @@ private:
   /// The usage pattern of the buffer
   GLenum usage_;
   /// The number of vertices in the buffer
-  size_t vertex_count_;
+  size_t vertex_count_ = 0;
+  /// Whether the buffer has immutable storage (and so can't go back to the pool)
+  bool immutable_ = false;
+  /// The size of the data store in bytes
+  size_t byte_size_ = 0;
 };
 }
 #endif /* defined(BGL_VERTEX_BUFFER_OBJECT_H) */
@@ -0,0 +1,104 @@
+//
+// vertex_welder.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BGL_VERTEX_WELDER_H
+#define BGL_VERTEX_WELDER_H
+
+#include <vector>
+#include <cstddef>
+#include "vertex_attribute_array.h"
+
+namespace BarelyGL {
+class VertexBufferObject;
+class IndexBufferObject;
+
+/**
+ * @struct WeldedMesh
+ * @brief Compact, indexed vertex data produced by `VertexWelder`
+ */
+struct WeldedMesh
+{
+  /// The unique vertices, in order of first appearance in the soup
+  std::vector<float> vertices;
+  /// One index per vertex of the soup (so the triangles are unchanged)
+  std::vector<int> indices;
+
+  /**
+   * @brief Uploads the vertices and indices into a VBO and IBO
+   *
+   * Note: Must call `bind()` on both buffers first!
+   *
+   * @param vertex_buffer the VBO to upload the vertices to
+   * @param index_buffer the IBO to upload the indices to
+   */
+  void upload(VertexBufferObject& vertex_buffer, IndexBufferObject& index_buffer) const;
+};
+
+/**
+ * @class VertexWelder
+ * @brief Turns unindexed vertex streams (triangle soups) into indexed meshes
+ *
+ * Duplicate vertices are found by hashing every value of the vertex, so two
+ * vertices are only merged if all of their attributes match. Large soups are
+ * split across threads by hash, which means each thread owns every copy of
+ * the vertices it sees and no locking is needed.
+ */
+class VertexWelder
+{
+public:
+  /**
+   * @brief Creates a welder
+   *
+   * With an epsilon, values are snapped to a grid of that size before being
+   * compared. Values that are close but fall either side of a grid line are
+   * not merged, so this catches exporter noise rather than every pair of
+   * vertices within epsilon of each other.
+   *
+   * @param epsilon the tolerance used when comparing values (0 for exact)
+   * @param thread_count the most threads to use (0 uses one per core)
+   */
+  VertexWelder(float epsilon = 0.0f, size_t thread_count = 0);
+
+  /**
+   * @brief Removes duplicate vertices from a triangle soup
+   *
+   * @param soup the vertex data, three vertices per triangle
+   * @param attributes the attributes describing the vertex data
+   *
+   * @return the unique vertices and the indices into them
+   */
+  WeldedMesh weld(const std::vector<float>& soup, const VertexAttributeArray& attributes) const;
+
+private:
+  /**
+   * @brief Hashes every vertex in the range [first, last)
+   */
+  void hash_vertices(const float* soup, size_t stride, size_t first, size_t last,
+                     std::vector<uint32_t>& hashes) const;
+
+  /**
+   * @brief Finds the first copy of every vertex whose hash falls in `bucket`
+   */
+  void find_duplicates(const float* soup, size_t stride, const std::vector<uint32_t>& hashes,
+                       size_t bucket, size_t bucket_count, std::vector<int>& canonical) const;
+
+  /**
+   * @brief Whether two vertices are considered the same
+   */
+  bool equal(const float* a, const float* b, size_t stride) const;
+
+  /**
+   * @brief Converts a value into the integer it is compared and hashed by
+   */
+  int64_t quantize(float value) const;
+
+  /// The tolerance used when comparing values (0 for exact)
+  float epsilon_;
+  /// The most threads to use
+  size_t thread_count_;
+};
+} // end of namespace BarelyGL
+
+#endif // defined(BGL_VERTEX_WELDER_H)
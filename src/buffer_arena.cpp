@@ -0,0 +1,256 @@
+//
+// buffer_arena.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <OpenGL/gl3.h>
+#include "buffer_arena.h"
+#include "exception.h"
+
+namespace BarelyGL {
+BufferArena::BufferArena(const VertexAttributeArray& attributes, const size_t vertex_capacity,
+                         const size_t index_capacity, const GLenum usage)
+  : attributes_(attributes)
+  , usage_(usage)
+  , vertex_buffer_(GL_ARRAY_BUFFER, usage)
+  , index_buffer_(GL_ELEMENT_ARRAY_BUFFER, usage)
+  , vertex_ranges_(vertex_capacity)
+  , index_ranges_(index_capacity)
+{
+  if (attributes_.size() == 0) throw Exception("Buffer arena needs vertex attributes");
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.init_buffer(vertex_capacity * attributes_.size());
+  index_buffer_.bind();
+  index_buffer_.init_buffer(index_capacity);
+  array_.unbind();
+  vertex_buffer_.unbind();
+
+  setup_array();
+}
+
+BufferArena::Handle BufferArena::allocate(const std::vector<float>& vertices,
+                                          const std::vector<int>& indices)
+{
+  size_t vertex_count = vertices.size() / attributes_.size();
+  size_t index_count = indices.size();
+
+  if (vertex_count == 0 || index_count == 0) throw Exception("Cannot allocate an empty mesh");
+  if (vertices.size() % attributes_.size() != 0) throw Exception("Mesh has a partial vertex");
+
+  if (vertex_count > vertex_ranges_.free_size() || index_count > index_ranges_.free_size())
+  {
+    throw Exception("Buffer arena is out of space");
+  }
+
+  if (vertex_ranges_.largest_free() < vertex_count || index_ranges_.largest_free() < index_count)
+  {
+    defragment();
+  }
+
+  size_t first_vertex = vertex_ranges_.allocate(vertex_count);
+  size_t first_index = index_ranges_.allocate(index_count);
+
+  Range range;
+  range.base_vertex = static_cast<GLint>(first_vertex);
+  range.vertex_count = static_cast<GLsizei>(vertex_count);
+  range.first_index = static_cast<GLsizei>(first_index);
+  range.index_count = static_cast<GLsizei>(index_count);
+
+  // Bind the arena's own VAO so that binding the IBO doesn't clobber the
+  // element buffer of whatever VAO the caller had bound, then put theirs back
+  GLint previous_array = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_array);
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.sub_vertices(vertices, first_vertex * attributes_.size() * sizeof(float));
+  index_buffer_.bind();
+  index_buffer_.sub_indices(indices, first_index);
+  glBindVertexArray(previous_array);
+  vertex_buffer_.unbind();
+
+  Handle handle;
+
+  if (free_handles_.empty())
+  {
+    handle = entries_.size();
+    entries_.push_back(Entry {range, true});
+  }
+  else
+  {
+    handle = free_handles_.back();
+    free_handles_.pop_back();
+    entries_[handle] = Entry {range, true};
+  }
+
+  return handle;
+}
+
+void BufferArena::free(const Handle handle)
+{
+  Entry& entry = entries_[handle];
+
+  if (!entry.live) return;
+
+  vertex_ranges_.free(entry.range.base_vertex, entry.range.vertex_count);
+  index_ranges_.free(entry.range.first_index, entry.range.index_count);
+
+  entry.live = false;
+  free_handles_.push_back(handle);
+}
+
+void BufferArena::bind() const
+{
+  array_.bind();
+}
+
+void BufferArena::draw(const GLenum mode, const Handle handle) const
+{
+  const Range& range = entries_[handle].range;
+
+  uintptr_t byte_offset = range.first_index * sizeof(int);
+
+  glDrawElementsBaseVertex(mode,               // drawing mode
+                           range.index_count,  // number of indices to draw
+                           GL_UNSIGNED_INT,    // type of the indices
+                           (void*)byte_offset, // offset to the first index
+                           range.base_vertex   // value added to every index
+                          );
+}
+
+void BufferArena::unbind() const
+{
+  array_.unbind();
+}
+
+/*
+ * Copies every live range (in order of where it currently is) into a new pair
+ * of buffers, packed one after the other. Copying between two buffers avoids
+ * the overlapping source and destination ranges that compacting in place
+ * would cause. Indices are relative to the base vertex, so only the ranges
+ * need updating. The caller's VAO binding is restored afterwards.
+ */
+void BufferArena::defragment()
+{
+  GLint previous_array = 0;
+  glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_array);
+
+  std::vector<Handle> live;
+
+  for (Handle handle = 0; handle < entries_.size(); ++handle)
+  {
+    if (entries_[handle].live) live.push_back(handle);
+  }
+
+  const GLsizeiptr vertex_bytes = attributes_.size() * sizeof(float);
+
+  VertexBufferObject vertex_buffer(GL_ARRAY_BUFFER, usage_);
+  vertex_buffer.bind();
+  vertex_buffer.init_buffer(vertex_ranges_.capacity() * attributes_.size());
+  vertex_buffer.unbind();
+
+  IndexBufferObject index_buffer(GL_ELEMENT_ARRAY_BUFFER, usage_);
+  array_.bind();
+  index_buffer.bind();
+  index_buffer.init_buffer(index_ranges_.capacity());
+  array_.unbind();
+
+  // Vertices
+  std::sort(live.begin(), live.end(), [this](Handle a, Handle b) {
+    return entries_[a].range.base_vertex < entries_[b].range.base_vertex;
+  });
+
+  glBindBuffer(GL_COPY_READ_BUFFER, vertex_buffer_.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vertex_buffer.id());
+
+  GLint next_vertex = 0;
+
+  for (Handle handle : live)
+  {
+    Range& range = entries_[handle].range;
+
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        range.base_vertex * vertex_bytes,
+                        next_vertex * vertex_bytes,
+                        range.vertex_count * vertex_bytes);
+
+    range.base_vertex = next_vertex;
+    next_vertex += range.vertex_count;
+  }
+
+  // Indices
+  std::sort(live.begin(), live.end(), [this](Handle a, Handle b) {
+    return entries_[a].range.first_index < entries_[b].range.first_index;
+  });
+
+  glBindBuffer(GL_COPY_READ_BUFFER, index_buffer_.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, index_buffer.id());
+
+  GLsizei next_index = 0;
+
+  for (Handle handle : live)
+  {
+    Range& range = entries_[handle].range;
+
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        range.first_index * sizeof(int),
+                        next_index * sizeof(int),
+                        range.index_count * sizeof(int));
+
+    range.first_index = next_index;
+    next_index += range.index_count;
+  }
+
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  vertex_buffer_ = std::move(vertex_buffer);
+  index_buffer_ = std::move(index_buffer);
+
+  vertex_ranges_.reset(next_vertex);
+  index_ranges_.reset(next_index);
+
+  setup_array();
+  glBindVertexArray(previous_array);
+}
+
+BufferArena::Stats BufferArena::stats() const
+{
+  Stats stats;
+
+  stats.allocations = entries_.size() - free_handles_.size();
+  stats.vertex_capacity = vertex_ranges_.capacity();
+  stats.vertices_used = vertex_ranges_.capacity() - vertex_ranges_.free_size();
+  stats.index_capacity = index_ranges_.capacity();
+  stats.indices_used = index_ranges_.capacity() - index_ranges_.free_size();
+  stats.vertex_fragmentation = vertex_ranges_.fragmentation();
+  stats.index_fragmentation = index_ranges_.fragmentation();
+
+  size_t vertex_bytes = attributes_.size() * sizeof(float);
+  size_t capacity = stats.vertex_capacity * vertex_bytes + stats.index_capacity * sizeof(int);
+  size_t used = stats.vertices_used * vertex_bytes + stats.indices_used * sizeof(int);
+
+  stats.utilization = capacity > 0 ? static_cast<float>(used) / capacity : 0.0f;
+
+  return stats;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void BufferArena::setup_array()
+{
+  array_.bind();
+  vertex_buffer_.bind();
+  attributes_.enable();
+  index_buffer_.bind();
+  array_.unbind();
+  vertex_buffer_.unbind();
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,48 @@
+//
+// capabilities.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "capabilities.h"
+
+namespace BarelyGL {
+const Capabilities& Capabilities::get()
+{
+  static Capabilities capabilities;
+  return capabilities;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+Capabilities::Capabilities()
+{
+  glGetIntegerv(GL_MAJOR_VERSION, &major_);
+  glGetIntegerv(GL_MINOR_VERSION, &minor_);
+
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+  for (GLint i = 0; i < count; ++i)
+  {
+    const GLubyte* name = glGetStringi(GL_EXTENSIONS, i);
+
+    if (name != nullptr) extensions_.insert(reinterpret_cast<const char*>(name));
+  }
+
+#if defined(GL_VERSION_4_3)
+  compute_shaders_ = version_at_least(4, 3) ||
+                     (has_extension("GL_ARB_compute_shader") &&
+                      has_extension("GL_ARB_shader_storage_buffer_object"));
+  vertex_attrib_binding_ = version_at_least(4, 3) || has_extension("GL_ARB_vertex_attrib_binding");
+#endif
+
+#if defined(GL_VERSION_4_5)
+  direct_state_access_ = version_at_least(4, 5) || has_extension("GL_ARB_direct_state_access");
+#endif
+}
+} // end of namespace BarelyGL
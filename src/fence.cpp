@@ -0,0 +1,99 @@
+//
+// fence.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "fence.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/// How long each wait in an unbounded `wait()` lasts, in nanoseconds
+const GLuint64 kWaitSlice = 100000000;
+}
+
+Fence::Fence(Fence&& other) noexcept
+  : sync_(other.sync_)
+{
+  other.sync_ = nullptr;
+}
+
+Fence& Fence::operator=(Fence&& other) noexcept
+{
+  if (this != &other)
+  {
+    reset();
+
+    sync_ = other.sync_;
+    other.sync_ = nullptr;
+  }
+
+  return *this;
+}
+
+void Fence::place(const bool flush)
+{
+  reset();
+
+  sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  if (sync_ == nullptr) throw Exception("Could not create fence");
+
+  if (flush) glFlush();
+}
+
+bool Fence::signalled()
+{
+  return wait(0);
+}
+
+/*
+ * The sync object is deleted as soon as it is seen signalled, since it can
+ * never become unsignalled again
+ */
+bool Fence::wait(const GLuint64 timeout)
+{
+  if (sync_ == nullptr) return true;
+
+  GLenum status = glClientWaitSync(sync_, timeout > 0 ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+
+  if (status == GL_TIMEOUT_EXPIRED) return false;
+
+  reset();
+
+  if (status == GL_WAIT_FAILED) throw Exception("Fence wait failed");
+
+  return true;
+}
+
+/*
+ * Waits in slices rather than with one huge timeout, which some drivers
+ * handle badly
+ */
+void Fence::wait()
+{
+  while (!wait(kWaitSlice))
+  {
+  }
+}
+
+void Fence::gpu_wait() const
+{
+  if (sync_ != nullptr) glWaitSync(sync_, 0, GL_TIMEOUT_IGNORED);
+}
+
+void Fence::reset()
+{
+  if (sync_ != nullptr)
+  {
+    glDeleteSync(sync_);
+    sync_ = nullptr;
+  }
+}
+
+Fence::~Fence()
+{
+  reset();
+}
+} // end of namespace BarelyGL
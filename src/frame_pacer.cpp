@@ -0,0 +1,53 @@
+//
+// frame_pacer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "frame_pacer.h"
+
+namespace BarelyGL {
+FramePacer::FramePacer(const size_t frames_in_flight)
+  : fences_(frames_in_flight > 0 ? frames_in_flight : 1)
+{
+}
+
+/*
+ * Only blocks when the fence isn't already signalled, so a frame that
+ * doesn't stall costs a single non-blocking check
+ */
+void FramePacer::begin_frame()
+{
+  Fence& fence = fences_[slot()];
+  last_wait_ = std::chrono::nanoseconds(0);
+
+  if (fence.signalled()) return;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  fence.wait();
+
+  last_wait_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now() - start);
+  total_wait_ += last_wait_;
+  ++stalled_frames_;
+}
+
+void FramePacer::end_frame()
+{
+  // The swap that follows flushes the commands
+  fences_[slot()].place(false);
+  ++frame_;
+}
+
+/*
+ * A frame that has fallen out of the ring must have been waited on already,
+ * and a frame still in it has its fence in its slot
+ */
+bool FramePacer::is_complete(const uint64_t frame)
+{
+  if (frame >= frame_) return false;
+  if (frame_ - frame > fences_.size()) return true;
+
+  return fences_[static_cast<size_t>(frame % fences_.size())].signalled();
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,180 @@
+//
+// framebuffer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "framebuffer.h"
+#include "texture.h"
+#include "renderbuffer.h"
+#include "capabilities.h"
+#include "exception.h"
+
+namespace BarelyGL {
+/*
+ * Framebuffers aren't taken from the handle pool, since a recycled one would
+ * keep its old attachments and the next owner may not replace all of them
+ */
+Framebuffer::Framebuffer()
+{
+  glGenFramebuffers(1, &id_);
+
+  if (id_ == 0)
+  {
+    throw Exception("Could not generate framebuffer");
+  }
+}
+
+Framebuffer::Framebuffer(Framebuffer&& other) noexcept
+  : id_(other.id_)
+{
+  other.id_ = 0;
+}
+
+Framebuffer& Framebuffer::operator=(Framebuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+
+    other.id_ = 0;
+  }
+
+  return *this;
+}
+
+void Framebuffer::bind() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, id_);
+}
+
+void Framebuffer::unbind() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::attach(const GLenum attachment, const Texture& texture, const int level)
+{
+  if (texture.target() == GL_TEXTURE_2D)
+  {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture.id(), level);
+  }
+  else
+  {
+    glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture.id(), level);
+  }
+}
+
+void Framebuffer::attach_layer(const GLenum attachment, const Texture& texture, const int layer,
+                               const int level)
+{
+  glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, texture.id(), level, layer);
+}
+
+void Framebuffer::attach(const GLenum attachment, const Renderbuffer& renderbuffer)
+{
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer.id());
+}
+
+void Framebuffer::detach(const GLenum attachment)
+{
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, 0);
+}
+
+void Framebuffer::set_draw_buffers(const std::vector<GLenum>& buffers)
+{
+  if (buffers.empty())
+  {
+    glDrawBuffer(GL_NONE);
+  }
+  else
+  {
+    glDrawBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+  }
+}
+
+void Framebuffer::check() const
+{
+  switch (glCheckFramebufferStatus(GL_FRAMEBUFFER))
+  {
+    case GL_FRAMEBUFFER_COMPLETE:
+      return;
+    case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
+      throw Exception("Framebuffer incomplete: an attachment is incomplete");
+    case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
+      throw Exception("Framebuffer incomplete: no attachments");
+    case GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER:
+      throw Exception("Framebuffer incomplete: a draw buffer has no attachment");
+    case GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER:
+      throw Exception("Framebuffer incomplete: the read buffer has no attachment");
+    case GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE:
+      throw Exception("Framebuffer incomplete: attachments have different sample counts");
+    case GL_FRAMEBUFFER_UNSUPPORTED:
+      throw Exception("Framebuffer incomplete: combination of formats is unsupported");
+    default:
+      throw Exception("Framebuffer incomplete");
+  }
+}
+
+void Framebuffer::blit_to(const Framebuffer* destination, const int width, const int height,
+                          const GLbitfield mask, const GLenum filter) const
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, id_);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination != nullptr ? destination->id() : 0);
+
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, filter);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/*
+ * A multisampled blit must be the same size on both sides, and the filter
+ * has no effect, so nearest is used
+ */
+void Framebuffer::resolve_to(const Framebuffer* destination, const int width,
+                             const int height) const
+{
+  blit_to(destination, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+/*
+ * `glInvalidateFramebuffer` is GL 4.3 (or ARB_invalidate_subdata), so it is
+ * compiled out against older headers and skipped on older contexts
+ */
+void Framebuffer::invalidate(const std::vector<GLenum>& attachments)
+{
+  if (attachments.empty()) return;
+
+#if defined(GL_VERSION_4_3)
+  const Capabilities& caps = Capabilities::get();
+
+  if (caps.version_at_least(4, 3) || caps.has_extension("GL_ARB_invalidate_subdata"))
+  {
+    glInvalidateFramebuffer(GL_FRAMEBUFFER, static_cast<GLsizei>(attachments.size()),
+                            attachments.data());
+  }
+#endif
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void Framebuffer::destroy()
+{
+  if (id_ != 0)
+  {
+    glDeleteFramebuffers(1, &id_);
+    id_ = 0;
+  }
+}
+
+Framebuffer::~Framebuffer()
+{
+  destroy();
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,372 @@
+//
+// frustum_culler.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <glm/glm.hpp>
+#include "frustum_culler.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define BGL_CULL_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define BGL_CULL_NEON
+#endif
+
+namespace BarelyGL {
+namespace {
+/// Sets with fewer objects than this are culled on the calling thread
+const size_t kParallelThreshold = 16384;
+
+/*
+ * Extracts the six frustum planes from a view-projection matrix (Gribb &
+ * Hartmann). glm is column major, so row i of the matrix is m[0][i]..m[3][i].
+ * The planes are normalized so the sphere test can compare against the radius
+ */
+void extract_planes(const glm::mat4& m, float* planes)
+{
+  for (int i = 0; i < 6; ++i)
+  {
+    int row = i / 2;
+    float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+    float* plane = planes + i * 4;
+
+    for (int column = 0; column < 4; ++column)
+    {
+      plane[column] = m[column][3] + sign * m[column][row];
+    }
+
+    float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+    if (length > 0.0f)
+    {
+      for (int k = 0; k < 4; ++k) plane[k] /= length;
+    }
+  }
+}
+/**
+ * @brief Pointers to the bounds arrays, for the kernels below
+ */
+struct Bounds
+{
+  const float *min_x, *min_y, *min_z;
+  const float *max_x, *max_y, *max_z;
+  const float *center_x, *center_y, *center_z;
+  const float* radius;
+};
+
+/// Tests whole SIMD blocks from `i`, returning where the scalar tail starts
+typedef size_t (*CullKernel)(const Bounds&, const float*, size_t, size_t, std::vector<uint32_t>&);
+
+size_t cull_none(const Bounds&, const float*, const size_t i, const size_t,
+                 std::vector<uint32_t>&)
+{
+  return i;
+}
+
+#if defined(BGL_CULL_X86)
+__attribute__((target("sse2")))
+size_t cull_sse2(const Bounds& bounds, const float* planes, size_t i, const size_t last,
+                 std::vector<uint32_t>& visible)
+{
+  for (; i + 4 <= last; i += 4)
+  {
+    __m128 min_x = _mm_loadu_ps(bounds.min_x + i), max_x = _mm_loadu_ps(bounds.max_x + i);
+    __m128 min_y = _mm_loadu_ps(bounds.min_y + i), max_y = _mm_loadu_ps(bounds.max_y + i);
+    __m128 min_z = _mm_loadu_ps(bounds.min_z + i), max_z = _mm_loadu_ps(bounds.max_z + i);
+    __m128 c_x = _mm_loadu_ps(bounds.center_x + i);
+    __m128 c_y = _mm_loadu_ps(bounds.center_y + i);
+    __m128 c_z = _mm_loadu_ps(bounds.center_z + i);
+    __m128 r = _mm_loadu_ps(bounds.radius + i);
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (int p = 0; p < 6; ++p)
+    {
+      __m128 n_x = _mm_set1_ps(planes[p * 4 + 0]);
+      __m128 n_y = _mm_set1_ps(planes[p * 4 + 1]);
+      __m128 n_z = _mm_set1_ps(planes[p * 4 + 2]);
+      __m128 d = _mm_set1_ps(planes[p * 4 + 3]);
+
+      __m128 sphere = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n_x, c_x), _mm_mul_ps(n_y, c_y)),
+                                 _mm_add_ps(_mm_mul_ps(n_z, c_z), _mm_add_ps(d, r)));
+      __m128 box = _mm_add_ps(
+        _mm_add_ps(_mm_max_ps(_mm_mul_ps(n_x, min_x), _mm_mul_ps(n_x, max_x)),
+                   _mm_max_ps(_mm_mul_ps(n_y, min_y), _mm_mul_ps(n_y, max_y))),
+        _mm_add_ps(_mm_max_ps(_mm_mul_ps(n_z, min_z), _mm_mul_ps(n_z, max_z)), d));
+
+      __m128 distance = _mm_min_ps(sphere, box);
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+    }
+
+    int mask = _mm_movemask_ps(inside);
+
+    for (int lane = 0; mask != 0; ++lane, mask >>= 1)
+    {
+      if (mask & 1) visible.push_back(static_cast<uint32_t>(i + lane));
+    }
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2")))
+size_t cull_avx2(const Bounds& bounds, const float* planes, size_t i, const size_t last,
+                 std::vector<uint32_t>& visible)
+{
+  for (; i + 8 <= last; i += 8)
+  {
+    __m256 min_x = _mm256_loadu_ps(bounds.min_x + i), max_x = _mm256_loadu_ps(bounds.max_x + i);
+    __m256 min_y = _mm256_loadu_ps(bounds.min_y + i), max_y = _mm256_loadu_ps(bounds.max_y + i);
+    __m256 min_z = _mm256_loadu_ps(bounds.min_z + i), max_z = _mm256_loadu_ps(bounds.max_z + i);
+    __m256 c_x = _mm256_loadu_ps(bounds.center_x + i);
+    __m256 c_y = _mm256_loadu_ps(bounds.center_y + i);
+    __m256 c_z = _mm256_loadu_ps(bounds.center_z + i);
+    __m256 r = _mm256_loadu_ps(bounds.radius + i);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    for (int p = 0; p < 6; ++p)
+    {
+      __m256 n_x = _mm256_set1_ps(planes[p * 4 + 0]);
+      __m256 n_y = _mm256_set1_ps(planes[p * 4 + 1]);
+      __m256 n_z = _mm256_set1_ps(planes[p * 4 + 2]);
+      __m256 d = _mm256_set1_ps(planes[p * 4 + 3]);
+
+      __m256 sphere = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(n_x, c_x), _mm256_mul_ps(n_y, c_y)),
+                                    _mm256_add_ps(_mm256_mul_ps(n_z, c_z), _mm256_add_ps(d, r)));
+      __m256 box = _mm256_add_ps(
+        _mm256_add_ps(_mm256_max_ps(_mm256_mul_ps(n_x, min_x), _mm256_mul_ps(n_x, max_x)),
+                      _mm256_max_ps(_mm256_mul_ps(n_y, min_y), _mm256_mul_ps(n_y, max_y))),
+        _mm256_add_ps(_mm256_max_ps(_mm256_mul_ps(n_z, min_z), _mm256_mul_ps(n_z, max_z)), d));
+
+      __m256 distance = _mm256_min_ps(sphere, box);
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+
+    int mask = _mm256_movemask_ps(inside);
+
+    for (int lane = 0; mask != 0; ++lane, mask >>= 1)
+    {
+      if (mask & 1) visible.push_back(static_cast<uint32_t>(i + lane));
+    }
+  }
+
+  return i;
+}
+#endif
+
+#if defined(BGL_CULL_NEON)
+size_t cull_neon(const Bounds& bounds, const float* planes, size_t i, const size_t last,
+                 std::vector<uint32_t>& visible)
+{
+  for (; i + 4 <= last; i += 4)
+  {
+    float32x4_t min_x = vld1q_f32(bounds.min_x + i), max_x = vld1q_f32(bounds.max_x + i);
+    float32x4_t min_y = vld1q_f32(bounds.min_y + i), max_y = vld1q_f32(bounds.max_y + i);
+    float32x4_t min_z = vld1q_f32(bounds.min_z + i), max_z = vld1q_f32(bounds.max_z + i);
+    float32x4_t c_x = vld1q_f32(bounds.center_x + i);
+    float32x4_t c_y = vld1q_f32(bounds.center_y + i);
+    float32x4_t c_z = vld1q_f32(bounds.center_z + i);
+    float32x4_t r = vld1q_f32(bounds.radius + i);
+    uint32x4_t inside = vdupq_n_u32(0xffffffff);
+
+    for (int p = 0; p < 6; ++p)
+    {
+      float32x4_t n_x = vdupq_n_f32(planes[p * 4 + 0]);
+      float32x4_t n_y = vdupq_n_f32(planes[p * 4 + 1]);
+      float32x4_t n_z = vdupq_n_f32(planes[p * 4 + 2]);
+      float32x4_t d = vdupq_n_f32(planes[p * 4 + 3]);
+
+      float32x4_t sphere = vmlaq_f32(vmlaq_f32(vmlaq_f32(vaddq_f32(d, r), n_x, c_x), n_y, c_y),
+                                     n_z, c_z);
+      float32x4_t box = vaddq_f32(
+        vaddq_f32(vmaxq_f32(vmulq_f32(n_x, min_x), vmulq_f32(n_x, max_x)),
+                  vmaxq_f32(vmulq_f32(n_y, min_y), vmulq_f32(n_y, max_y))),
+        vaddq_f32(vmaxq_f32(vmulq_f32(n_z, min_z), vmulq_f32(n_z, max_z)), d));
+
+      float32x4_t distance = vminq_f32(sphere, box);
+      inside = vandq_u32(inside, vcgeq_f32(distance, vdupq_n_f32(0.0f)));
+    }
+
+    uint32_t lanes[4];
+    vst1q_u32(lanes, inside);
+
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      if (lanes[lane] != 0) visible.push_back(static_cast<uint32_t>(i + lane));
+    }
+  }
+
+  return i;
+}
+#endif
+
+/*
+ * Picks the widest kernel once. x86 asks the CPU what it supports, since the
+ * library is built for the baseline; ARM uses what it was compiled for
+ */
+CullKernel select_kernel()
+{
+#if defined(BGL_CULL_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) return cull_avx2;
+  if (__builtin_cpu_supports("sse2")) return cull_sse2;
+#elif defined(BGL_CULL_NEON)
+  return cull_neon;
+#endif
+
+  return cull_none;
+}
+
+CullKernel cull_kernel()
+{
+  static const CullKernel selected = select_kernel();
+  return selected;
+}
+} // end of anonymous namespace
+
+FrustumCuller::FrustumCuller(const size_t thread_count)
+  : thread_count_(thread_count)
+{
+  if (thread_count_ == 0) thread_count_ = std::thread::hardware_concurrency();
+  if (thread_count_ == 0) thread_count_ = 1;
+}
+
+uint32_t FrustumCuller::add(const glm::vec3& min, const glm::vec3& max)
+{
+  uint32_t index = static_cast<uint32_t>(size());
+
+  min_x_.push_back(0.0f); min_y_.push_back(0.0f); min_z_.push_back(0.0f);
+  max_x_.push_back(0.0f); max_y_.push_back(0.0f); max_z_.push_back(0.0f);
+  center_x_.push_back(0.0f); center_y_.push_back(0.0f); center_z_.push_back(0.0f);
+  radius_.push_back(0.0f);
+
+  set_bounds(index, min, max);
+
+  return index;
+}
+
+uint32_t FrustumCuller::add_sphere(const glm::vec3& center, const float radius)
+{
+  glm::vec3 extent(radius, radius, radius);
+  uint32_t index = add(center - extent, center + extent);
+
+  // The box is around the sphere here, so the sphere is the tighter bound
+  radius_[index] = radius;
+
+  return index;
+}
+
+void FrustumCuller::set_bounds(const uint32_t index, const glm::vec3& min, const glm::vec3& max)
+{
+  min_x_[index] = min.x; min_y_[index] = min.y; min_z_[index] = min.z;
+  max_x_[index] = max.x; max_y_[index] = max.y; max_z_[index] = max.z;
+
+  float half_x = (max.x - min.x) * 0.5f;
+  float half_y = (max.y - min.y) * 0.5f;
+  float half_z = (max.z - min.z) * 0.5f;
+
+  center_x_[index] = min.x + half_x;
+  center_y_[index] = min.y + half_y;
+  center_z_[index] = min.z + half_z;
+  radius_[index] = std::sqrt(half_x * half_x + half_y * half_y + half_z * half_z);
+}
+
+void FrustumCuller::clear()
+{
+  min_x_.clear(); min_y_.clear(); min_z_.clear();
+  max_x_.clear(); max_y_.clear(); max_z_.clear();
+  center_x_.clear(); center_y_.clear(); center_z_.clear();
+  radius_.clear();
+}
+
+/*
+ * Splits the objects into one contiguous range per thread (aligned to 8 so
+ * every range but the last is whole SIMD blocks) and joins the results back
+ * together in order
+ */
+void FrustumCuller::cull(const glm::mat4& view_projection, std::vector<uint32_t>& visible) const
+{
+  float planes[24];
+  extract_planes(view_projection, planes);
+
+  visible.clear();
+
+  size_t count = size();
+  size_t threads = count >= kParallelThreshold ? thread_count_ : 1;
+
+  if (threads == 1)
+  {
+    cull_range(planes, 0, count, visible);
+    return;
+  }
+
+  size_t chunk = ((count + threads - 1) / threads + 7) & ~static_cast<size_t>(7);
+  std::vector<std::vector<uint32_t>> results(threads);
+  std::vector<std::thread> workers;
+
+  for (size_t t = 0; t < threads; ++t)
+  {
+    size_t first = std::min(count, t * chunk);
+    size_t last = std::min(count, first + chunk);
+
+    workers.emplace_back(&FrustumCuller::cull_range, this, planes, first, last,
+                         std::ref(results[t]));
+  }
+
+  for (auto& worker : workers) worker.join();
+
+  for (auto& result : results)
+  {
+    visible.insert(visible.end(), result.begin(), result.end());
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * For each plane, an object is outside if either:
+ *    - its sphere is entirely behind it: dot(n, c) + d < -r
+ *    - its box is entirely behind it: the corner furthest along the normal
+ *      is behind the plane. Per axis that corner gives max(n * min, n * max),
+ *      which needs no branches or sign tests
+ */
+void FrustumCuller::cull_range(const float* planes, const size_t first, const size_t last,
+                               std::vector<uint32_t>& visible) const
+{
+  const Bounds bounds = {min_x_.data(), min_y_.data(), min_z_.data(),
+                         max_x_.data(), max_y_.data(), max_z_.data(),
+                         center_x_.data(), center_y_.data(), center_z_.data(), radius_.data()};
+  size_t i = cull_kernel()(bounds, planes, first, last, visible);
+
+  // Whatever doesn't fill a whole SIMD block
+  for (; i < last; ++i)
+  {
+    bool inside = true;
+
+    for (int p = 0; p < 6 && inside; ++p)
+    {
+      const float* plane = planes + p * 4;
+
+      float sphere = plane[0] * center_x_[i] + plane[1] * center_y_[i] +
+                     plane[2] * center_z_[i] + plane[3] + radius_[i];
+      float box = std::max(plane[0] * min_x_[i], plane[0] * max_x_[i]) +
+                  std::max(plane[1] * min_y_[i], plane[1] * max_y_[i]) +
+                  std::max(plane[2] * min_z_[i], plane[2] * max_z_[i]) + plane[3];
+
+      inside = sphere >= 0.0f && box >= 0.0f;
+    }
+
+    if (inside) visible.push_back(static_cast<uint32_t>(i));
+  }
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,315 @@
+//
+// glyph_cache.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <iterator>
+#include <OpenGL/gl3.h>
+#include "glyph_cache.h"
+#include "sprite_batch.h"
+#include "texture_units.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/// Space left to the right of and below each glyph, so filtering doesn't
+/// pick up its neighbours
+const int kPadding = 1;
+
+/*
+ * Decodes the next codepoint of a UTF-8 string, moving `i` past it. Invalid
+ * sequences decode as U+FFFD
+ */
+uint32_t decode_utf8(const std::string& text, size_t& i)
+{
+  uint8_t lead = static_cast<uint8_t>(text[i++]);
+
+  if (lead < 0x80) return lead;
+
+  int length = (lead & 0xe0) == 0xc0 ? 1 : (lead & 0xf0) == 0xe0 ? 2 : (lead & 0xf8) == 0xf0 ? 3 : -1;
+
+  if (length < 0) return 0xfffd;
+
+  uint32_t codepoint = lead & (0x3f >> length);
+
+  for (int k = 0; k < length; ++k)
+  {
+    if (i >= text.size() || (static_cast<uint8_t>(text[i]) & 0xc0) != 0x80) return 0xfffd;
+
+    codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[i++]) & 0x3f);
+  }
+
+  return codepoint;
+}
+} // end of anonymous namespace
+
+GlyphCache::GlyphCache(Rasterizer rasterizer, const float line_height, const int width,
+                       const int height)
+  : rasterizer_(std::move(rasterizer))
+  , line_height_(line_height)
+  , texture_(width, height, GL_RED, GL_R8, 1, std::vector<uint8_t>(width * height, 0).data())
+{
+}
+
+const GlyphCache::Glyph* GlyphCache::get(const uint32_t codepoint)
+{
+  Entry* entry = find(codepoint, nullptr);
+
+  return entry != nullptr ? &entry->glyph : nullptr;
+}
+
+float GlyphCache::draw_text(SpriteBatch& batch, const std::string& text, const float x,
+                            const float y, const float scale, const float r, const float g,
+                            const float b, const float a)
+{
+  float pen_x = x;
+  float pen_y = y;
+  float inverse_width = 1.0f / texture_.width();
+  float inverse_height = 1.0f / texture_.height();
+
+  for (size_t i = 0; i < text.size();)
+  {
+    uint32_t codepoint = decode_utf8(text, i);
+
+    if (codepoint == '\n')
+    {
+      pen_x = x;
+      pen_y += line_height_ * scale;
+      continue;
+    }
+
+    Entry* entry = find(codepoint, &batch);
+
+    if (entry == nullptr) continue;
+
+    const Glyph& glyph = entry->glyph;
+
+    if (glyph.width > 0 && glyph.height > 0)
+    {
+      Sprite sprite(pen_x + glyph.bearing_x * scale, pen_y - glyph.bearing_y * scale,
+                    glyph.width * scale, glyph.height * scale);
+
+      sprite.origin_x = 0.0f;
+      sprite.origin_y = 0.0f;
+      sprite.u0 = glyph.x * inverse_width;
+      sprite.v0 = glyph.y * inverse_height;
+      sprite.u1 = (glyph.x + glyph.width) * inverse_width;
+      sprite.v1 = (glyph.y + glyph.height) * inverse_height;
+      sprite.r = r;
+      sprite.g = g;
+      sprite.b = b;
+      sprite.a = a;
+
+      batch.draw(&texture_, sprite);
+      entry->generation = batch.generation();
+    }
+
+    pen_x += glyph.advance * scale;
+  }
+
+  return pen_x;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+GlyphCache::Entry* GlyphCache::find(const uint32_t codepoint, SpriteBatch* batch)
+{
+  auto cached = glyphs_.find(codepoint);
+
+  if (cached != glyphs_.end())
+  {
+    lru_.splice(lru_.begin(), lru_, cached->second.lru);
+    return &cached->second;
+  }
+
+  if (missing_.count(codepoint) > 0) return nullptr;
+
+  GlyphBitmap bitmap;
+
+  if (!rasterizer_(codepoint, bitmap))
+  {
+    missing_.insert(codepoint);
+    return nullptr;
+  }
+
+  Entry entry;
+  entry.glyph = Glyph {0, 0, bitmap.width, bitmap.height, bitmap.bearing_x, bitmap.bearing_y,
+                       bitmap.advance};
+  entry.shelf = -1;
+  entry.generation = 0;
+
+  if (bitmap.width > 0 && bitmap.height > 0)
+  {
+    int padded_width = bitmap.width + kPadding;
+    int padded_height = bitmap.height + kPadding;
+
+    if (padded_width > texture_.width() || padded_height > texture_.height())
+    {
+      throw Exception("Glyph is too large for the glyph cache");
+    }
+
+    while ((entry.shelf = allocate(padded_width, padded_height, entry.glyph.x, entry.glyph.y)) < 0)
+    {
+      if (!evict_one(batch)) throw Exception("Glyph does not fit in the glyph cache");
+    }
+
+    // Upload the glyph with its padding cleared, in case an evicted glyph
+    // left something behind
+    std::vector<uint8_t> padded(padded_width * padded_height, 0);
+
+    for (int row = 0; row < bitmap.height; ++row)
+    {
+      std::copy(bitmap.pixels.begin() + row * bitmap.width,
+                bitmap.pixels.begin() + (row + 1) * bitmap.width,
+                padded.begin() + row * padded_width);
+    }
+
+    texture_.bind();
+    texture_.sub_data(entry.glyph.x, entry.glyph.y, padded_width, padded_height, padded.data());
+    texture_.unbind();
+    TextureUnits::get().invalidate_active();
+  }
+
+  lru_.push_front(codepoint);
+  entry.lru = lru_.begin();
+
+  return &(glyphs_[codepoint] = entry);
+}
+
+/*
+ * Shelves close to the glyph's height are preferred (so small glyphs don't
+ * waste tall shelves), using a gap left by an eviction or the free space at
+ * the end of the shelf. Failing that a new shelf is opened below the last
+ * one, and as a last resort any shelf tall enough is used
+ */
+int GlyphCache::allocate(const int width, const int height, int& x, int& y)
+{
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (size_t i = 0; i < shelves_.size(); ++i)
+    {
+      Shelf& shelf = shelves_[i];
+
+      if (shelf.height < height) continue;
+      if (pass == 0 && shelf.height > height + height / 2) continue;
+
+      for (auto gap = shelf.gaps.begin(); gap != shelf.gaps.end(); ++gap)
+      {
+        if (gap->second >= width)
+        {
+          x = gap->first;
+          y = shelf.y;
+
+          gap->first += width;
+          gap->second -= width;
+
+          if (gap->second == 0) shelf.gaps.erase(gap);
+
+          return static_cast<int>(i);
+        }
+      }
+
+      if (shelf.used + width <= texture_.width())
+      {
+        x = shelf.used;
+        y = shelf.y;
+        shelf.used += width;
+
+        return static_cast<int>(i);
+      }
+    }
+
+    if (pass == 0 && next_shelf_y_ + height <= texture_.height())
+    {
+      shelves_.push_back(Shelf {next_shelf_y_, height, width, {}});
+      next_shelf_y_ += height;
+
+      x = 0;
+      y = shelves_.back().y;
+
+      return static_cast<int>(shelves_.size() - 1);
+    }
+  }
+
+  return -1;
+}
+
+/*
+ * Adds the glyph's space back to its shelf as a gap, merging it with any
+ * touching gaps. Gaps that reach the end of the used space are given back to
+ * the shelf, and an empty shelf at the bottom is removed entirely
+ */
+void GlyphCache::release(const Entry& entry)
+{
+  if (entry.shelf < 0) return;
+
+  Shelf& shelf = shelves_[entry.shelf];
+  int start = entry.glyph.x;
+  int end = entry.glyph.x + entry.glyph.width + kPadding;
+
+  for (size_t i = 0; i < shelf.gaps.size();)
+  {
+    auto& gap = shelf.gaps[i];
+
+    if (gap.first + gap.second == start || end == gap.first)
+    {
+      start = std::min(start, gap.first);
+      end = std::max(end, gap.first + gap.second);
+      shelf.gaps.erase(shelf.gaps.begin() + i);
+    }
+    else
+    {
+      ++i;
+    }
+  }
+
+  if (end == shelf.used)
+  {
+    shelf.used = start;
+  }
+  else
+  {
+    shelf.gaps.push_back(std::make_pair(start, end - start));
+  }
+
+  while (!shelves_.empty() && shelves_.back().used == 0)
+  {
+    next_shelf_y_ = shelves_.back().y;
+    shelves_.pop_back();
+  }
+}
+
+bool GlyphCache::evict_one(SpriteBatch* batch)
+{
+  // Skip glyphs with no space in the atlas, evicting them frees nothing
+  auto victim = lru_.end();
+
+  for (auto it = lru_.rbegin(); it != lru_.rend(); ++it)
+  {
+    if (glyphs_[*it].shelf >= 0)
+    {
+      victim = std::prev(it.base());
+      break;
+    }
+  }
+
+  if (victim == lru_.end()) return false;
+
+  Entry& entry = glyphs_[*victim];
+
+  // The glyph may still be waiting to be drawn from its current location
+  if (batch != nullptr && entry.generation == batch->generation()) batch->flush();
+
+  release(entry);
+  glyphs_.erase(*victim);
+  lru_.erase(victim);
+  ++evictions_;
+
+  return true;
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,198 @@
+//
+// handle_pool.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "handle_pool.h"
+#include "texture_units.h"
+#include "capabilities.h"
+#include "exception.h"
+
+namespace BarelyGL {
+HandlePool::HandlePool(const Type type, const size_t batch_size, const GLenum texture_target)
+  : type_(type)
+  , texture_target_(texture_target != 0 ? texture_target : GL_TEXTURE_2D)
+{
+  set_batch_size(batch_size);
+}
+
+HandlePool& HandlePool::buffers()
+{
+  static HandlePool pool(Type::Buffer);
+  return pool;
+}
+
+HandlePool& HandlePool::textures()
+{
+  static HandlePool pool(Type::Texture);
+  return pool;
+}
+
+HandlePool& HandlePool::textures(const GLenum target)
+{
+  static HandlePool array_pool(Type::Texture, 16, GL_TEXTURE_2D_ARRAY);
+  static HandlePool volume_pool(Type::Texture, 16, GL_TEXTURE_3D);
+
+  switch (target)
+  {
+    case GL_TEXTURE_2D:       return textures();
+    case GL_TEXTURE_2D_ARRAY: return array_pool;
+    case GL_TEXTURE_3D:       return volume_pool;
+    default:                  throw Exception("No texture pool for target");
+  }
+}
+
+HandlePool& HandlePool::vertex_arrays()
+{
+  static HandlePool pool(Type::VertexArray);
+  return pool;
+}
+
+HandlePool& HandlePool::renderbuffers()
+{
+  static HandlePool pool(Type::Renderbuffer);
+  return pool;
+}
+
+HandlePool& HandlePool::queries()
+{
+  static HandlePool pool(Type::Query);
+  return pool;
+}
+
+GLuint HandlePool::acquire()
+{
+  if (free_.empty()) generate(batch_size_);
+
+  GLuint id = free_.back();
+  free_.pop_back();
+
+  return id;
+}
+
+/*
+ * Vertex arrays are deleted straight away rather than recycled: a VAO's state
+ * (enabled arrays, formats, pointers into buffers and the element buffer) is
+ * all there is to it, and a reused name would keep the last owner's arrays
+ * enabled for a layout with fewer attributes
+ */
+void HandlePool::release(const GLuint id)
+{
+  if (id == 0) return;
+
+  if (type_ == Type::VertexArray)
+  {
+    glDeleteVertexArrays(1, &id);
+    return;
+  }
+
+  free_.push_back(id);
+
+  if (free_.size() > batch_size_ * 4)
+  {
+    destroy(free_.size() - batch_size_ * 2);
+  }
+}
+
+void HandlePool::reserve(const size_t count)
+{
+  if (free_.size() < count)
+  {
+    generate(count - free_.size());
+  }
+}
+
+void HandlePool::trim()
+{
+  destroy(free_.size());
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * Generates all of the names with a single call, appending them to the end
+ * of the free list. With direct state access the objects are created too,
+ * since the named functions can't be used on a name that was never bound
+ * (queries are always begun through a target, so they don't need it)
+ */
+void HandlePool::generate(const size_t count)
+{
+  size_t old_size = free_.size();
+  free_.resize(old_size + count, 0);
+
+  GLuint* names = free_.data() + old_size;
+  GLsizei n = static_cast<GLsizei>(count);
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access() && type_ != Type::Query)
+  {
+    switch (type_)
+    {
+      case Type::Buffer:       glCreateBuffers(n, names); break;
+      case Type::Texture:      glCreateTextures(texture_target_, n, names); break;
+      case Type::VertexArray:  glCreateVertexArrays(n, names); break;
+      case Type::Renderbuffer: glCreateRenderbuffers(n, names); break;
+      case Type::Query:        break;
+    }
+  }
+  else
+#endif
+  {
+    switch (type_)
+    {
+      case Type::Buffer:       glGenBuffers(n, names); break;
+      case Type::Texture:      glGenTextures(n, names); break;
+      case Type::VertexArray:  glGenVertexArrays(n, names); break;
+      case Type::Renderbuffer: glGenRenderbuffers(n, names); break;
+      case Type::Query:        glGenQueries(n, names); break;
+    }
+  }
+
+  if (names[0] == 0)
+  {
+    free_.resize(old_size);
+
+    switch (type_)
+    {
+      case Type::Buffer:       throw Exception("Could not generate buffer");
+      case Type::Texture:      throw Exception("Could not generate texture");
+      case Type::VertexArray:  throw Exception("Could not generate vertex array");
+      case Type::Renderbuffer: throw Exception("Could not generate renderbuffer");
+      case Type::Query:        throw Exception("Could not generate query");
+    }
+  }
+}
+
+/*
+ * Deleting a texture unbinds it, and its name can be handed out again by the
+ * next `glGen*`, so the texture unit cache has to forget it first
+ */
+void HandlePool::destroy(const size_t count)
+{
+  if (count == 0) return;
+
+  GLuint* names = free_.data() + free_.size() - count;
+  GLsizei n = static_cast<GLsizei>(count);
+
+  if (type_ == Type::Texture)
+  {
+    for (size_t i = 0; i < count; ++i) TextureUnits::get().invalidate(names[i]);
+  }
+
+  switch (type_)
+  {
+    case Type::Buffer:       glDeleteBuffers(n, names); break;
+    case Type::Texture:      glDeleteTextures(n, names); break;
+    case Type::VertexArray:  glDeleteVertexArrays(n, names); break;
+    case Type::Renderbuffer: glDeleteRenderbuffers(n, names); break;
+    case Type::Query:        glDeleteQueries(n, names); break;
+  }
+
+  free_.resize(free_.size() - count);
+}
+} // end of namespace BarelyGL
@@ -6,6 +6,9 @@
 #include <iostream>
 #include <OpenGL/gl3.h>
 #include "index_buffer_object.h"
+#include "handle_pool.h"
+#include "capabilities.h"
+#include "memory_tracker.h"
 #include "exception.h"
 
 namespace BarelyGL {
@@ -16,19 +19,105 @@ IndexBufferObject::IndexBufferObject(const GLenum target, const GLenum usage)
   generate_buffer();
 }
 
+IndexBufferObject::IndexBufferObject(IndexBufferObject&& other) noexcept
+  : id_(other.id_)
+  , target_(other.target_)
+  , usage_(other.usage_)
+  , index_count_(other.index_count_)
+  , immutable_(other.immutable_)
+  , byte_size_(other.byte_size_)
+  , primitive_restart_(other.primitive_restart_)
+{
+  other.id_ = 0;
+  other.index_count_ = 0;
+  other.byte_size_ = 0;
+}
+
+IndexBufferObject& IndexBufferObject::operator=(IndexBufferObject&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    target_ = other.target_;
+    usage_ = other.usage_;
+    index_count_ = other.index_count_;
+    immutable_ = other.immutable_;
+    byte_size_ = other.byte_size_;
+    primitive_restart_ = other.primitive_restart_;
+
+    other.id_ = 0;
+    other.index_count_ = 0;
+    other.byte_size_ = 0;
+  }
+
+  return *this;
+}
+
 void IndexBufferObject::bind() const
 {
   glBindBuffer(target_, id_);
 }
 
+void IndexBufferObject::init_buffer(const GLsizeiptr count)
+{
+  set_data(count * sizeof(int), nullptr);
+}
+
+void IndexBufferObject::set_indices(const std::vector<int>& indices)
+{
+  set_indices(indices.data(), indices.size());
+}
+
+void IndexBufferObject::set_indices(const int* indices, const size_t count)
+{
+  set_data(count * sizeof(int), indices);
+  index_count_ = count;
+}
+
 /*
- * Uploads the vertices to the buffer object
+ * Same as `VertexBufferObject::set_storage`, the storage stays dynamic so
+ * `sub_indices` still works
  */
-void IndexBufferObject::set_indices(std::vector<int> indices)
+void IndexBufferObject::set_storage(const std::vector<int>& indices)
+{
+  set_storage(indices.data(), indices.size());
+}
+
+void IndexBufferObject::set_storage(const int* indices, const size_t count)
 {
-  indices_ = std::move(indices);
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    if (immutable_) throw Exception("Buffer storage is immutable");
+
+    index_count_ = count;
+    glNamedBufferStorage(id_, count * sizeof(int), indices, GL_DYNAMIC_STORAGE_BIT);
+    immutable_ = true;
+
+    MemoryTracker::get().resize(MemoryTracker::Category::IndexBuffers, byte_size_,
+                                count * sizeof(int));
+    byte_size_ = count * sizeof(int);
+    return;
+  }
+#endif
 
-  glBufferData(target_, indices.size() * sizeof(int), indices.data(), usage_);
+  set_indices(indices, count);
+}
+
+void IndexBufferObject::sub_indices(const std::vector<int>& indices, const GLintptr offset)
+{
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferSubData(id_, offset * sizeof(int), indices.size() * sizeof(int),
+                         indices.data());
+    return;
+  }
+#endif
+
+  glBufferSubData(target_, offset * sizeof(int), indices.size() * sizeof(int), indices.data());
 }
 
 void IndexBufferObject::unbind() const
@@ -49,16 +138,45 @@ IndexBufferObject::~IndexBufferObject()
 
 void IndexBufferObject::generate_buffer()
 {
-  glGenBuffers(1, &id_);
+  id_ = HandlePool::buffers().acquire();
+}
+
+void IndexBufferObject::set_data(const GLsizeiptr size, const void* data)
+{
+  if (immutable_) throw Exception("Buffer storage is immutable");
+
+  MemoryTracker::get().resize(MemoryTracker::Category::IndexBuffers, byte_size_, size);
+  byte_size_ = size;
 
-  if (id_ == 0) throw Exception("Could not generate buffer");
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferData(id_, size, data, usage_);
+    return;
+  }
+#endif
+
+  glBufferData(target_, size, data, usage_);
 }
 
 void IndexBufferObject::destroy()
 {
   if (id_ != 0)
   {
-    glDeleteBuffers(1, &id_);
+    if (immutable_)
+    {
+      glDeleteBuffers(1, &id_);
+    }
+    else
+    {
+      HandlePool::buffers().release(id_);
+    }
+
+    MemoryTracker::get().resize(MemoryTracker::Category::IndexBuffers, byte_size_, 0);
+
+    id_ = 0;
+    immutable_ = false;
+    byte_size_ = 0;
   }
 }
 } // end of namespace BarelyGL
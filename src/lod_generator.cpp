@@ -0,0 +1,450 @@
+//
+// lod_generator.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <OpenGL/gl3.h>
+#include "lod_generator.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/*
+ * Symmetric 4x4 quadric (Garland & Heckbert), stored as the upper triangle of
+ * A, the vector b and the constant c, so that the squared distance from a
+ * point p to the planes summed into it is p'Ap + 2b'p + c. `weight` is the
+ * total area of those planes, to turn the sum into a mean
+ */
+struct Quadric
+{
+  double a00, a01, a02, a11, a12, a22;
+  double b0, b1, b2;
+  double c;
+  double weight;
+
+  void add_plane(const double* n, const double d, const double area)
+  {
+    a00 += area * n[0] * n[0]; a01 += area * n[0] * n[1]; a02 += area * n[0] * n[2];
+    a11 += area * n[1] * n[1]; a12 += area * n[1] * n[2]; a22 += area * n[2] * n[2];
+    b0 += area * n[0] * d; b1 += area * n[1] * d; b2 += area * n[2] * d;
+    c += area * d * d;
+    weight += area;
+  }
+
+  void add(const Quadric& q)
+  {
+    a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+    b0 += q.b0; b1 += q.b1; b2 += q.b2;
+    c += q.c;
+    weight += q.weight;
+  }
+
+  double evaluate(const float* p) const
+  {
+    double x = p[0], y = p[1], z = p[2];
+
+    return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z +
+           a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+           2.0 * (b0 * x + b1 * y + b2 * z) + c;
+  }
+};
+
+/*
+ * A candidate collapse of vertex `from` onto vertex `to`
+ */
+struct Collapse
+{
+  int from;
+  int to;
+  float cost;
+};
+
+void triangle_normal(const float* p0, const float* p1, const float* p2, double* n)
+{
+  double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+  double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+uint64_t edge_key(const int a, const int b)
+{
+  return a < b ? (static_cast<uint64_t>(a) << 32) | static_cast<uint32_t>(b)
+               : (static_cast<uint64_t>(b) << 32) | static_cast<uint32_t>(a);
+}
+} // end of anonymous namespace
+
+//
+// =============================
+//           LodChain
+// =============================
+//
+
+void LodChain::add_level(std::vector<int> indices, const float error)
+{
+  levels_.push_back(Level {std::move(indices), error});
+}
+
+void LodChain::upload(const GLenum usage)
+{
+  buffers_.clear();
+  buffers_.reserve(levels_.size());
+
+  for (auto& level : levels_)
+  {
+    buffers_.emplace_back(GL_ELEMENT_ARRAY_BUFFER, usage);
+    buffers_.back().bind();
+    buffers_.back().set_indices(level.indices);
+    buffers_.back().unbind();
+  }
+}
+
+/*
+ * Projects each level's error onto the screen at the given distance (the
+ * number of pixels a unit covers is screen_height / (2 * d * tan(fov / 2)))
+ * and returns the last level that stays under the limit. Levels are ordered
+ * by increasing error, so the search can stop at the first one over it
+ */
+size_t LodChain::select(const float distance, const float screen_height, const float fov_y,
+                        const float max_pixel_error) const
+{
+  if (levels_.empty() || distance <= 0.0f) return 0;
+
+  float pixels_per_unit = screen_height / (2.0f * distance * std::tan(fov_y * 0.5f));
+  size_t selected = 0;
+
+  for (size_t level = 1; level < levels_.size(); ++level)
+  {
+    if (levels_[level].error * pixels_per_unit > max_pixel_error) break;
+
+    selected = level;
+  }
+
+  return selected;
+}
+
+//
+// =============================
+//         LodGenerator
+// =============================
+//
+
+LodGenerator::LodGenerator(const std::vector<float>& vertices,
+                           const VertexAttributeArray& attributes)
+{
+  size_t stride = attributes.size();
+
+  if (stride == 0 || attributes.attributes().empty())
+  {
+    throw Exception("LOD generation needs vertex attributes");
+  }
+
+  size_t components = std::min<size_t>(attributes.attributes()[0].size, 3);
+  size_t vertex_count = vertices.size() / stride;
+
+  positions_.assign(vertex_count * 3, 0.0f);
+  position_group_.resize(vertex_count);
+  seam_.assign(vertex_count, false);
+
+  std::map<std::array<int64_t, 3>, int> groups;
+
+  for (size_t v = 0; v < vertex_count; ++v)
+  {
+    for (size_t k = 0; k < components; ++k)
+    {
+      positions_[v * 3 + k] = vertices[v * stride + k];
+    }
+
+    // Quantize to a very fine grid so tiny exporter noise still matches
+    std::array<int64_t, 3> key;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      key[k] = static_cast<int64_t>(std::floor(positions_[v * 3 + k] * 65536.0f + 0.5f));
+    }
+
+    auto inserted = groups.insert(std::make_pair(key, static_cast<int>(v)));
+    int first = inserted.first->second;
+
+    position_group_[v] = first;
+
+    if (!inserted.second)
+    {
+      seam_[v] = true;
+      seam_[first] = true;
+    }
+  }
+}
+
+/*
+ * Collapses edges in passes. Each pass:
+ *    1. Finds every edge and the cheaper of its two collapse directions
+ *    2. Sorts them by cost and applies as many as are needed, skipping any
+ *       that would flip a triangle or touch a vertex already changed this
+ *       pass (so that the flip tests stay valid)
+ *    3. Rewrites the triangles and drops those that became degenerate
+ * until the target is reached or nothing more can collapse
+ */
+std::vector<int> LodGenerator::simplify(const std::vector<int>& indices,
+                                        const size_t target_index_count, float& error) const
+{
+  size_t vertex_count = position_group_.size();
+  std::vector<int> triangles(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+
+  error = 0.0f;
+
+  // Quadrics from the planes of the original triangles
+  std::vector<Quadric> quadrics(vertex_count, Quadric());
+
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    const float* p0 = &positions_[triangles[t + 0] * 3];
+    const float* p1 = &positions_[triangles[t + 1] * 3];
+    const float* p2 = &positions_[triangles[t + 2] * 3];
+
+    double n[3];
+    triangle_normal(p0, p1, p2, n);
+
+    double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+    if (length == 0.0) continue;
+
+    for (int k = 0; k < 3; ++k) n[k] /= length;
+
+    double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+    double area = length * 0.5;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      quadrics[triangles[t + k]].add_plane(n, d, area);
+    }
+  }
+
+  // Lock seams and open borders (edges used by one triangle, by position)
+  std::vector<bool> locked(seam_);
+  std::unordered_map<uint64_t, int> edge_use;
+
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      int a = position_group_[triangles[t + k]];
+      int b = position_group_[triangles[t + (k + 1) % 3]];
+
+      ++edge_use[edge_key(a, b)];
+    }
+  }
+
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      int a = triangles[t + k];
+      int b = triangles[t + (k + 1) % 3];
+
+      if (edge_use[edge_key(position_group_[a], position_group_[b])] == 1)
+      {
+        locked[a] = true;
+        locked[b] = true;
+      }
+    }
+  }
+
+  double max_cost = 0.0;
+  std::vector<size_t> offsets(vertex_count + 1);
+  std::vector<size_t> adjacency;
+  std::vector<uint64_t> edges;
+  std::vector<Collapse> collapses;
+  std::vector<bool> touched(vertex_count);
+  std::vector<int> remap(vertex_count);
+
+  while (triangles.size() > target_index_count)
+  {
+    size_t triangle_count = triangles.size() / 3;
+
+    // Vertex -> triangle adjacency
+    std::fill(offsets.begin(), offsets.end(), 0);
+
+    for (int v : triangles) ++offsets[v + 1];
+    for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+
+    adjacency.resize(triangles.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+
+    for (size_t t = 0; t < triangle_count; ++t)
+    {
+      for (int k = 0; k < 3; ++k) adjacency[fill[triangles[t * 3 + k]]++] = t;
+    }
+
+    // Candidate collapses
+    edges.clear();
+
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        edges.push_back(edge_key(triangles[t + k], triangles[t + (k + 1) % 3]));
+      }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    collapses.clear();
+
+    for (uint64_t edge : edges)
+    {
+      int a = static_cast<int>(edge >> 32);
+      int b = static_cast<int>(edge & 0xffffffff);
+
+      if (locked[a] && locked[b]) continue;
+
+      Quadric q = quadrics[a];
+      q.add(quadrics[b]);
+
+      double scale = q.weight > 0.0 ? 1.0 / q.weight : 1.0;
+      double cost_ab = locked[a] ? HUGE_VAL : q.evaluate(&positions_[b * 3]) * scale;
+      double cost_ba = locked[b] ? HUGE_VAL : q.evaluate(&positions_[a * 3]) * scale;
+
+      if (cost_ab <= cost_ba)
+      {
+        collapses.push_back(Collapse {a, b, static_cast<float>(std::max(cost_ab, 0.0))});
+      }
+      else
+      {
+        collapses.push_back(Collapse {b, a, static_cast<float>(std::max(cost_ba, 0.0))});
+      }
+    }
+
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+      return x.cost < y.cost;
+    });
+
+    // Apply the cheapest collapses
+    size_t needed = (triangles.size() - target_index_count) / 3 + 1;
+    size_t removed = 0;
+    size_t applied = 0;
+
+    std::fill(touched.begin(), touched.end(), false);
+
+    for (size_t v = 0; v < vertex_count; ++v) remap[v] = static_cast<int>(v);
+
+    for (const Collapse& collapse : collapses)
+    {
+      if (removed >= needed) break;
+
+      int from = collapse.from;
+      int to = collapse.to;
+
+      if (touched[from] || touched[to]) continue;
+
+      // Reject the collapse if any triangle that survives it would flip
+      bool flips = false;
+      size_t collapsed_triangles = 0;
+
+      for (size_t j = offsets[from]; j < offsets[from + 1] && !flips; ++j)
+      {
+        const int* triangle = &triangles[adjacency[j] * 3];
+
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+          ++collapsed_triangles;
+          continue;
+        }
+
+        const float* before[3];
+        const float* after[3];
+
+        for (int k = 0; k < 3; ++k)
+        {
+          before[k] = &positions_[triangle[k] * 3];
+          after[k] = triangle[k] == from ? &positions_[to * 3] : before[k];
+        }
+
+        double n0[3], n1[3];
+        triangle_normal(before[0], before[1], before[2], n0);
+        triangle_normal(after[0], after[1], after[2], n1);
+
+        flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0;
+      }
+
+      if (flips) continue;
+
+      remap[from] = to;
+      quadrics[to].add(quadrics[from]);
+      max_cost = std::max(max_cost, static_cast<double>(collapse.cost));
+
+      for (size_t j = offsets[from]; j < offsets[from + 1]; ++j)
+      {
+        const int* triangle = &triangles[adjacency[j] * 3];
+
+        for (int k = 0; k < 3; ++k) touched[triangle[k]] = true;
+      }
+
+      removed += collapsed_triangles;
+      ++applied;
+    }
+
+    if (applied == 0) break;
+
+    // Rewrite the triangles, dropping any that are now degenerate
+    size_t write = 0;
+
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+      int a = remap[triangles[t + 0]];
+      int b = remap[triangles[t + 1]];
+      int c = remap[triangles[t + 2]];
+
+      int ga = position_group_[a], gb = position_group_[b], gc = position_group_[c];
+
+      if (ga == gb || gb == gc || ga == gc) continue;
+
+      triangles[write++] = a;
+      triangles[write++] = b;
+      triangles[write++] = c;
+    }
+
+    triangles.resize(write);
+  }
+
+  error = static_cast<float>(std::sqrt(max_cost));
+
+  return triangles;
+}
+
+LodChain LodGenerator::generate(const std::vector<int>& indices, const size_t max_levels,
+                                const float ratio) const
+{
+  LodChain chain;
+  chain.add_level(indices, 0.0f);
+
+  size_t previous_count = indices.size();
+  float previous_error = 0.0f;
+
+  for (size_t level = 1; level < max_levels; ++level)
+  {
+    size_t target = static_cast<size_t>(previous_count * ratio) / 3 * 3;
+    float error = 0.0f;
+
+    std::vector<int> simplified = simplify(indices, target, error);
+
+    // Give up once the mesh stops getting meaningfully smaller
+    if (simplified.empty() || simplified.size() > previous_count * 0.95f) break;
+
+    previous_count = simplified.size();
+    previous_error = std::max(previous_error, error);
+
+    chain.add_level(std::move(simplified), previous_error);
+  }
+
+  return chain;
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,63 @@
+//
+// memory_tracker.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "memory_tracker.h"
+#include <algorithm>
+
+namespace BarelyGL {
+MemoryTracker& MemoryTracker::get()
+{
+  static MemoryTracker tracker;
+  return tracker;
+}
+
+void MemoryTracker::resize(const Category category, const size_t old_size, const size_t new_size)
+{
+  const size_t index = static_cast<size_t>(category);
+
+  bytes_[index] = bytes_[index] - std::min(bytes_[index], old_size) + new_size;
+
+  if (old_size == 0 && new_size > 0) ++objects_[index];
+  if (old_size > 0 && new_size == 0 && objects_[index] > 0) --objects_[index];
+
+  peak_ = std::max(peak_, total_bytes());
+}
+
+size_t MemoryTracker::total_bytes() const
+{
+  size_t total = 0;
+
+  for (size_t bytes : bytes_)
+  {
+    total += bytes;
+  }
+
+  return total;
+}
+
+size_t MemoryTracker::texel_size(const GLenum internal_format)
+{
+  switch (internal_format)
+  {
+    case GL_R8: case GL_RED:
+      return 1;
+    case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16:
+    case GL_RG:
+      return 2;
+    case GL_RGB8: case GL_SRGB8: case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F: case GL_RG16F: case GL_R32F:
+    case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F: case GL_DEPTH24_STENCIL8:
+    case GL_RGB: case GL_RGBA: case GL_DEPTH_COMPONENT: case GL_DEPTH_STENCIL:
+      return 4;
+    case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGB32F: case GL_RGBA32F:
+      return 16;
+    default:
+      return 4;
+  }
+}
+} // end of namespace BarelyGL
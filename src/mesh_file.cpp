@@ -0,0 +1,343 @@
+//
+// mesh_file.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "mesh_file.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "exception.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BarelyGL {
+namespace {
+/// The version written, and the only one that can be loaded
+const uint32_t kFileVersion = 1;
+/// The most attributes a vertex can have
+const size_t kMaxAttributes = 16;
+/// The alignment of each blob in the file
+const uint64_t kBlobAlignment = 64;
+
+/**
+ * @brief The start of every mesh file
+ */
+struct FileHeader
+{
+  /// "BGLM"
+  char magic[4];
+  /// The version of the format
+  uint32_t version;
+  /// The number of vertex attributes
+  uint32_t attribute_count;
+  /// The number of vertices
+  uint32_t vertex_count;
+  /// The size of each vertex attribute (in floats)
+  uint8_t attribute_sizes[kMaxAttributes];
+  /// The number of indices
+  uint32_t index_count;
+  /// The number of submeshes
+  uint32_t submesh_count;
+  /// Where the vertices start, in bytes from the start of the file
+  uint64_t vertex_offset;
+  /// Where the indices start
+  uint64_t index_offset;
+  /// Where the submeshes start
+  uint64_t submesh_offset;
+};
+
+static_assert(sizeof(FileHeader) == 64, "Mesh file header must have no padding");
+static_assert(sizeof(MeshSubmesh) == 32, "Mesh file submeshes must have no padding");
+
+uint64_t align(const uint64_t offset)
+{
+  return (offset + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+/*
+ * Checks the blob lies inside the file without overflowing, and is aligned
+ * well enough to be read in place
+ */
+bool in_file(const uint64_t offset, const uint64_t count, const uint64_t element_size,
+             const uint64_t file_size)
+{
+  if (offset % 4 != 0 || offset > file_size) return false;
+
+  return count <= (file_size - offset) / element_size;
+}
+
+void pad(std::ofstream& file, const uint64_t offset)
+{
+  static const char zeros[kBlobAlignment] = {};
+  const uint64_t position = static_cast<uint64_t>(file.tellp());
+
+  file.write(zeros, static_cast<std::streamsize>(offset - position));
+}
+} // end of anonymous namespace
+
+/*
+ * Nothing in the file is read besides the header; the blobs are only touched
+ * when they are uploaded, so pages that are never used are never read in
+ */
+MeshFile::MeshFile(const std::string& file_path)
+{
+  int descriptor = open(file_path.c_str(), O_RDONLY);
+
+  if (descriptor < 0) throw Exception("Could not open mesh file: '" + file_path + "'");
+
+  struct stat info;
+
+  if (fstat(descriptor, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader)))
+  {
+    close(descriptor);
+    throw Exception("Mesh file is too small: '" + file_path + "'");
+  }
+
+  mapping_size_ = static_cast<size_t>(info.st_size);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+
+  if (mapping_ == MAP_FAILED)
+  {
+    mapping_ = nullptr;
+    throw Exception("Could not map mesh file: '" + file_path + "'");
+  }
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(mapping_);
+  FileHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+
+  if (std::memcmp(header.magic, "BGLM", 4) != 0 || header.version != kFileVersion ||
+      header.attribute_count == 0 || header.attribute_count > kMaxAttributes)
+  {
+    destroy();
+    throw Exception("Not a mesh file (or an unsupported version): '" + file_path + "'");
+  }
+
+  std::vector<VertexAttribute> attributes(header.attribute_count);
+  bool corrupt = false;
+
+  for (uint32_t i = 0; i < header.attribute_count; ++i)
+  {
+    attributes[i].size = header.attribute_sizes[i];
+
+    // Attributes are passed straight to OpenGL, which only takes 1 to 4 values
+    corrupt = corrupt || attributes[i].size < 1 || attributes[i].size > 4;
+  }
+
+  attributes_.set_attributes(std::move(attributes));
+
+  const uint64_t stride = attributes_.size() * sizeof(float);
+
+  // Empty data stores can't be given immutable storage, so empty meshes are rejected too
+  if (corrupt || header.vertex_count == 0 || header.index_count == 0 ||
+      !in_file(header.vertex_offset, header.vertex_count, stride, mapping_size_) ||
+      !in_file(header.index_offset, header.index_count, sizeof(int), mapping_size_) ||
+      !in_file(header.submesh_offset, header.submesh_count, sizeof(MeshSubmesh), mapping_size_))
+  {
+    destroy();
+    throw Exception("Mesh file is corrupt: '" + file_path + "'");
+  }
+
+  const MeshSubmesh* submeshes =
+    reinterpret_cast<const MeshSubmesh*>(bytes + header.submesh_offset);
+
+  for (uint32_t i = 0; i < header.submesh_count; ++i)
+  {
+    if (static_cast<uint64_t>(submeshes[i].first_index) + submeshes[i].index_count >
+        header.index_count)
+    {
+      destroy();
+      throw Exception("Mesh file is corrupt: '" + file_path + "'");
+    }
+  }
+
+  vertices_ = reinterpret_cast<const float*>(bytes + header.vertex_offset);
+  vertex_count_ = header.vertex_count;
+  indices_ = reinterpret_cast<const int*>(bytes + header.index_offset);
+  index_count_ = header.index_count;
+  submeshes_ = submeshes;
+  submesh_count_ = header.submesh_count;
+}
+
+MeshFile::MeshFile(MeshFile&& other) noexcept
+  : mapping_(other.mapping_)
+  , mapping_size_(other.mapping_size_)
+  , attributes_(std::move(other.attributes_))
+  , vertices_(other.vertices_)
+  , vertex_count_(other.vertex_count_)
+  , indices_(other.indices_)
+  , index_count_(other.index_count_)
+  , submeshes_(other.submeshes_)
+  , submesh_count_(other.submesh_count_)
+{
+  other.mapping_ = nullptr;
+  other.destroy();
+}
+
+MeshFile& MeshFile::operator=(MeshFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    mapping_ = other.mapping_;
+    mapping_size_ = other.mapping_size_;
+    attributes_ = std::move(other.attributes_);
+    vertices_ = other.vertices_;
+    vertex_count_ = other.vertex_count_;
+    indices_ = other.indices_;
+    index_count_ = other.index_count_;
+    submeshes_ = other.submeshes_;
+    submesh_count_ = other.submesh_count_;
+
+    other.mapping_ = nullptr;
+    other.destroy();
+  }
+
+  return *this;
+}
+
+void MeshFile::write(const std::string& file_path, const VertexAttributeArray& attributes,
+                     const std::vector<float>& vertices, const std::vector<int>& indices,
+                     const std::vector<MeshSubmesh>& submeshes)
+{
+  const size_t stride = attributes.size();
+
+  if (stride == 0 || attributes.attributes().size() > kMaxAttributes)
+  {
+    throw Exception("Unsupported vertex layout for a mesh file");
+  }
+
+  for (const VertexAttribute& attribute : attributes.attributes())
+  {
+    if (attribute.size < 1 || attribute.size > 4)
+    {
+      throw Exception("Unsupported vertex layout for a mesh file");
+    }
+  }
+
+  if (vertices.empty() || indices.empty()) throw Exception("Cannot write an empty mesh file");
+
+  if (vertices.size() % stride != 0 ||
+      vertices.size() / stride > std::numeric_limits<uint32_t>::max() ||
+      indices.size() > std::numeric_limits<uint32_t>::max())
+  {
+    throw Exception("Mesh is too large (or partial) for a mesh file");
+  }
+
+  std::vector<MeshSubmesh> ranges = submeshes;
+
+  if (ranges.empty())
+  {
+    ranges.push_back(make_submesh(attributes, vertices, indices, 0,
+                                  static_cast<uint32_t>(indices.size())));
+  }
+
+  FileHeader header = {};
+  std::memcpy(header.magic, "BGLM", 4);
+  header.version = kFileVersion;
+  header.attribute_count = static_cast<uint32_t>(attributes.attributes().size());
+  header.vertex_count = static_cast<uint32_t>(vertices.size() / stride);
+  header.index_count = static_cast<uint32_t>(indices.size());
+  header.submesh_count = static_cast<uint32_t>(ranges.size());
+
+  for (size_t i = 0; i < attributes.attributes().size(); ++i)
+  {
+    header.attribute_sizes[i] = attributes.attributes()[i].size;
+  }
+
+  header.vertex_offset = align(sizeof(FileHeader));
+  header.index_offset = align(header.vertex_offset + vertices.size() * sizeof(float));
+  header.submesh_offset = align(header.index_offset + indices.size() * sizeof(int));
+
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+
+  if (!file) throw Exception("Could not write mesh file: '" + file_path + "'");
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  pad(file, header.vertex_offset);
+  file.write(reinterpret_cast<const char*>(vertices.data()),
+             static_cast<std::streamsize>(vertices.size() * sizeof(float)));
+  pad(file, header.index_offset);
+  file.write(reinterpret_cast<const char*>(indices.data()),
+             static_cast<std::streamsize>(indices.size() * sizeof(int)));
+  pad(file, header.submesh_offset);
+  file.write(reinterpret_cast<const char*>(ranges.data()),
+             static_cast<std::streamsize>(ranges.size() * sizeof(MeshSubmesh)));
+
+  if (!file) throw Exception("Could not write mesh file: '" + file_path + "'");
+}
+
+MeshSubmesh MeshFile::make_submesh(const VertexAttributeArray& attributes,
+                                   const std::vector<float>& vertices,
+                                   const std::vector<int>& indices, const uint32_t first_index,
+                                   const uint32_t index_count)
+{
+  MeshSubmesh submesh = {first_index, index_count, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+  const size_t stride = attributes.size();
+  bool first = true;
+
+  if (stride < 3) return submesh;
+
+  for (uint32_t i = first_index; i < first_index + index_count && i < indices.size(); ++i)
+  {
+    const float* position = &vertices[static_cast<size_t>(indices[i]) * stride];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      submesh.min[axis] = first ? position[axis] : std::min(submesh.min[axis], position[axis]);
+      submesh.max[axis] = first ? position[axis] : std::max(submesh.max[axis], position[axis]);
+    }
+
+    first = false;
+  }
+
+  return submesh;
+}
+
+/*
+ * Hints the kernel to start reading the blobs in before OpenGL copies them
+ */
+void MeshFile::upload(VertexBufferObject& vertex_buffer, IndexBufferObject& index_buffer) const
+{
+  const size_t stride = attributes_.size();
+
+  posix_madvise(mapping_, mapping_size_, POSIX_MADV_WILLNEED);
+
+  vertex_buffer.set_storage(vertices_, vertex_count_ * stride);
+  index_buffer.set_storage(indices_, index_count_);
+}
+
+MeshFile::~MeshFile()
+{
+  destroy();
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void MeshFile::destroy()
+{
+  if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  vertices_ = nullptr;
+  vertex_count_ = 0;
+  indices_ = nullptr;
+  index_count_ = 0;
+  submeshes_ = nullptr;
+  submesh_count_ = 0;
+}
+} // end of namespace BarelyGL
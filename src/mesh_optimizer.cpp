@@ -0,0 +1,459 @@
+//
+// mesh_optimizer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include "mesh_optimizer.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/// The size of the LRU cache modelled by the Forsyth scoring
+const int kForsythCacheSize = 32;
+
+/*
+ * Forsyth's vertex score. Vertices used by the last triangle get a fixed
+ * score (so no triangle is favoured just for reusing the last three), the
+ * rest of the cache decays with position and vertices with few remaining
+ * triangles get a boost so they are finished off rather than left stranded
+ */
+float vertex_score(const int cache_position, const int live_triangles)
+{
+  if (live_triangles == 0) return -1.0f;
+
+  float score = 0.0f;
+
+  if (cache_position >= 3)
+  {
+    float scaler = 1.0f / (kForsythCacheSize - 3);
+    score = std::pow(1.0f - (cache_position - 3) * scaler, 1.5f);
+  }
+  else if (cache_position >= 0)
+  {
+    score = 0.75f;
+  }
+
+  return score + 2.0f * std::pow(static_cast<float>(live_triangles), -0.5f);
+}
+
+/*
+ * Simulates a FIFO cache, returning how many of the triangle's vertices were
+ * not in it
+ */
+int simulate_fifo(const int* triangle, std::vector<size_t>& timestamps, size_t& time,
+                  const size_t cache_size)
+{
+  int misses = 0;
+
+  for (int k = 0; k < 3; ++k)
+  {
+    size_t& stamp = timestamps[triangle[k]];
+
+    if (time - stamp >= cache_size)
+    {
+      stamp = time++;
+      ++misses;
+    }
+  }
+
+  return misses;
+}
+
+/*
+ * Reads the position of a vertex from the first attribute, padding 2D
+ * positions with z = 0
+ */
+void read_position(const std::vector<float>& vertices, const size_t stride, const size_t components,
+                   const int vertex, float* position)
+{
+  const float* source = &vertices[vertex * stride];
+
+  position[0] = source[0];
+  position[1] = components > 1 ? source[1] : 0.0f;
+  position[2] = components > 2 ? source[2] : 0.0f;
+}
+} // end of anonymous namespace
+
+MeshOptimizer::MeshOptimizer(const size_t cache_size, const float overdraw_threshold)
+  : cache_size_(cache_size)
+  , overdraw_threshold_(overdraw_threshold)
+{
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(std::vector<float>& vertices,
+                                              const VertexAttributeArray& attributes,
+                                              std::vector<int>& indices) const
+{
+  size_t vertex_count = vertices.size() / attributes.size();
+
+  Report report;
+  report.before = analyze(indices, vertex_count);
+
+  optimize_vertex_cache(indices, vertex_count);
+  optimize_overdraw(indices, vertices, attributes);
+  optimize_vertex_fetch(vertices, attributes, indices);
+
+  report.after = analyze(indices, vertices.size() / attributes.size());
+
+  return report;
+}
+
+/*
+ * Greedily emits the triangle with the highest score, where a triangle's
+ * score is the sum of its vertex scores. Only triangles using a vertex in the
+ * cache are candidates; when there are none the next unemitted triangle in
+ * input order is used instead
+ */
+void MeshOptimizer::optimize_vertex_cache(std::vector<int>& indices, const size_t vertex_count) const
+{
+  size_t triangle_count = indices.size() / 3;
+
+  if (triangle_count == 0) return;
+
+  // Build the vertex -> triangle adjacency, where the first `live[v]` entries
+  // of each vertex's list are the triangles not yet emitted
+  std::vector<int> live(vertex_count, 0);
+  std::vector<size_t> offsets(vertex_count + 1, 0);
+
+  for (size_t i = 0; i < triangle_count * 3; ++i)
+  {
+    if (indices[i] < 0 || static_cast<size_t>(indices[i]) >= vertex_count)
+    {
+      throw Exception("Index out of range of the vertex data");
+    }
+
+    ++live[indices[i]];
+  }
+
+  for (size_t v = 0; v < vertex_count; ++v)
+  {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+
+  std::vector<size_t> adjacency(triangle_count * 3);
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      adjacency[fill[indices[t * 3 + k]]++] = t;
+    }
+  }
+
+  std::vector<int> cache_position(vertex_count, -1);
+  std::vector<float> scores(vertex_count);
+
+  for (size_t v = 0; v < vertex_count; ++v)
+  {
+    scores[v] = vertex_score(-1, live[v]);
+  }
+
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<int> cache;
+  std::vector<int> new_cache;
+  std::vector<int> output;
+  output.reserve(triangle_count * 3);
+
+  size_t cursor = 0;
+  long best = -1;
+
+  while (output.size() < triangle_count * 3)
+  {
+    if (best < 0)
+    {
+      while (emitted[cursor]) ++cursor;
+
+      best = static_cast<long>(cursor);
+    }
+
+    const int* triangle = &indices[best * 3];
+
+    emitted[best] = true;
+    output.insert(output.end(), triangle, triangle + 3);
+
+    // Remove the triangle from each of its vertices' live lists
+    for (int k = 0; k < 3; ++k)
+    {
+      int v = triangle[k];
+      size_t* list = &adjacency[offsets[v]];
+
+      for (int j = 0; j < live[v]; ++j)
+      {
+        if (list[j] == static_cast<size_t>(best))
+        {
+          std::swap(list[j], list[live[v] - 1]);
+          break;
+        }
+      }
+
+      --live[v];
+    }
+
+    // Move the triangle's vertices to the front of the cache
+    new_cache.assign(triangle, triangle + 3);
+
+    for (int v : cache)
+    {
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) new_cache.push_back(v);
+    }
+
+    for (size_t i = 0; i < new_cache.size(); ++i)
+    {
+      int v = new_cache[i];
+
+      cache_position[v] = i < static_cast<size_t>(kForsythCacheSize) ? static_cast<int>(i) : -1;
+      scores[v] = vertex_score(cache_position[v], live[v]);
+    }
+
+    if (new_cache.size() > static_cast<size_t>(kForsythCacheSize))
+    {
+      new_cache.resize(kForsythCacheSize);
+    }
+
+    cache.swap(new_cache);
+
+    // Pick the best triangle touching the cache
+    best = -1;
+    float best_score = -1.0f;
+
+    for (int v : cache)
+    {
+      const size_t* list = &adjacency[offsets[v]];
+
+      for (int j = 0; j < live[v]; ++j)
+      {
+        const int* candidate = &indices[list[j] * 3];
+        float score = scores[candidate[0]] + scores[candidate[1]] + scores[candidate[2]];
+
+        if (score > best_score)
+        {
+          best_score = score;
+          best = static_cast<long>(list[j]);
+        }
+      }
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+/*
+ * Splits the triangle list into clusters and sorts the clusters so that those
+ * facing away from the centre of the mesh are drawn first, which means inner
+ * or back surfaces are more likely to fail the depth test.
+ *
+ * Hard boundaries are where the cache had to start again from scratch (all 3
+ * vertices missed), so splitting there costs nothing. Each hard cluster is
+ * then split further wherever the ACMR of the piece so far is within the
+ * threshold of the whole cluster's.
+ */
+void MeshOptimizer::optimize_overdraw(std::vector<int>& indices, const std::vector<float>& vertices,
+                                      const VertexAttributeArray& attributes) const
+{
+  size_t triangle_count = indices.size() / 3;
+  size_t stride = attributes.size();
+
+  if (triangle_count == 0 || stride == 0 || attributes.attributes().empty()) return;
+
+  size_t components = attributes.attributes()[0].size;
+  size_t vertex_count = vertices.size() / stride;
+
+  std::vector<size_t> timestamps(vertex_count, 0);
+  size_t time = cache_size_ + 1;
+
+  // Hard boundaries
+  std::vector<size_t> hard;
+
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    if (simulate_fifo(&indices[t * 3], timestamps, time, cache_size_) == 3) hard.push_back(t);
+  }
+
+  if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+  hard.push_back(triangle_count);
+
+  // Soft boundaries
+  std::vector<size_t> clusters;
+
+  for (size_t h = 0; h + 1 < hard.size(); ++h)
+  {
+    size_t start = hard[h];
+    size_t end = hard[h + 1];
+
+    time += cache_size_ + 1;
+
+    int cluster_misses = 0;
+
+    for (size_t t = start; t < end; ++t)
+    {
+      cluster_misses += simulate_fifo(&indices[t * 3], timestamps, time, cache_size_);
+    }
+
+    float threshold = overdraw_threshold_ * cluster_misses / (end - start);
+
+    clusters.push_back(start);
+    time += cache_size_ + 1;
+
+    int misses = 0;
+    size_t soft_start = start;
+
+    for (size_t t = start; t + 1 < end; ++t)
+    {
+      misses += simulate_fifo(&indices[t * 3], timestamps, time, cache_size_);
+
+      if (static_cast<float>(misses) / (t - soft_start + 1) <= threshold)
+      {
+        clusters.push_back(t + 1);
+        soft_start = t + 1;
+        misses = 0;
+        time += cache_size_ + 1;
+      }
+    }
+  }
+
+  clusters.push_back(triangle_count);
+
+  // Area weighted centroid and normal of each cluster
+  size_t cluster_count = clusters.size() - 1;
+  std::vector<float> centroids(cluster_count * 3, 0.0f);
+  std::vector<float> normals(cluster_count * 3, 0.0f);
+  std::vector<float> areas(cluster_count, 0.0f);
+  float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+  float mesh_area = 0.0f;
+
+  for (size_t c = 0; c < cluster_count; ++c)
+  {
+    for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+    {
+      float p0[3], p1[3], p2[3];
+      read_position(vertices, stride, components, indices[t * 3 + 0], p0);
+      read_position(vertices, stride, components, indices[t * 3 + 1], p1);
+      read_position(vertices, stride, components, indices[t * 3 + 2], p2);
+
+      float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0]};
+      float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      for (int k = 0; k < 3; ++k)
+      {
+        float centre = (p0[k] + p1[k] + p2[k]) / 3.0f;
+
+        centroids[c * 3 + k] += centre * area;
+        normals[c * 3 + k] += n[k];
+        mesh_centroid[k] += centre * area;
+      }
+
+      areas[c] += area;
+      mesh_area += area;
+    }
+  }
+
+  if (mesh_area > 0.0f)
+  {
+    for (int k = 0; k < 3; ++k) mesh_centroid[k] /= mesh_area;
+  }
+
+  std::vector<float> sort_keys(cluster_count, 0.0f);
+
+  for (size_t c = 0; c < cluster_count; ++c)
+  {
+    if (areas[c] == 0.0f) continue;
+
+    float* n = &normals[c * 3];
+    float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+    if (length == 0.0f) continue;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      sort_keys[c] += (centroids[c * 3 + k] / areas[c] - mesh_centroid[k]) * n[k] / length;
+    }
+  }
+
+  std::vector<size_t> order(cluster_count);
+
+  for (size_t c = 0; c < cluster_count; ++c) order[c] = c;
+
+  std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t a, size_t b) {
+    return sort_keys[a] > sort_keys[b];
+  });
+
+  std::vector<int> output;
+  output.reserve(triangle_count * 3);
+
+  for (size_t c : order)
+  {
+    output.insert(output.end(), indices.begin() + clusters[c] * 3,
+                  indices.begin() + clusters[c + 1] * 3);
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void MeshOptimizer::optimize_vertex_fetch(std::vector<float>& vertices,
+                                          const VertexAttributeArray& attributes,
+                                          std::vector<int>& indices) const
+{
+  size_t stride = attributes.size();
+
+  if (stride == 0) return;
+
+  size_t vertex_count = vertices.size() / stride;
+  std::vector<int> remap(vertex_count, -1);
+  std::vector<float> output;
+  output.reserve(vertices.size());
+
+  int next = 0;
+
+  for (int& index : indices)
+  {
+    if (remap[index] < 0)
+    {
+      remap[index] = next++;
+      output.insert(output.end(), vertices.begin() + index * stride,
+                    vertices.begin() + (index + 1) * stride);
+    }
+
+    index = remap[index];
+  }
+
+  vertices.swap(output);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyze(const std::vector<int>& indices,
+                                                 const size_t vertex_count) const
+{
+  CacheStats stats = {0.0f, 0.0f};
+  size_t triangle_count = indices.size() / 3;
+
+  if (triangle_count == 0) return stats;
+
+  for (size_t i = 0; i < triangle_count * 3; ++i)
+  {
+    if (indices[i] < 0 || static_cast<size_t>(indices[i]) >= vertex_count)
+    {
+      throw Exception("Index out of range of the vertex data");
+    }
+  }
+
+  std::vector<size_t> timestamps(vertex_count, 0);
+  size_t time = cache_size_ + 1;
+  size_t misses = 0;
+
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    misses += simulate_fifo(&indices[t * 3], timestamps, time, cache_size_);
+  }
+
+  stats.acmr = static_cast<float>(misses) / triangle_count;
+  stats.atvr = static_cast<float>(misses) / vertex_count;
+
+  return stats;
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,427 @@
+//
+// mipmap_generator.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "mipmap_generator.h"
+#include "exception.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+  #include <xmmintrin.h>
+  #define BGL_MIP_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define BGL_MIP_NEON
+#endif
+
+namespace BarelyGL {
+namespace {
+/// Levels with fewer pixels than this are filtered on the calling thread
+const size_t kParallelThreshold = 64 * 1024;
+/// The shape of the Kaiser window (higher is smoother with a wider main lobe)
+const double kKaiserAlpha = 4.0;
+
+#if defined(BGL_MIP_SSE)
+typedef __m128 Pixel4;
+inline Pixel4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline void store4(float* p, const Pixel4 v) { _mm_storeu_ps(p, v); }
+inline Pixel4 zero4() { return _mm_setzero_ps(); }
+inline Pixel4 add4(const Pixel4 a, const Pixel4 b) { return _mm_add_ps(a, b); }
+inline Pixel4 mul4(const Pixel4 a, const float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#define BGL_MIP_SIMD
+#elif defined(BGL_MIP_NEON)
+typedef float32x4_t Pixel4;
+inline Pixel4 load4(const float* p) { return vld1q_f32(p); }
+inline void store4(float* p, const Pixel4 v) { vst1q_f32(p, v); }
+inline Pixel4 zero4() { return vdupq_n_f32(0.0f); }
+inline Pixel4 add4(const Pixel4 a, const Pixel4 b) { return vaddq_f32(a, b); }
+inline Pixel4 mul4(const Pixel4 a, const float s) { return vmulq_n_f32(a, s); }
+#define BGL_MIP_SIMD
+#endif
+
+/*
+ * sRGB byte to linear float, for every byte value
+ */
+const float* srgb_to_linear_table()
+{
+  static float table[256];
+  static bool built = [] {
+    for (int i = 0; i < 256; ++i)
+    {
+      double c = i / 255.0;
+      table[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+    }
+
+    return true;
+  }();
+
+  (void)built;
+  return table;
+}
+
+/*
+ * Linear float (quantized to 12 bits, plenty for an 8-bit result) to sRGB byte
+ */
+const uint8_t* linear_to_srgb_table()
+{
+  static uint8_t table[4096];
+  static bool built = [] {
+    for (int i = 0; i < 4096; ++i)
+    {
+      double c = i / 4095.0;
+      double s = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+      table[i] = static_cast<uint8_t>(std::lround(s * 255.0));
+    }
+
+    return true;
+  }();
+
+  (void)built;
+  return table;
+}
+
+/*
+ * The zeroth order modified Bessel function of the first kind, by its series
+ */
+double bessel_i0(const double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+
+  for (int k = 1; k < 32; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+
+  return sum;
+}
+
+inline int clamp_index(const int index, const int size)
+{
+  return index < 0 ? 0 : (index >= size ? size - 1 : index);
+}
+
+inline float clamp_unit(const float value)
+{
+  return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+} // end of anonymous namespace
+
+/*
+ * The taps sit at source pixel centers -3.5 to 3.5 away from the center of
+ * the destination pixel. A sinc with its first zero at 2 source pixels
+ * removes what the half resolution level can't represent, and the Kaiser
+ * window tapers it to zero at 4 source pixels
+ */
+MipmapGenerator::MipmapGenerator(const Filter filter, const bool srgb, const size_t thread_count)
+  : filter_(filter)
+  , srgb_(srgb)
+  , thread_count_(thread_count)
+{
+  if (thread_count_ == 0) thread_count_ = std::thread::hardware_concurrency();
+  if (thread_count_ == 0) thread_count_ = 1;
+
+  const double pi = 3.14159265358979323846;
+  double total = 0.0;
+  double weights[8];
+
+  for (int i = 0; i < 8; ++i)
+  {
+    double d = i - 3.5;
+    double x = pi * d / 2.0;
+    double sinc = std::sin(x) / x;
+    double t = d / 4.0;
+    double window = bessel_i0(kKaiserAlpha * std::sqrt(1.0 - t * t)) / bessel_i0(kKaiserAlpha);
+
+    weights[i] = sinc * window;
+    total += weights[i];
+  }
+
+  for (int i = 0; i < 8; ++i)
+  {
+    taps_[i] = static_cast<float>(weights[i] / total);
+  }
+}
+
+int MipmapGenerator::level_count(const int width, const int height)
+{
+  int levels = 1;
+  int size = std::max(width, height);
+
+  while (size > 1)
+  {
+    size /= 2;
+    ++levels;
+  }
+
+  return levels;
+}
+
+/*
+ * Converts level 0 to linear float once, then halves it in float until it
+ * reaches 1x1, converting each level back to bytes as it goes
+ */
+std::vector<std::vector<uint8_t>> MipmapGenerator::generate(const uint8_t* pixels, const int width,
+                                                            const int height,
+                                                            const int channels) const
+{
+  if (width <= 0 || height <= 0) throw Exception("Mipmap source must have a non-zero size");
+  if (channels < 1 || channels > 4) throw Exception("Mipmap source must have 1 to 4 channels");
+
+  const float* to_linear = srgb_to_linear_table();
+  const uint8_t* to_srgb = linear_to_srgb_table();
+
+  // Alpha is the 4th channel, and is never sRGB encoded
+  auto is_color = [this](const int channel) { return srgb_ && channel < 3; };
+
+  std::vector<float> current(static_cast<size_t>(width) * height * channels);
+
+  for_rows(height, current.size() / channels, [&](const int first_row, const int last_row) {
+    for (size_t i = static_cast<size_t>(first_row) * width * channels;
+         i < static_cast<size_t>(last_row) * width * channels; ++i)
+    {
+      int channel = static_cast<int>(i % channels);
+      current[i] = is_color(channel) ? to_linear[pixels[i]] : pixels[i] / 255.0f;
+    }
+  });
+
+  std::vector<std::vector<uint8_t>> levels;
+  std::vector<float> next;
+  std::vector<float> scratch;
+  int level_width = width;
+  int level_height = height;
+
+  while (level_width > 1 || level_height > 1)
+  {
+    const int next_width = std::max(1, level_width / 2);
+    const int next_height = std::max(1, level_height / 2);
+    const size_t next_pixels = static_cast<size_t>(next_width) * next_height;
+
+    next.resize(next_pixels * channels);
+
+    if (filter_ == Filter::Box)
+    {
+      for_rows(next_height, next_pixels, [&](const int first_row, const int last_row) {
+        box(current.data(), level_width, level_height, channels, next.data(), next_width,
+            first_row, last_row);
+      });
+    }
+    else
+    {
+      scratch.resize(static_cast<size_t>(next_width) * level_height * channels);
+
+      for_rows(level_height, next_pixels * 2, [&](const int first_row, const int last_row) {
+        kaiser_rows(current.data(), level_width, channels, scratch.data(), next_width, first_row,
+                    last_row);
+      });
+
+      for_rows(next_height, next_pixels, [&](const int first_row, const int last_row) {
+        kaiser_columns(scratch.data(), level_height, next_width, channels, next.data(),
+                       first_row, last_row);
+      });
+    }
+
+    levels.emplace_back(next.size());
+    uint8_t* out = levels.back().data();
+
+    for_rows(next_height, next_pixels, [&](const int first_row, const int last_row) {
+      for (size_t i = static_cast<size_t>(first_row) * next_width * channels;
+           i < static_cast<size_t>(last_row) * next_width * channels; ++i)
+      {
+        float value = clamp_unit(next[i]);
+        int channel = static_cast<int>(i % channels);
+
+        out[i] = is_color(channel) ? to_srgb[static_cast<int>(value * 4095.0f + 0.5f)]
+                                   : static_cast<uint8_t>(value * 255.0f + 0.5f);
+      }
+    });
+
+    current.swap(next);
+    level_width = next_width;
+    level_height = next_height;
+  }
+
+  return levels;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * Averages source pixels 2x, 2x + 1 of rows 2y, 2y + 1 (clamped, so a
+ * dimension of 1 just repeats)
+ */
+void MipmapGenerator::box(const float* source, const int width, const int height,
+                          const int channels, float* destination, const int destination_width,
+                          const int first_row, const int last_row) const
+{
+  for (int y = first_row; y < last_row; ++y)
+  {
+    const float* row0 = source + static_cast<size_t>(clamp_index(y * 2, height)) * width * channels;
+    const float* row1 = source
+                        + static_cast<size_t>(clamp_index(y * 2 + 1, height)) * width * channels;
+    float* out = destination + static_cast<size_t>(y) * destination_width * channels;
+
+    for (int x = 0; x < destination_width; ++x)
+    {
+      const int x0 = clamp_index(x * 2, width) * channels;
+      const int x1 = clamp_index(x * 2 + 1, width) * channels;
+
+#if defined(BGL_MIP_SIMD)
+      if (channels == 4)
+      {
+        Pixel4 sum = add4(add4(load4(row0 + x0), load4(row0 + x1)),
+                          add4(load4(row1 + x0), load4(row1 + x1)));
+        store4(out + x * 4, mul4(sum, 0.25f));
+        continue;
+      }
+#endif
+
+      for (int c = 0; c < channels; ++c)
+      {
+        out[x * channels + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+      }
+    }
+  }
+}
+
+void MipmapGenerator::kaiser_rows(const float* source, const int width, const int channels,
+                                  float* destination, const int destination_width,
+                                  const int first_row, const int last_row) const
+{
+  for (int y = first_row; y < last_row; ++y)
+  {
+    const float* row = source + static_cast<size_t>(y) * width * channels;
+    float* out = destination + static_cast<size_t>(y) * destination_width * channels;
+
+    if (width == 1)
+    {
+      std::copy(row, row + channels, out);
+      continue;
+    }
+
+    for (int x = 0; x < destination_width; ++x)
+    {
+#if defined(BGL_MIP_SIMD)
+      if (channels == 4)
+      {
+        Pixel4 sum = zero4();
+
+        for (int t = 0; t < 8; ++t)
+        {
+          sum = add4(sum, mul4(load4(row + clamp_index(x * 2 - 3 + t, width) * 4), taps_[t]));
+        }
+
+        store4(out + x * 4, sum);
+        continue;
+      }
+#endif
+
+      for (int c = 0; c < channels; ++c)
+      {
+        float sum = 0.0f;
+
+        for (int t = 0; t < 8; ++t)
+        {
+          sum += row[clamp_index(x * 2 - 3 + t, width) * channels + c] * taps_[t];
+        }
+
+        out[x * channels + c] = sum;
+      }
+    }
+  }
+}
+
+void MipmapGenerator::kaiser_columns(const float* source, const int height, const int width,
+                                     const int channels, float* destination, const int first_row,
+                                     const int last_row) const
+{
+  const size_t stride = static_cast<size_t>(width) * channels;
+
+  for (int y = first_row; y < last_row; ++y)
+  {
+    float* out = destination + y * stride;
+
+    if (height == 1)
+    {
+      std::copy(source, source + stride, out);
+      continue;
+    }
+
+    const float* rows[8];
+
+    for (int t = 0; t < 8; ++t)
+    {
+      rows[t] = source + clamp_index(y * 2 - 3 + t, height) * stride;
+    }
+
+#if defined(BGL_MIP_SIMD)
+    if (channels == 4)
+    {
+      for (size_t i = 0; i < stride; i += 4)
+      {
+        Pixel4 sum = zero4();
+
+        for (int t = 0; t < 8; ++t)
+        {
+          sum = add4(sum, mul4(load4(rows[t] + i), taps_[t]));
+        }
+
+        store4(out + i, sum);
+      }
+
+      continue;
+    }
+#endif
+
+    for (size_t i = 0; i < stride; ++i)
+    {
+      float sum = 0.0f;
+
+      for (int t = 0; t < 8; ++t)
+      {
+        sum += rows[t][i] * taps_[t];
+      }
+
+      out[i] = sum;
+    }
+  }
+}
+
+/*
+ * Splits the rows into one contiguous band per thread. Each level depends on
+ * the one above, so the threads are joined before returning
+ */
+template <typename Function>
+void MipmapGenerator::for_rows(const int rows, const size_t pixels, Function function) const
+{
+  size_t threads = pixels >= kParallelThreshold ? std::min(thread_count_,
+                                                           static_cast<size_t>(rows)) : 1;
+
+  if (threads <= 1)
+  {
+    function(0, rows);
+    return;
+  }
+
+  int band = static_cast<int>((rows + threads - 1) / threads);
+  std::vector<std::thread> workers;
+
+  for (size_t t = 0; t < threads; ++t)
+  {
+    int first = std::min(rows, static_cast<int>(t) * band);
+    int last = std::min(rows, first + band);
+
+    workers.emplace_back(function, first, last);
+  }
+
+  for (auto& worker : workers) worker.join();
+}
+} // end of namespace BarelyGL
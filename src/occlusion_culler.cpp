@@ -0,0 +1,218 @@
+//
+// occlusion_culler.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "occlusion_culler.h"
+#include "capabilities.h"
+#include "handle_pool.h"
+
+namespace BarelyGL {
+namespace {
+const char* kVertexSource =
+  "#version 330 core\n"
+  "layout(location = 0) in vec3 position;\n"
+  "uniform mat4 mvp;\n"
+  "void main() { gl_Position = mvp * vec4(position, 1.0); }\n";
+
+const char* kFragmentSource =
+  "#version 330 core\n"
+  "out vec4 color;\n"
+  "void main() { color = vec4(1.0); }\n";
+
+/*
+ * Conservative queries are allowed to report false positives, which lets
+ * the GPU skip the per-sample work (GL 4.3 or ARB_ES3_compatibility)
+ */
+GLenum choose_query_target()
+{
+#if defined(GL_VERSION_4_3)
+  const Capabilities& caps = Capabilities::get();
+
+  if (caps.version_at_least(4, 3) || caps.has_extension("GL_ARB_ES3_compatibility"))
+  {
+    return GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+  }
+#endif
+
+  return GL_ANY_SAMPLES_PASSED;
+}
+} // end of anonymous namespace
+
+OcclusionCuller::OcclusionCuller(const float near_plane)
+  : near_plane_(near_plane)
+  , query_target_(choose_query_target())
+  , vertex_shader_(Shader::from_source(kVertexSource, GL_VERTEX_SHADER))
+  , fragment_shader_(Shader::from_source(kFragmentSource, GL_FRAGMENT_SHADER))
+  , program_(&vertex_shader_, &fragment_shader_)
+  , mvp_location_(glGetUniformLocation(program_.id(), "mvp"))
+  , attributes_({VertexAttribute {3}})
+  , vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW)
+  , index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW)
+{
+  // Corner i has x, y and z from bits 0, 1 and 2 of i
+  std::vector<float> corners;
+
+  for (int i = 0; i < 8; ++i)
+  {
+    corners.push_back(static_cast<float>(i & 1));
+    corners.push_back(static_cast<float>((i >> 1) & 1));
+    corners.push_back(static_cast<float>((i >> 2) & 1));
+  }
+
+  std::vector<int> indices = {
+    0, 2, 1,  1, 2, 3, // -z
+    4, 5, 6,  5, 7, 6, // +z
+    0, 1, 4,  1, 5, 4, // -y
+    2, 6, 3,  3, 6, 7, // +y
+    0, 4, 2,  2, 4, 6, // -x
+    1, 3, 5,  3, 7, 5  // +x
+  };
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.set_vertices(corners);
+  attributes_.enable();
+  index_buffer_.bind();
+  index_buffer_.set_indices(indices);
+  array_.unbind();
+  vertex_buffer_.unbind();
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+  clear();
+}
+
+uint32_t OcclusionCuller::add(const glm::vec3& min, const glm::vec3& max)
+{
+  Object object;
+  object.query = HandlePool::queries().acquire();
+  object.pending = false;
+  object.issued = false;
+  object.visible = true;
+
+  objects_.push_back(object);
+
+  uint32_t index = static_cast<uint32_t>(objects_.size() - 1);
+  set_bounds(index, min, max);
+
+  return index;
+}
+
+void OcclusionCuller::set_bounds(const uint32_t index, const glm::vec3& min, const glm::vec3& max)
+{
+  Object& object = objects_[index];
+
+  for (int i = 0; i < 3; ++i)
+  {
+    object.min[i] = min[i];
+    object.max[i] = max[i];
+  }
+}
+
+void OcclusionCuller::clear()
+{
+  for (const Object& object : objects_)
+  {
+    HandlePool::queries().release(object.query);
+  }
+
+  objects_.clear();
+}
+
+void OcclusionCuller::collect()
+{
+  for (Object& object : objects_)
+  {
+    if (!object.pending) continue;
+
+    GLuint available = 0;
+    glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available)
+    {
+      GLuint samples = 0;
+      glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samples);
+
+      object.visible = samples != 0;
+      object.pending = false;
+    }
+  }
+}
+
+/*
+ * The unit cube is scaled and moved onto each box by the model matrix. If
+ * the camera is inside a box (or close enough for the near plane to clip
+ * it), the front faces are missing and the query would say it's hidden, so
+ * those objects are marked visible without a query
+ */
+void OcclusionCuller::issue_queries(const glm::mat4& view_projection, const glm::vec3& eye)
+{
+  program_.use();
+  array_.bind();
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_FALSE);
+
+  for (Object& object : objects_)
+  {
+    if (object.pending) continue;
+
+    bool inside = true;
+
+    for (int i = 0; i < 3; ++i)
+    {
+      if (eye[i] < object.min[i] - near_plane_ || eye[i] > object.max[i] + near_plane_)
+      {
+        inside = false;
+      }
+    }
+
+    if (inside)
+    {
+      object.visible = true;
+      object.issued = false;
+      continue;
+    }
+
+    glm::mat4 model(1.0f);
+    model[0][0] = object.max[0] - object.min[0];
+    model[1][1] = object.max[1] - object.min[1];
+    model[2][2] = object.max[2] - object.min[2];
+    model[3] = glm::vec4(object.min[0], object.min[1], object.min[2], 1.0f);
+
+    glm::mat4 mvp = view_projection * model;
+    glUniformMatrix4fv(mvp_location_, 1, GL_FALSE, glm::value_ptr(mvp));
+
+    glBeginQuery(query_target_, object.query);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    glEndQuery(query_target_);
+
+    object.pending = true;
+    object.issued = true;
+  }
+
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDepthMask(GL_TRUE);
+  array_.unbind();
+  program_.unbind();
+}
+
+bool OcclusionCuller::begin_conditional(const uint32_t index) const
+{
+  const Object& object = objects_[index];
+
+  if (!object.issued) return false;
+
+  glBeginConditionalRender(object.query, GL_QUERY_NO_WAIT);
+  return true;
+}
+
+void OcclusionCuller::end_conditional() const
+{
+  glEndConditionalRender();
+}
+} // end of namespace BarelyGL
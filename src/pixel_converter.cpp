@@ -0,0 +1,560 @@
+//
+// pixel_converter.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstring>
+#include <OpenGL/gl3.h>
+#include "pixel_converter.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define BGL_PIXEL_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define BGL_PIXEL_NEON
+#endif
+
+namespace BarelyGL {
+namespace {
+/// The number of pixels converted at a time (small enough for the block to stay in L1)
+const size_t kBlockSize = 1024;
+
+typedef void (*ByteKernel)(const uint8_t*, uint8_t*, size_t);
+typedef void (*HalfKernel)(const uint8_t*, uint16_t*, size_t);
+
+/**
+ * @brief The kernels chosen for this machine
+ */
+struct Kernels
+{
+  ByteKernel rgb_to_rgba;
+  ByteKernel swap_red_blue;
+  ByteKernel premultiply_alpha;
+  HalfKernel to_half_float;
+  const char* name;
+};
+
+// === Scalar ===
+
+/*
+ * Converts a float in [0, 1] to half, rounding to nearest even (the values
+ * here are never subnormal, infinite or NaN)
+ */
+uint16_t float_to_half(const float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  if ((bits & 0x7fffffff) == 0) return 0;
+
+  uint32_t exponent = ((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+  uint32_t half = (exponent << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+
+  return static_cast<uint16_t>(half);
+}
+
+const uint16_t* half_table()
+{
+  static uint16_t table[256];
+  static bool built = [] {
+    for (int i = 0; i < 256; ++i) table[i] = float_to_half(i / 255.0f);
+    return true;
+  }();
+
+  (void)built;
+  return table;
+}
+
+/*
+ * Exact x * a / 255, rounded
+ */
+inline uint8_t multiply_255(const unsigned x, const unsigned a)
+{
+  unsigned t = x * a + 128;
+  return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void rgb_to_rgba_scalar(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    destination[i * 4 + 0] = source[i * 3 + 0];
+    destination[i * 4 + 1] = source[i * 3 + 1];
+    destination[i * 4 + 2] = source[i * 3 + 2];
+    destination[i * 4 + 3] = 255;
+  }
+}
+
+void swap_red_blue_scalar(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint8_t red = source[i * 4 + 2];
+    uint8_t blue = source[i * 4 + 0];
+
+    destination[i * 4 + 0] = red;
+    destination[i * 4 + 1] = source[i * 4 + 1];
+    destination[i * 4 + 2] = blue;
+    destination[i * 4 + 3] = source[i * 4 + 3];
+  }
+}
+
+void premultiply_alpha_scalar(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint8_t alpha = source[i * 4 + 3];
+
+    destination[i * 4 + 0] = multiply_255(source[i * 4 + 0], alpha);
+    destination[i * 4 + 1] = multiply_255(source[i * 4 + 1], alpha);
+    destination[i * 4 + 2] = multiply_255(source[i * 4 + 2], alpha);
+    destination[i * 4 + 3] = alpha;
+  }
+}
+
+void to_half_float_scalar(const uint8_t* source, uint16_t* destination, const size_t count)
+{
+  const uint16_t* table = half_table();
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    destination[i] = table[source[i]];
+  }
+}
+
+#if defined(BGL_PIXEL_X86)
+// === SSSE3 / SSE4.1 ===
+
+/*
+ * Reads 16 bytes to convert 4 pixels, so stops while at least 6 pixels are
+ * left to stay inside the source
+ */
+__attribute__((target("ssse3")))
+void rgb_to_rgba_ssse3(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+  size_t i = 0;
+
+  for (; i + 6 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+    v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), v);
+  }
+
+  rgb_to_rgba_scalar(source + i * 3, destination + i * 4, count - i);
+}
+
+__attribute__((target("ssse3")))
+void swap_red_blue_ssse3(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_shuffle_epi8(v, shuffle));
+  }
+
+  swap_red_blue_scalar(source + i * 4, destination + i * 4, count - i);
+}
+
+/*
+ * Widens to 16 bits and multiplies each channel by its pixel's alpha. The
+ * alpha channel itself is multiplied by 255, which leaves it unchanged
+ */
+__attribute__((target("ssse3")))
+void premultiply_alpha_ssse3(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_low = _mm_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1,
+                                          7, -1, 7, -1, 7, -1, -1, -1);
+  const __m128i alpha_high = _mm_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1,
+                                           15, -1, 15, -1, 15, -1, -1, -1);
+  const __m128i keep_alpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+  const __m128i half = _mm_set1_epi16(128);
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+
+    __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero),
+                                  _mm_or_si128(_mm_shuffle_epi8(v, alpha_low), keep_alpha));
+    __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero),
+                                   _mm_or_si128(_mm_shuffle_epi8(v, alpha_high), keep_alpha));
+
+    low = _mm_add_epi16(low, half);
+    high = _mm_add_epi16(high, half);
+    low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+    high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_packus_epi16(low, high));
+  }
+
+  premultiply_alpha_scalar(source + i * 4, destination + i * 4, count - i);
+}
+
+__attribute__((target("sse4.1,f16c")))
+void to_half_float_f16c(const uint8_t* source, uint16_t* destination, const size_t count)
+{
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    int32_t bytes;
+    std::memcpy(&bytes, source + i, sizeof(bytes));
+
+    __m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+    __m128i halves = _mm_cvtps_ph(_mm_mul_ps(v, scale), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + i), halves);
+  }
+
+  to_half_float_scalar(source + i, destination + i, count - i);
+}
+
+// === AVX2 ===
+
+/*
+ * `vpshufb` only shuffles within 128-bit lanes, so each lane is loaded with
+ * its own 4 pixels (12 bytes apart). The second load reads 16 bytes from
+ * pixel 4, hence stopping while at least 10 pixels are left
+ */
+__attribute__((target("avx2")))
+void rgb_to_rgba_avx2(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                           0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+  size_t i = 0;
+
+  for (; i + 10 <= count; i += 8)
+  {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3 + 12));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+
+    v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), v);
+  }
+
+  rgb_to_rgba_ssse3(source + i * 3, destination + i * 4, count - i);
+}
+
+__attribute__((target("avx2")))
+void swap_red_blue_avx2(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                           2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4),
+                        _mm256_shuffle_epi8(v, shuffle));
+  }
+
+  swap_red_blue_ssse3(source + i * 4, destination + i * 4, count - i);
+}
+
+/*
+ * Same as the SSSE3 version; unpacking and packing both work within lanes,
+ * so the same lane-relative alpha shuffles apply to both halves
+ */
+__attribute__((target("avx2")))
+void premultiply_alpha_avx2(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i alpha_low = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1,
+                                             7, -1, 7, -1, 7, -1, -1, -1,
+                                             3, -1, 3, -1, 3, -1, -1, -1,
+                                             7, -1, 7, -1, 7, -1, -1, -1);
+  const __m256i alpha_high = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1,
+                                              15, -1, 15, -1, 15, -1, -1, -1,
+                                              11, -1, 11, -1, 11, -1, -1, -1,
+                                              15, -1, 15, -1, 15, -1, -1, -1);
+  const __m256i keep_alpha = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255,
+                                               0, 0, 0, 255, 0, 0, 0, 255);
+  const __m256i half = _mm256_set1_epi16(128);
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+
+    __m256i low = _mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero),
+                                     _mm256_or_si256(_mm256_shuffle_epi8(v, alpha_low),
+                                                     keep_alpha));
+    __m256i high = _mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero),
+                                      _mm256_or_si256(_mm256_shuffle_epi8(v, alpha_high),
+                                                      keep_alpha));
+
+    low = _mm256_add_epi16(low, half);
+    high = _mm256_add_epi16(high, half);
+    low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+    high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4),
+                        _mm256_packus_epi16(low, high));
+  }
+
+  premultiply_alpha_ssse3(source + i * 4, destination + i * 4, count - i);
+}
+
+__attribute__((target("avx2,f16c")))
+void to_half_float_avx2(const uint8_t* source, uint16_t* destination, const size_t count)
+{
+  const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+    __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    __m128i halves = _mm256_cvtps_ph(_mm256_mul_ps(v, scale), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), halves);
+  }
+
+  to_half_float_f16c(source + i, destination + i, count - i);
+}
+#endif
+
+#if defined(BGL_PIXEL_NEON)
+// === NEON ===
+
+void rgb_to_rgba_neon(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 16 <= count; i += 16)
+  {
+    uint8x16x3_t rgb = vld3q_u8(source + i * 3);
+    uint8x16x4_t rgba;
+
+    rgba.val[0] = rgb.val[0];
+    rgba.val[1] = rgb.val[1];
+    rgba.val[2] = rgb.val[2];
+    rgba.val[3] = vdupq_n_u8(255);
+    vst4q_u8(destination + i * 4, rgba);
+  }
+
+  rgb_to_rgba_scalar(source + i * 3, destination + i * 4, count - i);
+}
+
+void swap_red_blue_neon(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 16 <= count; i += 16)
+  {
+    uint8x16x4_t v = vld4q_u8(source + i * 4);
+    uint8x16_t red = v.val[2];
+
+    v.val[2] = v.val[0];
+    v.val[0] = red;
+    vst4q_u8(destination + i * 4, v);
+  }
+
+  swap_red_blue_scalar(source + i * 4, destination + i * 4, count - i);
+}
+
+/*
+ * (x + ((x + 128) >> 8) + 128) >> 8 with x = c * a, which is the same
+ * exact rounding as the scalar version
+ */
+inline uint8x8_t multiply_255_neon(const uint8x8_t c, const uint8x8_t a)
+{
+  uint16x8_t product = vmull_u8(c, a);
+  return vrshrn_n_u16(vrsraq_n_u16(product, product, 8), 8);
+}
+
+void premultiply_alpha_neon(const uint8_t* source, uint8_t* destination, const size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    uint8x8x4_t v = vld4_u8(source + i * 4);
+
+    v.val[0] = multiply_255_neon(v.val[0], v.val[3]);
+    v.val[1] = multiply_255_neon(v.val[1], v.val[3]);
+    v.val[2] = multiply_255_neon(v.val[2], v.val[3]);
+    vst4_u8(destination + i * 4, v);
+  }
+
+  premultiply_alpha_scalar(source + i * 4, destination + i * 4, count - i);
+}
+
+#if defined(__aarch64__)
+void to_half_float_neon(const uint8_t* source, uint16_t* destination, const size_t count)
+{
+  const float32x4_t scale = vdupq_n_f32(1.0f / 255.0f);
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    uint16x8_t wide = vmovl_u8(vld1_u8(source + i));
+    float32x4_t low = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide))), scale);
+    float32x4_t high = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide))), scale);
+
+    vst1q_u16(destination + i, vreinterpretq_u16_f16(vcvt_high_f16_f32(vcvt_f16_f32(low), high)));
+  }
+
+  to_half_float_scalar(source + i, destination + i, count - i);
+}
+#endif
+#endif
+
+/*
+ * Picks the fastest kernels once. x86 asks the CPU what it supports, since
+ * the library is built for the baseline; ARM uses what it was compiled for
+ */
+Kernels select_kernels()
+{
+  Kernels kernels = {rgb_to_rgba_scalar, swap_red_blue_scalar, premultiply_alpha_scalar,
+                     to_half_float_scalar, "scalar"};
+
+#if defined(BGL_PIXEL_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    kernels.rgb_to_rgba = rgb_to_rgba_ssse3;
+    kernels.swap_red_blue = swap_red_blue_ssse3;
+    kernels.premultiply_alpha = premultiply_alpha_ssse3;
+    kernels.name = "SSSE3";
+
+    // F16C arrived after SSE4.1, but check both to be safe
+    if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("f16c"))
+    {
+      kernels.to_half_float = to_half_float_f16c;
+    }
+  }
+
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+  {
+    kernels.rgb_to_rgba = rgb_to_rgba_avx2;
+    kernels.swap_red_blue = swap_red_blue_avx2;
+    kernels.premultiply_alpha = premultiply_alpha_avx2;
+    kernels.to_half_float = to_half_float_avx2;
+    kernels.name = "AVX2";
+  }
+#elif defined(BGL_PIXEL_NEON)
+  kernels.rgb_to_rgba = rgb_to_rgba_neon;
+  kernels.swap_red_blue = swap_red_blue_neon;
+  kernels.premultiply_alpha = premultiply_alpha_neon;
+  kernels.name = "NEON";
+
+#if defined(__aarch64__)
+  kernels.to_half_float = to_half_float_neon;
+#endif
+#endif
+
+  return kernels;
+}
+
+const Kernels& kernels()
+{
+  static const Kernels selected = select_kernels();
+  return selected;
+}
+} // end of anonymous namespace
+
+PixelConverter::PixelConverter(const Source source, const bool premultiply, const bool half_float)
+  : source_(source)
+  , premultiply_(premultiply)
+  , half_float_(half_float)
+{
+}
+
+/*
+ * Runs every step on one block before moving to the next. Byte output is
+ * built up in the destination itself; half float output goes through a
+ * block sized buffer first. RGB input is opaque, so premultiplying it would
+ * change nothing and is skipped
+ */
+void PixelConverter::convert(const uint8_t* source, void* destination,
+                             const size_t pixel_count) const
+{
+  const Kernels& k = kernels();
+  uint8_t block[kBlockSize * 4];
+
+  for (size_t first = 0; first < pixel_count; first += kBlockSize)
+  {
+    const size_t count = std::min(kBlockSize, pixel_count - first);
+    const uint8_t* in = source + first * source_pixel_size();
+    uint8_t* out = half_float_ ? block : static_cast<uint8_t*>(destination) + first * 4;
+
+    switch (source_)
+    {
+      case Source::RGB:  k.rgb_to_rgba(in, out, count); in = out; break;
+      case Source::BGRA: k.swap_red_blue(in, out, count); in = out; break;
+      case Source::RGBA: break;
+    }
+
+    if (premultiply_ && source_ != Source::RGB)
+    {
+      k.premultiply_alpha(in, out, count);
+      in = out;
+    }
+
+    if (half_float_)
+    {
+      k.to_half_float(in, static_cast<uint16_t*>(destination) + first * 4, count * 4);
+    }
+    else if (in != out)
+    {
+      std::memcpy(out, in, count * 4);
+    }
+  }
+}
+
+GLenum PixelConverter::format() const
+{
+  return GL_RGBA;
+}
+
+GLenum PixelConverter::type() const
+{
+  return half_float_ ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+}
+
+void PixelConverter::rgb_to_rgba(const uint8_t* source, uint8_t* destination,
+                                 const size_t pixel_count)
+{
+  kernels().rgb_to_rgba(source, destination, pixel_count);
+}
+
+void PixelConverter::swap_red_blue(const uint8_t* source, uint8_t* destination,
+                                   const size_t pixel_count)
+{
+  kernels().swap_red_blue(source, destination, pixel_count);
+}
+
+void PixelConverter::premultiply_alpha(const uint8_t* source, uint8_t* destination,
+                                       const size_t pixel_count)
+{
+  kernels().premultiply_alpha(source, destination, pixel_count);
+}
+
+void PixelConverter::to_half_float(const uint8_t* source, uint16_t* destination,
+                                   const size_t value_count)
+{
+  kernels().to_half_float(source, destination, value_count);
+}
+
+const char* PixelConverter::instruction_set()
+{
+  return kernels().name;
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,103 @@
+//
+// range_allocator.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <iterator>
+#include "range_allocator.h"
+
+namespace BarelyGL {
+const size_t RangeAllocator::npos;
+
+RangeAllocator::RangeAllocator(const size_t capacity)
+  : capacity_(capacity)
+  , free_size_(0)
+{
+  reset(0);
+}
+
+size_t RangeAllocator::allocate(const size_t size)
+{
+  if (size == 0) return npos;
+
+  for (auto it = free_.begin(); it != free_.end(); ++it)
+  {
+    if (it->second >= size)
+    {
+      size_t offset = it->first;
+      size_t remaining = it->second - size;
+
+      free_.erase(it);
+
+      if (remaining > 0) free_[offset + size] = remaining;
+
+      free_size_ -= size;
+
+      return offset;
+    }
+  }
+
+  return npos;
+}
+
+/*
+ * Inserts the range into the free list, merging it with the free ranges
+ * directly before and after it (if they touch)
+ */
+void RangeAllocator::free(size_t offset, size_t size)
+{
+  if (size == 0) return;
+
+  free_size_ += size;
+
+  auto next = free_.lower_bound(offset);
+
+  if (next != free_.begin())
+  {
+    auto prev = std::prev(next);
+
+    if (prev->first + prev->second == offset)
+    {
+      offset = prev->first;
+      size += prev->second;
+      free_.erase(prev);
+    }
+  }
+
+  if (next != free_.end() && offset + size == next->first)
+  {
+    size += next->second;
+    free_.erase(next);
+  }
+
+  free_[offset] = size;
+}
+
+void RangeAllocator::reset(const size_t used)
+{
+  free_.clear();
+
+  if (used < capacity_) free_[used] = capacity_ - used;
+
+  free_size_ = capacity_ - used;
+}
+
+size_t RangeAllocator::largest_free() const
+{
+  size_t largest = 0;
+
+  for (auto& range : free_)
+  {
+    if (range.second > largest) largest = range.second;
+  }
+
+  return largest;
+}
+
+float RangeAllocator::fragmentation() const
+{
+  if (free_size_ == 0) return 0.0f;
+
+  return 1.0f - static_cast<float>(largest_free()) / static_cast<float>(free_size_);
+}
+} // end of namespace BarelyGL
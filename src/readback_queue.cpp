@@ -0,0 +1,229 @@
+//
+// readback_queue.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "readback_queue.h"
+#include "handle_pool.h"
+#include "memory_tracker.h"
+#include "exception.h"
+#include <cstring>
+
+namespace BarelyGL {
+namespace {
+size_t bytes_per_pixel(const GLenum format, const GLenum type)
+{
+  size_t components = 0;
+
+  switch (format)
+  {
+    case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: case GL_BGR: components = 3; break;
+    case GL_RGBA: case GL_BGRA: components = 4; break;
+    default: throw Exception("Unsupported readback format");
+  }
+
+  switch (type)
+  {
+    case GL_UNSIGNED_BYTE: return components;
+    case GL_HALF_FLOAT: return components * 2;
+    case GL_FLOAT: case GL_UNSIGNED_INT: return components * 4;
+    default: throw Exception("Unsupported readback type");
+  }
+}
+}
+
+ReadbackQueue::ReadbackQueue(Callback callback, const size_t ring_size)
+  : callback_(std::move(callback))
+  , slots_(ring_size > 0 ? ring_size : 1)
+{
+  for (Slot& slot : slots_)
+  {
+    slot.buffer = HandlePool::buffers().acquire();
+    slot.capacity = 0;
+  }
+
+  worker_ = std::thread(&ReadbackQueue::work, this);
+}
+
+/*
+ * The data store is only reallocated when a readback needs more room than the
+ * buffer has, so captures of the same size keep reusing the same memory
+ */
+bool ReadbackQueue::capture(const int x, const int y, const int width, const int height,
+                            const GLenum format, const GLenum type, const uint64_t tag)
+{
+  const size_t size = bytes_per_pixel(format, type) * width * height;
+
+  if (pending_ == slots_.size())
+  {
+    ++dropped_;
+    return false;
+  }
+
+  Slot& slot = slots_[(head_ + pending_) % slots_.size()];
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+  if (slot.capacity < size)
+  {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    MemoryTracker::get().resize(MemoryTracker::Category::PixelBuffers, slot.capacity, size);
+    slot.capacity = size;
+  }
+
+  // Rows are tightly packed, but the caller's pack alignment is left as it was
+  GLint alignment = 4;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(x, y, width, height, format, type, nullptr);
+  glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.result.tag = tag;
+  slot.result.width = width;
+  slot.result.height = height;
+  slot.result.format = format;
+  slot.result.type = type;
+
+  // Flushed, otherwise polling the fence may never see it signalled
+  slot.fence.place();
+
+  ++pending_;
+  return true;
+}
+
+/*
+ * Fences signal in submission order, so polling stops at the first
+ * readback that isn't finished. An exception the callback threw on the worker
+ * is rethrown here first, so it reaches the caller instead of terminating
+ */
+size_t ReadbackQueue::poll()
+{
+  std::exception_ptr error;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error.swap(error_);
+  }
+
+  if (error) std::rethrow_exception(error);
+
+  size_t finished = 0;
+
+  while (pending_ > 0)
+  {
+    Slot& slot = slots_[head_];
+
+    if (!slot.fence.signalled()) break;
+
+    ReadbackResult result = slot.result;
+    const size_t size = bytes_per_pixel(result.format, result.type) * result.width
+                        * result.height;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (!spare_.empty())
+      {
+        result.pixels.swap(spare_.back());
+        spare_.pop_back();
+      }
+    }
+
+    result.pixels.resize(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+    if (data != nullptr)
+    {
+      std::memcpy(result.pixels.data(), data, size);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      results_.push_back(std::move(result));
+      ready_.notify_one();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    head_ = (head_ + 1) % slots_.size();
+    --pending_;
+    ++finished;
+  }
+
+  return finished;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void ReadbackQueue::work()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (;;)
+  {
+    ready_.wait(lock, [this] { return stopping_ || !results_.empty(); });
+
+    if (results_.empty()) return;
+
+    ReadbackResult result = std::move(results_.front());
+    results_.pop_front();
+
+    lock.unlock();
+
+    std::exception_ptr error;
+
+    try
+    {
+      callback_(result);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+
+    if (error && !error_) error_ = error;
+
+    spare_.push_back(std::move(result.pixels));
+  }
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  ready_.notify_one();
+  worker_.join();
+
+  /*
+   * Released names keep their data store until reused, so it is orphaned
+   * first to actually free what the tracker stops counting
+   */
+  for (Slot& slot : slots_)
+  {
+    if (slot.capacity > 0)
+    {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      glBufferData(GL_PIXEL_PACK_BUFFER, 0, nullptr, GL_STREAM_READ);
+      MemoryTracker::get().resize(MemoryTracker::Category::PixelBuffers, slot.capacity, 0);
+    }
+
+    HandlePool::buffers().release(slot.buffer);
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+} // end of namespace BarelyGL
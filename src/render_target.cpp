@@ -0,0 +1,139 @@
+//
+// render_target.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "render_target.h"
+#include "mipmap_generator.h"
+#include "texture_units.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/*
+ * Texture needs a pixel format to go with the internal format, even though
+ * no data is uploaded
+ */
+GLenum pixel_format(const GLenum internal_format)
+{
+  switch (internal_format)
+  {
+    case GL_R8: case GL_R16F: case GL_R32F:
+      return GL_RED;
+    case GL_RG8: case GL_RG16F: case GL_RG32F:
+      return GL_RG;
+    case GL_RGB8: case GL_RGB16F: case GL_RGB32F: case GL_R11F_G11F_B10F:
+      return GL_RGB;
+    default:
+      return GL_RGBA;
+  }
+}
+
+bool has_stencil(const GLenum depth_format)
+{
+  return depth_format == GL_DEPTH24_STENCIL8 || depth_format == GL_DEPTH32F_STENCIL8;
+}
+}
+
+RenderTarget::RenderTarget(const RenderTargetDescription& description)
+  : description_(description)
+  , depth_attachment_(has_stencil(description.depth_format) ? GL_DEPTH_STENCIL_ATTACHMENT
+                                                            : GL_DEPTH_ATTACHMENT)
+{
+  const int width = description_.width;
+  const int height = description_.height;
+
+  framebuffer_.bind();
+
+  if (description_.samples > 0)
+  {
+    color_buffer_.reset(new Renderbuffer(width, height, description_.color_format,
+                                         description_.samples));
+    framebuffer_.attach(GL_COLOR_ATTACHMENT0, *color_buffer_);
+  }
+  else
+  {
+    // Mipmap levels are allocated empty, to be filled by `generate_mipmaps()`
+    std::vector<std::vector<uint8_t>> mipmaps;
+
+    if (description_.mipmaps)
+    {
+      mipmaps.resize(MipmapGenerator::level_count(width, height) - 1);
+    }
+
+    color_texture_.reset(new Texture(width, height, pixel_format(description_.color_format),
+                                     description_.color_format, nullptr, mipmaps));
+    framebuffer_.attach(GL_COLOR_ATTACHMENT0, *color_texture_);
+  }
+
+  if (description_.depth_format != 0)
+  {
+    depth_buffer_.reset(new Renderbuffer(width, height, description_.depth_format,
+                                         description_.samples));
+    framebuffer_.attach(depth_attachment_, *depth_buffer_);
+  }
+
+  try
+  {
+    framebuffer_.check();
+  }
+  catch (...)
+  {
+    framebuffer_.unbind();
+    throw;
+  }
+
+  framebuffer_.unbind();
+}
+
+void RenderTarget::bind() const
+{
+  framebuffer_.bind();
+  glViewport(0, 0, description_.width, description_.height);
+}
+
+void RenderTarget::unbind() const
+{
+  framebuffer_.unbind();
+}
+
+void RenderTarget::resolve_to(RenderTarget& destination)
+{
+  if (destination.description_.width != description_.width
+      || destination.description_.height != description_.height)
+  {
+    throw Exception("Can only resolve into a target of the same size");
+  }
+
+  framebuffer_.resolve_to(&destination.framebuffer_, description_.width, description_.height);
+
+  framebuffer_.bind();
+
+  if (depth_buffer_)
+  {
+    framebuffer_.invalidate({ GL_COLOR_ATTACHMENT0, depth_attachment_ });
+  }
+  else
+  {
+    framebuffer_.invalidate({ GL_COLOR_ATTACHMENT0 });
+  }
+
+  framebuffer_.unbind();
+}
+
+void RenderTarget::generate_mipmaps()
+{
+  if (!color_texture_ || color_texture_->levels() == 1) return;
+
+  color_texture_->bind();
+  color_texture_->generate_mipmaps();
+  color_texture_->unbind();
+  TextureUnits::get().invalidate_active();
+}
+
+void RenderTarget::discard_depth()
+{
+  if (depth_buffer_) framebuffer_.invalidate({ depth_attachment_ });
+}
+} // end of namespace BarelyGL
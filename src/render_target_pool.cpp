@@ -0,0 +1,74 @@
+//
+// render_target_pool.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "render_target_pool.h"
+#include "exception.h"
+#include <algorithm>
+
+namespace BarelyGL {
+RenderTargetPool::RenderTargetPool(const unsigned max_idle_frames)
+  : max_idle_frames_(max_idle_frames)
+{
+}
+
+RenderTarget& RenderTargetPool::acquire(const RenderTargetDescription& description)
+{
+  for (Entry& entry : entries_)
+  {
+    if (!entry.in_use && entry.target->description() == description)
+    {
+      entry.in_use = true;
+      entry.last_used = frame_;
+      return *entry.target;
+    }
+  }
+
+  std::unique_ptr<RenderTarget> target(new RenderTarget(description));
+  entries_.push_back({ std::move(target), true, frame_ });
+
+  return *entries_.back().target;
+}
+
+void RenderTargetPool::release(const RenderTarget& target)
+{
+  for (Entry& entry : entries_)
+  {
+    if (entry.target.get() == &target)
+    {
+      entry.in_use = false;
+      return;
+    }
+  }
+
+  throw Exception("Render target was not acquired from this pool");
+}
+
+void RenderTargetPool::end_frame()
+{
+  ++frame_;
+
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [this](const Entry& entry)
+                                {
+                                  return !entry.in_use
+                                    && frame_ - entry.last_used > max_idle_frames_;
+                                }),
+                 entries_.end());
+}
+
+void RenderTargetPool::trim()
+{
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [](const Entry& entry) { return !entry.in_use; }),
+                 entries_.end());
+}
+
+size_t RenderTargetPool::in_use() const
+{
+  return std::count_if(entries_.begin(), entries_.end(),
+                       [](const Entry& entry) { return entry.in_use; });
+}
+} // end of namespace BarelyGL
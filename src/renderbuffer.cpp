@@ -0,0 +1,115 @@
+//
+// renderbuffer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "renderbuffer.h"
+#include "handle_pool.h"
+#include "memory_tracker.h"
+#include "exception.h"
+#include <algorithm>
+
+namespace BarelyGL {
+/*
+ * The sample count is clamped to what the implementation supports, since
+ * asking for more is an error rather than a hint
+ */
+Renderbuffer::Renderbuffer(const int width, const int height, const GLenum internal_format,
+                           const int samples)
+  : width_(width)
+  , height_(height)
+  , internal_format_(internal_format)
+  , samples_(samples)
+{
+  if (width <= 0 || height <= 0)
+  {
+    throw Exception("Renderbuffer must have a non-zero size");
+  }
+
+  if (samples_ < 0) samples_ = 0;
+
+  if (samples_ > 0)
+  {
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+
+    if (samples_ > max_samples) samples_ = max_samples;
+  }
+
+  id_ = HandlePool::renderbuffers().acquire();
+
+  bind();
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples_, internal_format_, width_, height_);
+  unbind();
+
+  MemoryTracker::get().resize(MemoryTracker::Category::Renderbuffers, 0, byte_size());
+}
+
+Renderbuffer::Renderbuffer(Renderbuffer&& other) noexcept
+  : id_(other.id_)
+  , width_(other.width_)
+  , height_(other.height_)
+  , internal_format_(other.internal_format_)
+  , samples_(other.samples_)
+{
+  other.id_ = 0;
+}
+
+Renderbuffer& Renderbuffer::operator=(Renderbuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    width_ = other.width_;
+    height_ = other.height_;
+    internal_format_ = other.internal_format_;
+    samples_ = other.samples_;
+
+    other.id_ = 0;
+  }
+
+  return *this;
+}
+
+void Renderbuffer::bind() const
+{
+  glBindRenderbuffer(GL_RENDERBUFFER, id_);
+}
+
+void Renderbuffer::unbind() const
+{
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+size_t Renderbuffer::byte_size() const
+{
+  if (id_ == 0) return 0;
+
+  return static_cast<size_t>(width_) * height_ * std::max(1, samples_)
+         * MemoryTracker::texel_size(internal_format_);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void Renderbuffer::destroy()
+{
+  if (id_ != 0)
+  {
+    MemoryTracker::get().resize(MemoryTracker::Category::Renderbuffers, byte_size(), 0);
+    HandlePool::renderbuffers().release(id_);
+    id_ = 0;
+  }
+}
+
+Renderbuffer::~Renderbuffer()
+{
+  destroy();
+}
+} // end of namespace BarelyGL
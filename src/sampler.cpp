@@ -0,0 +1,210 @@
+//
+// sampler.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "sampler.h"
+#include "texture_units.h"
+#include "capabilities.h"
+#include "exception.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+// Anisotropic filtering is core in 4.6 but has been an extension for much longer
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+  #define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+  #define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+namespace BarelyGL {
+namespace {
+/*
+ * The most anisotropy the context supports, or 0 if it doesn't support
+ * anisotropic filtering at all
+ */
+float max_supported_anisotropy()
+{
+  static float max_anisotropy = -1.0f;
+
+  if (max_anisotropy < 0.0f)
+  {
+    const Capabilities& caps = Capabilities::get();
+    max_anisotropy = 0.0f;
+
+    if (caps.version_at_least(4, 6) || caps.has_extension("GL_ARB_texture_filter_anisotropic")
+        || caps.has_extension("GL_EXT_texture_filter_anisotropic"))
+    {
+      glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+    }
+  }
+
+  return max_anisotropy;
+}
+} // end of anonymous namespace
+
+SamplerState SamplerState::nearest_clamp()
+{
+  return SamplerState {GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER,
+                       GL_CLAMP_TO_BORDER, 1.0f, 0.0f, {0.0f, 0.0f, 0.0f, 0.0f}};
+}
+
+SamplerState SamplerState::linear_clamp()
+{
+  return SamplerState {GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE,
+                       GL_CLAMP_TO_EDGE, 1.0f, 0.0f, {0.0f, 0.0f, 0.0f, 0.0f}};
+}
+
+SamplerState SamplerState::trilinear_repeat()
+{
+  return SamplerState {GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT, GL_REPEAT,
+                       1.0f, 0.0f, {0.0f, 0.0f, 0.0f, 0.0f}};
+}
+
+SamplerState SamplerState::anisotropic_repeat(const float max_anisotropy)
+{
+  SamplerState state = trilinear_repeat();
+  state.max_anisotropy = max_anisotropy;
+
+  return state;
+}
+
+bool SamplerState::operator==(const SamplerState& other) const
+{
+  return min_filter == other.min_filter && mag_filter == other.mag_filter
+    && wrap_s == other.wrap_s && wrap_t == other.wrap_t && wrap_r == other.wrap_r
+    && max_anisotropy == other.max_anisotropy && lod_bias == other.lod_bias
+    && std::equal(border_color, border_color + 4, other.border_color);
+}
+
+/*
+ * Combines the hash of every member, using the bit patterns of the floats
+ * so that it agrees with `operator==` (apart from -0 and NaN, which no one
+ * should be using here)
+ */
+size_t SamplerStateHash::operator()(const SamplerState& state) const
+{
+  size_t hash = 0;
+
+  auto combine = [&hash](const size_t value)
+  {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  };
+
+  auto float_bits = [](const float value)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return static_cast<size_t>(bits);
+  };
+
+  combine(state.min_filter);
+  combine(state.mag_filter);
+  combine(state.wrap_s);
+  combine(state.wrap_t);
+  combine(state.wrap_r);
+  combine(float_bits(state.max_anisotropy));
+  combine(float_bits(state.lod_bias));
+
+  for (float component : state.border_color)
+  {
+    combine(float_bits(component));
+  }
+
+  return hash;
+}
+
+Sampler::Sampler(const SamplerState& state)
+  : state_(state)
+{
+  glGenSamplers(1, &id_);
+
+  if (id_ == 0) throw Exception("Could not generate sampler");
+
+  set_parameters();
+}
+
+Sampler::Sampler(Sampler&& other) noexcept
+  : id_(other.id_)
+  , state_(other.state_)
+{
+  other.id_ = 0;
+}
+
+Sampler& Sampler::operator=(Sampler&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    state_ = other.state_;
+
+    other.id_ = 0;
+  }
+
+  return *this;
+}
+
+void Sampler::bind(const GLuint unit) const
+{
+  glBindSampler(unit, id_);
+}
+
+void Sampler::unbind(const GLuint unit) const
+{
+  glBindSampler(unit, 0);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * Anisotropy is only set if it is asked for and supported, and is clamped to
+ * the supported maximum since larger values are an error
+ */
+void Sampler::set_parameters()
+{
+  glSamplerParameteri(id_, GL_TEXTURE_MIN_FILTER, state_.min_filter);
+  glSamplerParameteri(id_, GL_TEXTURE_MAG_FILTER, state_.mag_filter);
+  glSamplerParameteri(id_, GL_TEXTURE_WRAP_S, state_.wrap_s);
+  glSamplerParameteri(id_, GL_TEXTURE_WRAP_T, state_.wrap_t);
+  glSamplerParameteri(id_, GL_TEXTURE_WRAP_R, state_.wrap_r);
+  glSamplerParameterf(id_, GL_TEXTURE_LOD_BIAS, state_.lod_bias);
+  glSamplerParameterfv(id_, GL_TEXTURE_BORDER_COLOR, state_.border_color);
+
+  if (state_.max_anisotropy > 1.0f)
+  {
+    float max_anisotropy = max_supported_anisotropy();
+
+    if (max_anisotropy > 0.0f)
+    {
+      glSamplerParameterf(id_, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                          std::min(state_.max_anisotropy, max_anisotropy));
+    }
+  }
+}
+
+void Sampler::destroy()
+{
+  if (id_ != 0)
+  {
+    // Deleting unbinds it from every unit, and the name may be reused
+    TextureUnits::get().invalidate_sampler(id_);
+    glDeleteSamplers(1, &id_);
+    id_ = 0;
+  }
+}
+
+Sampler::~Sampler()
+{
+  destroy();
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,27 @@
+//
+// sampler_cache.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "sampler_cache.h"
+
+namespace BarelyGL {
+SamplerCache& SamplerCache::get()
+{
+  static SamplerCache cache;
+  return cache;
+}
+
+const Sampler& SamplerCache::sampler(const SamplerState& state)
+{
+  auto found = samplers_.find(state);
+
+  if (found == samplers_.end())
+  {
+    found = samplers_.emplace(state, Sampler(state)).first;
+  }
+
+  return found->second;
+}
+} // end of namespace BarelyGL
@@ -20,6 +20,44 @@ Shader::Shader(const std::string& file_path, const GLenum shader_type)
   compile();
 }
 
+Shader Shader::from_source(const std::string& source, const GLenum shader_type)
+{
+  Shader shader(shader_type);
+
+  shader.file_path_ = "<source>";
+  shader.shader_string_ = source;
+  shader.create();
+  shader.compile();
+
+  return shader;
+}
+
+Shader::Shader(Shader&& other) noexcept
+  : id_(other.id_)
+  , shader_type_(other.shader_type_)
+  , file_path_(std::move(other.file_path_))
+  , shader_string_(std::move(other.shader_string_))
+{
+  other.id_ = 0;
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    shader_type_ = other.shader_type_;
+    file_path_ = std::move(other.file_path_);
+    shader_string_ = std::move(other.shader_string_);
+
+    other.id_ = 0;
+  }
+
+  return *this;
+}
+
 Shader::~Shader()
 {
   destroy();
@@ -31,6 +69,11 @@ Shader::~Shader()
 // =============================
 //
 
+Shader::Shader(const GLenum shader_type)
+  : shader_type_(shader_type)
+{
+}
+
 void Shader::create()
 {
   id_ = glCreateShader(shader_type_);
@@ -97,6 +140,7 @@ void Shader::destroy()
   if (id_ != 0)
   {
     glDeleteShader(id_);
+    id_ = 0;
   }
 }
 } // end of namespace BarelyGL
@@ -8,14 +8,42 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "shader_program.h"
 #include "shader.h"
+#include "capabilities.h"
 #include "exception.h"
 
 namespace BarelyGL {
 ShaderProgram::ShaderProgram(const Shader* vertex_shader, const Shader* fragment_shader)
-  : vertex_shader_(vertex_shader)
-  , fragment_shader_(fragment_shader)
+  : ShaderProgram(std::vector<const Shader*>{vertex_shader, fragment_shader})
+{
+}
+
+ShaderProgram::ShaderProgram(const std::vector<const Shader*>& shaders)
+  : shaders_(shaders)
 {
   link();
+  shaders_.clear();
+}
+
+ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
+  : id_(other.id_)
+  , compute_(other.compute_)
+{
+  other.id_ = 0;
+}
+
+ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    compute_ = other.compute_;
+
+    other.id_ = 0;
+  }
+
+  return *this;
 }
 
 void ShaderProgram::use() const
@@ -45,6 +73,31 @@ void ShaderProgram::set_uniform(const std::string& name, const glm::mat4 matrix)
   }
 }
 
+void ShaderProgram::dispatch(const GLuint x, const GLuint y, const GLuint z) const
+{
+  if (!compute_) throw Exception("Program has no compute shader");
+
+#if defined(GL_VERSION_4_3)
+  glDispatchCompute(x, y, z);
+#else
+  (void)x; (void)y; (void)z;
+#endif
+}
+
+void ShaderProgram::memory_barrier(const GLbitfield barriers)
+{
+#if defined(GL_VERSION_4_2)
+  const Capabilities& caps = Capabilities::get();
+
+  if (caps.version_at_least(4, 2) || caps.has_extension("GL_ARB_shader_image_load_store"))
+  {
+    glMemoryBarrier(barriers);
+  }
+#else
+  (void)barriers;
+#endif
+}
+
 void ShaderProgram::unbind() const
 {
   glUseProgram(0);
@@ -62,26 +115,49 @@ ShaderProgram::~ShaderProgram()
 //
 
 /*
- * Creates a new program, then attaches the vertex and fragment shaders and
- * then attempts to link the program. If it fails, an exception is raised
- * containing the program info log
+ * Creates a new program, then attaches the shaders and then attempts to link
+ * the program. If it fails, an exception is raised containing the program
+ * info log
  */
 void ShaderProgram::link()
 {
+  if (shaders_.empty()) throw Exception("Program has no shaders");
+
+#if defined(GL_VERSION_4_3)
+  for (const Shader* shader : shaders_)
+  {
+    if (shader->type() == GL_COMPUTE_SHADER) compute_ = true;
+  }
+
+  if (compute_ && shaders_.size() > 1)
+  {
+    throw Exception("Compute shaders can't be linked with other stages");
+  }
+
+  if (compute_ && !Capabilities::get().compute_shaders())
+  {
+    throw Exception("Compute shaders are not supported");
+  }
+#endif
+
   id_ = glCreateProgram();
 
   if (id_ != 0)
   {
-    glAttachShader(id_, vertex_shader_->id());
-    glAttachShader(id_, fragment_shader_->id());
+    for (const Shader* shader : shaders_)
+    {
+      glAttachShader(id_, shader->id());
+    }
 
     glLinkProgram(id_);
 
     GLint status;
     glGetProgramiv(id_, GL_LINK_STATUS, &status);
 
-    glDetachShader(id_, vertex_shader_->id());
-    glDetachShader(id_, fragment_shader_->id());
+    for (const Shader* shader : shaders_)
+    {
+      glDetachShader(id_, shader->id());
+    }
 
     if (status == GL_FALSE)
     {
@@ -111,6 +187,7 @@ void ShaderProgram::destroy()
   if (id_ != 0)
   {
     glDeleteProgram(id_);
+    id_ = 0;
   }
 }
 } // end of namespace BarelyGL
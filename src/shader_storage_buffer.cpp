@@ -0,0 +1,151 @@
+//
+// shader_storage_buffer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "shader_storage_buffer.h"
+#include "handle_pool.h"
+#include "capabilities.h"
+#include "memory_tracker.h"
+#include "exception.h"
+
+namespace BarelyGL {
+ShaderStorageBuffer::ShaderStorageBuffer(const GLsizeiptr size, const GLenum usage,
+                                         const void* data)
+  : usage_(usage)
+{
+  if (!Capabilities::get().compute_shaders())
+  {
+    throw Exception("Shader storage buffers are not supported");
+  }
+
+  id_ = HandlePool::buffers().acquire();
+  set_data(size, data);
+}
+
+ShaderStorageBuffer::ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+  : id_(other.id_)
+  , usage_(other.usage_)
+  , size_(other.size_)
+{
+  other.id_ = 0;
+  other.size_ = 0;
+}
+
+ShaderStorageBuffer& ShaderStorageBuffer::operator=(ShaderStorageBuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    usage_ = other.usage_;
+    size_ = other.size_;
+
+    other.id_ = 0;
+    other.size_ = 0;
+  }
+
+  return *this;
+}
+
+void ShaderStorageBuffer::bind_base(const GLuint index) const
+{
+#if defined(GL_VERSION_4_3)
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, id_);
+#else
+  (void)index;
+#endif
+}
+
+void ShaderStorageBuffer::bind_range(const GLuint index, const GLintptr offset,
+                                     const GLsizeiptr size) const
+{
+#if defined(GL_VERSION_4_3)
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, id_, offset, size);
+#else
+  (void)index; (void)offset; (void)size;
+#endif
+}
+
+void ShaderStorageBuffer::bind(const GLenum target) const
+{
+  glBindBuffer(target, id_);
+}
+
+void ShaderStorageBuffer::set_data(const GLsizeiptr size, const void* data)
+{
+  MemoryTracker::get().resize(MemoryTracker::Category::StorageBuffers, size_, size);
+  size_ = size;
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferData(id_, size, data, usage_);
+    return;
+  }
+#endif
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id_);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage_);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ShaderStorageBuffer::sub_data(const GLintptr offset, const GLsizeiptr size,
+                                   const void* data)
+{
+  if (offset < 0 || offset + size > size_) throw Exception("Buffer range out of bounds");
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferSubData(id_, offset, size, data);
+    return;
+  }
+#endif
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id_);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ShaderStorageBuffer::read(const GLintptr offset, const GLsizeiptr size, void* data) const
+{
+  if (offset < 0 || offset + size > size_) throw Exception("Buffer range out of bounds");
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glGetNamedBufferSubData(id_, offset, size, data);
+    return;
+  }
+#endif
+
+  glBindBuffer(GL_COPY_READ_BUFFER, id_);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+ShaderStorageBuffer::~ShaderStorageBuffer()
+{
+  destroy();
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void ShaderStorageBuffer::destroy()
+{
+  if (id_ != 0)
+  {
+    MemoryTracker::get().resize(MemoryTracker::Category::StorageBuffers, size_, 0);
+    HandlePool::buffers().release(id_);
+    id_ = 0;
+    size_ = 0;
+  }
+}
+} // end of namespace BarelyGL
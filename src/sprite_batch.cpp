@@ -0,0 +1,258 @@
+//
+// sprite_batch.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <OpenGL/gl3.h>
+#include "sprite_batch.h"
+#include "texture.h"
+#include "texture_units.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+  #include <xmmintrin.h>
+  #define BGL_SPRITE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define BGL_SPRITE_NEON
+#endif
+
+namespace BarelyGL {
+namespace {
+/// The number of floats in each vertex (x, y, u, v, r, g, b, a)
+const size_t kVertexSize = 8;
+/// The number of floats in each sprite
+const size_t kSpriteSize = kVertexSize * 4;
+} // end of anonymous namespace
+
+SpriteBatch::SpriteBatch(const size_t max_sprites)
+  : max_sprites_(max_sprites > 0 ? max_sprites : 1)
+  , attributes_({VertexAttribute {2}, VertexAttribute {2}, VertexAttribute {4}})
+  , vertex_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW)
+  , index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW)
+{
+  // Every quad is drawn as two triangles: 0, 1, 2 and 2, 3, 0
+  std::vector<int> indices(max_sprites_ * 6);
+
+  for (size_t i = 0; i < max_sprites_; ++i)
+  {
+    int first = static_cast<int>(i * 4);
+
+    indices[i * 6 + 0] = first + 0;
+    indices[i * 6 + 1] = first + 1;
+    indices[i * 6 + 2] = first + 2;
+    indices[i * 6 + 3] = first + 2;
+    indices[i * 6 + 4] = first + 3;
+    indices[i * 6 + 5] = first + 0;
+  }
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.init_buffer(max_sprites_ * kSpriteSize);
+  attributes_.enable();
+  index_buffer_.bind();
+  index_buffer_.set_indices(indices);
+  array_.unbind();
+  vertex_buffer_.unbind();
+
+  sprites_.reserve(max_sprites_);
+  vertices_.reserve(max_sprites_ * kSpriteSize);
+}
+
+void SpriteBatch::begin(const SortMode sort_mode)
+{
+  sort_mode_ = sort_mode;
+  draw_calls_ = 0;
+  sprites_.clear();
+  ++generation_;
+}
+
+void SpriteBatch::draw(const Texture* texture, const Sprite& sprite)
+{
+  sprites_.push_back(Entry {texture, sprite});
+}
+
+void SpriteBatch::flush()
+{
+  ++generation_;
+
+  if (sprites_.empty()) return;
+
+  if (sort_mode_ == SortMode::Texture)
+  {
+    std::stable_sort(sprites_.begin(), sprites_.end(), [](const Entry& a, const Entry& b) {
+      return std::less<const Texture*>()(a.texture, b.texture);
+    });
+  }
+
+  for (size_t first = 0; first < sprites_.size(); first += max_sprites_)
+  {
+    draw_range(first, std::min(sprites_.size(), first + max_sprites_));
+  }
+
+  sprites_.clear();
+}
+
+void SpriteBatch::end()
+{
+  flush();
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * Expands all of the sprites into the staging array and uploads them in one
+ * go (orphaning the old store first, so the driver doesn't have to wait for
+ * the previous flush to finish drawing), then issues one draw per run of
+ * sprites sharing a texture
+ */
+void SpriteBatch::draw_range(const size_t first, const size_t last)
+{
+  size_t count = last - first;
+
+  vertices_.resize(count * kSpriteSize);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    expand(sprites_[first + i].sprite, &vertices_[i * kSpriteSize]);
+  }
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.init_buffer(max_sprites_ * kSpriteSize);
+  vertex_buffer_.sub_vertices(vertices_);
+
+  size_t run_start = 0;
+
+  while (run_start < count)
+  {
+    const Texture* texture = sprites_[first + run_start].texture;
+    size_t run_end = run_start + 1;
+
+    while (run_end < count && sprites_[first + run_end].texture == texture) ++run_end;
+
+    if (texture != nullptr) TextureUnits::get().bind(0, texture);
+
+    uintptr_t byte_offset = run_start * 6 * sizeof(int);
+    GLsizei index_count = static_cast<GLsizei>((run_end - run_start) * 6);
+
+    glDrawElements(GL_TRIANGLES,      // drawing mode
+                   index_count,       // number of indices to draw
+                   GL_UNSIGNED_INT,   // type of the indices
+                   (void*)byte_offset // offset to the first index
+                  );
+
+    ++draw_calls_;
+    run_start = run_end;
+  }
+
+  vertex_buffer_.unbind();
+  array_.unbind();
+}
+
+/*
+ * The corners, relative to the origin, go anticlockwise from the bottom left:
+ *    x = left, right, right, left
+ *    y = bottom, bottom, top, top
+ * and are rotated with x' = x cos - y sin, y' = x sin + y cos. With SIMD all
+ * four corners are transformed at once and then interleaved with their UVs
+ * into (x, y, u, v) quads, followed by the color shared by every corner
+ */
+void SpriteBatch::expand(const Sprite& sprite, float* vertices)
+{
+  float left = -sprite.origin_x * sprite.width;
+  float right = left + sprite.width;
+  float bottom = -sprite.origin_y * sprite.height;
+  float top = bottom + sprite.height;
+
+  float c = 1.0f;
+  float s = 0.0f;
+
+  if (sprite.rotation != 0.0f)
+  {
+    c = std::cos(sprite.rotation);
+    s = std::sin(sprite.rotation);
+  }
+
+#if defined(BGL_SPRITE_SSE)
+  __m128 local_x = _mm_setr_ps(left, right, right, left);
+  __m128 local_y = _mm_setr_ps(bottom, bottom, top, top);
+  __m128 cos_r = _mm_set1_ps(c);
+  __m128 sin_r = _mm_set1_ps(s);
+
+  __m128 x = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(local_x, cos_r), _mm_mul_ps(local_y, sin_r)),
+                        _mm_set1_ps(sprite.x));
+  __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(local_x, sin_r), _mm_mul_ps(local_y, cos_r)),
+                        _mm_set1_ps(sprite.y));
+  __m128 u = _mm_setr_ps(sprite.u0, sprite.u1, sprite.u1, sprite.u0);
+  __m128 v = _mm_setr_ps(sprite.v0, sprite.v0, sprite.v1, sprite.v1);
+  __m128 color = _mm_setr_ps(sprite.r, sprite.g, sprite.b, sprite.a);
+
+  __m128 xy_01 = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+  __m128 xy_23 = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+  __m128 uv_01 = _mm_unpacklo_ps(u, v); // u0 v0 u1 v1
+  __m128 uv_23 = _mm_unpackhi_ps(u, v); // u2 v2 u3 v3
+
+  _mm_storeu_ps(vertices + 0, _mm_movelh_ps(xy_01, uv_01));
+  _mm_storeu_ps(vertices + 4, color);
+  _mm_storeu_ps(vertices + 8, _mm_movehl_ps(uv_01, xy_01));
+  _mm_storeu_ps(vertices + 12, color);
+  _mm_storeu_ps(vertices + 16, _mm_movelh_ps(xy_23, uv_23));
+  _mm_storeu_ps(vertices + 20, color);
+  _mm_storeu_ps(vertices + 24, _mm_movehl_ps(uv_23, xy_23));
+  _mm_storeu_ps(vertices + 28, color);
+#elif defined(BGL_SPRITE_NEON)
+  const float corners_x[4] = {left, right, right, left};
+  const float corners_y[4] = {bottom, bottom, top, top};
+  const float corners_u[4] = {sprite.u0, sprite.u1, sprite.u1, sprite.u0};
+  const float corners_v[4] = {sprite.v0, sprite.v0, sprite.v1, sprite.v1};
+  const float tint[4] = {sprite.r, sprite.g, sprite.b, sprite.a};
+
+  float32x4_t local_x = vld1q_f32(corners_x);
+  float32x4_t local_y = vld1q_f32(corners_y);
+
+  float32x4_t x = vaddq_f32(vmlsq_n_f32(vmulq_n_f32(local_x, c), local_y, s),
+                            vdupq_n_f32(sprite.x));
+  float32x4_t y = vaddq_f32(vmlaq_n_f32(vmulq_n_f32(local_x, s), local_y, c),
+                            vdupq_n_f32(sprite.y));
+  float32x4_t color = vld1q_f32(tint);
+
+  float32x4x2_t xy = vzipq_f32(x, y);
+  float32x4x2_t uv = vzipq_f32(vld1q_f32(corners_u), vld1q_f32(corners_v));
+
+  vst1q_f32(vertices + 0, vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(uv.val[0])));
+  vst1q_f32(vertices + 4, color);
+  vst1q_f32(vertices + 8, vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(uv.val[0])));
+  vst1q_f32(vertices + 12, color);
+  vst1q_f32(vertices + 16, vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(uv.val[1])));
+  vst1q_f32(vertices + 20, color);
+  vst1q_f32(vertices + 24, vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(uv.val[1])));
+  vst1q_f32(vertices + 28, color);
+#else
+  const float corners_x[4] = {left, right, right, left};
+  const float corners_y[4] = {bottom, bottom, top, top};
+  const float corners_u[4] = {sprite.u0, sprite.u1, sprite.u1, sprite.u0};
+  const float corners_v[4] = {sprite.v0, sprite.v0, sprite.v1, sprite.v1};
+
+  for (int i = 0; i < 4; ++i)
+  {
+    float* vertex = vertices + i * kVertexSize;
+
+    vertex[0] = corners_x[i] * c - corners_y[i] * s + sprite.x;
+    vertex[1] = corners_x[i] * s + corners_y[i] * c + sprite.y;
+    vertex[2] = corners_u[i];
+    vertex[3] = corners_v[i];
+    vertex[4] = sprite.r;
+    vertex[5] = sprite.g;
+    vertex[6] = sprite.b;
+    vertex[7] = sprite.a;
+  }
+#endif
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,512 @@
+//
+// static_batcher.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "static_batcher.h"
+#include "shader_program.h"
+#include "texture_units.h"
+#include "exception.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define BGL_BATCH_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define BGL_BATCH_NEON
+#endif
+
+namespace BarelyGL {
+namespace {
+/// Builds with fewer vertices than this are transformed on the calling thread
+const size_t kParallelThreshold = 65536;
+
+/*
+ * Spreads the low 10 bits of a value out so there are two zero bits between
+ * each, ready to be interleaved with two other axes
+ */
+uint32_t part_by_2(uint32_t value)
+{
+  value &= 0x3FF;
+  value = (value | (value << 16)) & 0x030000FF;
+  value = (value | (value << 8)) & 0x0300F00F;
+  value = (value | (value << 4)) & 0x030C30C3;
+  value = (value | (value << 2)) & 0x09249249;
+
+  return value;
+}
+
+void normalize3(float* normal)
+{
+  float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+  if (length > 0.0f)
+  {
+    float scale = 1.0f / length;
+    normal[0] *= scale;
+    normal[1] *= scale;
+    normal[2] *= scale;
+  }
+}
+
+/*
+ * Copies `count` vertices while transforming the position (at offset 0) by
+ * the model matrix and the normal (if any) by the normal matrix, tracking the
+ * bounds of the transformed positions. Vertices are interleaved, so each is
+ * transformed as one 4-wide column sum:
+ *    p' = c0 * x + c1 * y + c2 * z + c3
+ * Both matrices are column major with 4 floats per column (the normal matrix
+ * has 3 columns with w = 0), and only 3 values are written back so the next
+ * attribute is left alone
+ */
+void transform_vertices(const float* source, float* dest, const size_t count, const size_t stride,
+                        const float* model, const float* normal, const int normal_offset,
+                        float* min, float* max)
+{
+  std::memcpy(dest, source, count * stride * sizeof(float));
+
+#if defined(BGL_BATCH_SSE)
+  const __m128 c0 = _mm_loadu_ps(model), c1 = _mm_loadu_ps(model + 4);
+  const __m128 c2 = _mm_loadu_ps(model + 8), c3 = _mm_loadu_ps(model + 12);
+  const __m128 n0 = _mm_loadu_ps(normal), n1 = _mm_loadu_ps(normal + 4);
+  const __m128 n2 = _mm_loadu_ps(normal + 8);
+  __m128 lo = _mm_set1_ps(FLT_MAX), hi = _mm_set1_ps(-FLT_MAX);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const float* in = source + i * stride;
+    float* out = dest + i * stride;
+
+    __m128 p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in[0])),
+                                     _mm_mul_ps(c1, _mm_set1_ps(in[1]))),
+                          _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(in[2])), c3));
+    lo = _mm_min_ps(lo, p);
+    hi = _mm_max_ps(hi, p);
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), p);
+    _mm_store_ss(out + 2, _mm_movehl_ps(p, p));
+
+    if (normal_offset < 0) continue;
+
+    in += normal_offset;
+    out += normal_offset;
+
+    __m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n0, _mm_set1_ps(in[0])),
+                                     _mm_mul_ps(n1, _mm_set1_ps(in[1]))),
+                          _mm_mul_ps(n2, _mm_set1_ps(in[2])));
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), n);
+    _mm_store_ss(out + 2, _mm_movehl_ps(n, n));
+    normalize3(out);
+  }
+
+  float bounds[4];
+  _mm_storeu_ps(bounds, lo);
+  std::memcpy(min, bounds, 3 * sizeof(float));
+  _mm_storeu_ps(bounds, hi);
+  std::memcpy(max, bounds, 3 * sizeof(float));
+#elif defined(BGL_BATCH_NEON)
+  const float32x4_t c0 = vld1q_f32(model), c1 = vld1q_f32(model + 4);
+  const float32x4_t c2 = vld1q_f32(model + 8), c3 = vld1q_f32(model + 12);
+  const float32x4_t n0 = vld1q_f32(normal), n1 = vld1q_f32(normal + 4);
+  const float32x4_t n2 = vld1q_f32(normal + 8);
+  float32x4_t lo = vdupq_n_f32(FLT_MAX), hi = vdupq_n_f32(-FLT_MAX);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const float* in = source + i * stride;
+    float* out = dest + i * stride;
+
+    float32x4_t p = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(c3, c0, in[0]), c1, in[1]), c2, in[2]);
+    lo = vminq_f32(lo, p);
+    hi = vmaxq_f32(hi, p);
+    vst1_f32(out, vget_low_f32(p));
+    vst1q_lane_f32(out + 2, p, 2);
+
+    if (normal_offset < 0) continue;
+
+    in += normal_offset;
+    out += normal_offset;
+
+    float32x4_t n = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(n0, in[0]), n1, in[1]), n2, in[2]);
+    vst1_f32(out, vget_low_f32(n));
+    vst1q_lane_f32(out + 2, n, 2);
+    normalize3(out);
+  }
+
+  float bounds[4];
+  vst1q_f32(bounds, lo);
+  std::memcpy(min, bounds, 3 * sizeof(float));
+  vst1q_f32(bounds, hi);
+  std::memcpy(max, bounds, 3 * sizeof(float));
+#else
+  for (int k = 0; k < 3; ++k)
+  {
+    min[k] = FLT_MAX;
+    max[k] = -FLT_MAX;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const float* in = source + i * stride;
+    float* out = dest + i * stride;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      out[k] = model[k] * in[0] + model[4 + k] * in[1] + model[8 + k] * in[2] + model[12 + k];
+      min[k] = std::min(min[k], out[k]);
+      max[k] = std::max(max[k], out[k]);
+    }
+
+    if (normal_offset < 0) continue;
+
+    in += normal_offset;
+    out += normal_offset;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      out[k] = normal[k] * in[0] + normal[4 + k] * in[1] + normal[8 + k] * in[2];
+    }
+
+    normalize3(out);
+  }
+#endif
+}
+} // end of anonymous namespace
+
+StaticBatcher::StaticBatcher(const VertexAttributeArray& attributes, const int normal_attribute,
+                             const size_t chunk_indices, const size_t thread_count)
+  : attributes_(attributes)
+  , normal_offset_(-1)
+  , chunk_indices_(std::max<size_t>(chunk_indices, 1))
+  , thread_count_(thread_count)
+  , culler_(thread_count)
+  , vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW)
+  , index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW)
+{
+  const std::vector<VertexAttribute>& list = attributes_.attributes();
+
+  if (list.empty() || list[0].size != 3) throw Exception("Static batches need a 3 value position");
+
+  if (normal_attribute >= 0)
+  {
+    if (normal_attribute == 0 || static_cast<size_t>(normal_attribute) >= list.size() ||
+        list[normal_attribute].size != 3)
+    {
+      throw Exception("Static batch normals must be a 3 value attribute after the position");
+    }
+
+    normal_offset_ = 0;
+
+    for (int i = 0; i < normal_attribute; ++i) normal_offset_ += list[i].size;
+  }
+
+  if (thread_count_ == 0) thread_count_ = std::thread::hardware_concurrency();
+  if (thread_count_ == 0) thread_count_ = 1;
+}
+
+void StaticBatcher::add(const ShaderProgram* program, const std::vector<const Texture*>& textures,
+                        const std::vector<float>& vertices, const std::vector<int>& indices,
+                        const glm::mat4& model)
+{
+  const size_t stride = attributes_.size();
+  const size_t vertex_count = vertices.size() / stride;
+
+  if (vertex_count == 0 || indices.empty()) throw Exception("Cannot batch an empty mesh");
+  if (vertices.size() % stride != 0) throw Exception("Mesh has a partial vertex");
+
+  for (int index : indices)
+  {
+    if (index < 0 || static_cast<size_t>(index) >= vertex_count)
+    {
+      throw Exception("Mesh index is out of range");
+    }
+  }
+
+  auto batch = std::find_if(batches_.begin(), batches_.end(), [&](const Batch& b) {
+    return b.program == program && b.textures == textures;
+  });
+
+  if (batch == batches_.end())
+  {
+    batches_.push_back(Batch {program, textures, {}, 0, 0});
+    batch = batches_.end() - 1;
+  }
+
+  batch->meshes.push_back(meshes_.size());
+
+  Mesh mesh = {};
+  mesh.vertices = vertices;
+  mesh.indices = indices;
+  std::memcpy(mesh.model, glm::value_ptr(model), sizeof(mesh.model));
+  mesh.first_vertex = 0;
+  mesh.first_index = 0;
+  meshes_.push_back(std::move(mesh));
+}
+
+/*
+ * Building happens in three passes:
+ *    1. Each batch's meshes are sorted by the Morton code of their centers
+ *       (the model matrix applied to the center of the model space bounds),
+ *       so neighbouring meshes end up in the same chunk, and given their
+ *       place in the shared buffers
+ *    2. The meshes are transformed into the staging buffers, split across
+ *       threads for large builds; each writes to its own ranges
+ *    3. The sorted meshes are cut into chunks and their bounds (the exact
+ *       world space bounds from pass 2) are handed to the culler
+ * Fresh buffers are made each time since the storage may be immutable
+ */
+void StaticBatcher::build()
+{
+  const size_t stride = attributes_.size();
+
+  batches_.erase(std::remove_if(batches_.begin(), batches_.end(), [](const Batch& batch) {
+    return batch.meshes.empty();
+  }), batches_.end());
+
+  std::vector<size_t> order;
+  size_t vertex_count = 0;
+  size_t index_count = 0;
+
+  for (auto& batch : batches_)
+  {
+    std::vector<glm::vec3> centers;
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+
+    for (size_t m : batch.meshes)
+    {
+      const Mesh& mesh = meshes_[m];
+      glm::vec3 local_min(FLT_MAX), local_max(-FLT_MAX);
+
+      for (size_t v = 0; v < mesh.vertices.size(); v += stride)
+      {
+        glm::vec3 position(mesh.vertices[v], mesh.vertices[v + 1], mesh.vertices[v + 2]);
+        local_min = glm::min(local_min, position);
+        local_max = glm::max(local_max, position);
+      }
+
+      glm::vec3 center(glm::make_mat4(mesh.model) * glm::vec4((local_min + local_max) * 0.5f, 1.0f));
+      centers.push_back(center);
+      low = glm::min(low, center);
+      high = glm::max(high, center);
+    }
+
+    glm::vec3 scale = 1023.0f / glm::max(high - low, glm::vec3(FLT_MIN));
+    std::vector<std::pair<uint32_t, size_t>> codes;
+
+    for (size_t i = 0; i < batch.meshes.size(); ++i)
+    {
+      glm::vec3 cell = (centers[i] - low) * scale;
+      uint32_t code = part_by_2(static_cast<uint32_t>(cell.x)) |
+                      (part_by_2(static_cast<uint32_t>(cell.y)) << 1) |
+                      (part_by_2(static_cast<uint32_t>(cell.z)) << 2);
+      codes.push_back(std::make_pair(code, batch.meshes[i]));
+    }
+
+    std::stable_sort(codes.begin(), codes.end(), [](const std::pair<uint32_t, size_t>& a,
+                                                    const std::pair<uint32_t, size_t>& b) {
+      return a.first < b.first;
+    });
+
+    for (size_t i = 0; i < codes.size(); ++i)
+    {
+      Mesh& mesh = meshes_[codes[i].second];
+      batch.meshes[i] = codes[i].second;
+      mesh.first_vertex = vertex_count;
+      mesh.first_index = index_count;
+      vertex_count += mesh.vertices.size() / stride;
+      index_count += mesh.indices.size();
+      order.push_back(codes[i].second);
+    }
+  }
+
+  chunks_.clear();
+  culler_.clear();
+
+  if (order.empty()) return;
+
+  if (vertex_count > static_cast<size_t>(INT_MAX))
+  {
+    throw Exception("Too many vertices to merge into one static batch");
+  }
+
+  std::vector<float> vertices(vertex_count * stride);
+  std::vector<int> indices(index_count);
+  size_t threads = vertex_count >= kParallelThreshold ? std::min(thread_count_, order.size()) : 1;
+
+  if (threads <= 1)
+  {
+    transform_range(order, 0, order.size(), vertices, indices);
+  }
+  else
+  {
+    size_t per_thread = (order.size() + threads - 1) / threads;
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+      size_t first = std::min(order.size(), t * per_thread);
+      size_t last = std::min(order.size(), first + per_thread);
+
+      workers.emplace_back(&StaticBatcher::transform_range, this, std::cref(order), first, last,
+                           std::ref(vertices), std::ref(indices));
+    }
+
+    for (auto& worker : workers) worker.join();
+  }
+
+  for (auto& batch : batches_)
+  {
+    glm::vec3 low, high;
+    batch.first_chunk = chunks_.size();
+
+    for (size_t i = 0; i < batch.meshes.size(); ++i)
+    {
+      const Mesh& mesh = meshes_[batch.meshes[i]];
+
+      if (i > 0 && chunks_.back().index_count + mesh.indices.size() <= chunk_indices_)
+      {
+        low = glm::min(low, glm::make_vec3(mesh.min));
+        high = glm::max(high, glm::make_vec3(mesh.max));
+      }
+      else
+      {
+        if (i > 0) culler_.add(low, high);
+
+        chunks_.push_back(Chunk {mesh.first_index, 0});
+        low = glm::make_vec3(mesh.min);
+        high = glm::make_vec3(mesh.max);
+      }
+
+      chunks_.back().index_count += mesh.indices.size();
+    }
+
+    culler_.add(low, high);
+    batch.chunk_count = chunks_.size() - batch.first_chunk;
+    batch.meshes.clear();
+  }
+
+  meshes_.clear();
+
+  vertex_buffer_ = VertexBufferObject(GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+  index_buffer_ = IndexBufferObject(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+  array_ = VertexArrayObject();
+
+  array_.bind();
+  vertex_buffer_.bind();
+  vertex_buffer_.set_storage(vertices);
+  index_buffer_.bind();
+  index_buffer_.set_storage(indices);
+  array_.unbind();
+  vertex_buffer_.unbind();
+
+  array_.attach(attributes_, vertex_buffer_, &index_buffer_);
+}
+
+/*
+ * The culler returns visible chunks in order, and chunks are grouped by
+ * batch, so one pass hands each batch its visible chunks. Visible chunks that
+ * follow on from each other in the index buffer are merged into one range
+ */
+void StaticBatcher::draw(const glm::mat4& view_projection)
+{
+  draw_calls_ = 0;
+
+  if (chunks_.empty()) return;
+
+  culler_.cull(view_projection, visible_);
+
+  if (visible_.empty()) return;
+
+  size_t next = 0;
+
+  array_.bind();
+
+  for (auto& batch : batches_)
+  {
+    const size_t end_chunk = batch.first_chunk + batch.chunk_count;
+    size_t run_end = 0;
+
+    counts_.clear();
+    offsets_.clear();
+
+    for (; next < visible_.size() && visible_[next] < end_chunk; ++next)
+    {
+      const Chunk& chunk = chunks_[visible_[next]];
+
+      if (!counts_.empty() && run_end == chunk.first_index)
+      {
+        counts_.back() += static_cast<GLsizei>(chunk.index_count);
+      }
+      else
+      {
+        counts_.push_back(static_cast<GLsizei>(chunk.index_count));
+        offsets_.push_back(reinterpret_cast<const void*>(chunk.first_index * sizeof(GLuint)));
+      }
+
+      run_end = chunk.first_index + chunk.index_count;
+    }
+
+    if (counts_.empty()) continue;
+
+    batch.program->use();
+
+    if (!batch.textures.empty()) TextureUnits::get().bind(batch.textures);
+
+    glMultiDrawElements(GL_TRIANGLES, counts_.data(), GL_UNSIGNED_INT, offsets_.data(),
+                        static_cast<GLsizei>(counts_.size()));
+    ++draw_calls_;
+  }
+
+  array_.unbind();
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+/*
+ * Normals are transformed by the inverse transpose of the model matrix's
+ * upper 3x3, so they stay perpendicular under non-uniform scale. A singular
+ * matrix (a mesh flattened to a plane) falls back to the 3x3 itself
+ */
+void StaticBatcher::transform_range(const std::vector<size_t>& order, const size_t first,
+                                    const size_t last, std::vector<float>& vertices,
+                                    std::vector<int>& indices)
+{
+  const size_t stride = attributes_.size();
+
+  for (size_t i = first; i < last; ++i)
+  {
+    Mesh& mesh = meshes_[order[i]];
+    glm::mat3 upper(glm::make_mat4(mesh.model));
+
+    if (std::fabs(glm::determinant(upper)) > FLT_MIN) upper = glm::transpose(glm::inverse(upper));
+
+    float normal[12] = {
+      upper[0][0], upper[0][1], upper[0][2], 0.0f,
+      upper[1][0], upper[1][1], upper[1][2], 0.0f,
+      upper[2][0], upper[2][1], upper[2][2], 0.0f
+    };
+
+    transform_vertices(mesh.vertices.data(), vertices.data() + mesh.first_vertex * stride,
+                       mesh.vertices.size() / stride, stride, mesh.model, normal, normal_offset_,
+                       mesh.min, mesh.max);
+
+    const int base = static_cast<int>(mesh.first_vertex);
+    int* out = indices.data() + mesh.first_index;
+
+    for (size_t k = 0; k < mesh.indices.size(); ++k) out[k] = mesh.indices[k] + base;
+  }
+}
+} // end of namespace BarelyGL
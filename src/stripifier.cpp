@@ -0,0 +1,183 @@
+//
+// stripifier.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include "stripifier.h"
+
+namespace BarelyGL {
+namespace {
+/// The stamp of a triangle that is already in a strip
+const uint32_t kDone = UINT32_MAX;
+
+/// The triangle on the left of each directed edge
+typedef std::unordered_map<uint64_t, size_t> EdgeMap;
+
+uint64_t edge_key(const int from, const int to)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(from)) << 32) | static_cast<uint32_t>(to);
+}
+
+/*
+ * Finds the vertex of a triangle opposite the directed edge from -> to
+ */
+int opposite(const int* triangle, const int from, const int to)
+{
+  for (int k = 0; k < 3; ++k)
+  {
+    if (triangle[k] == from && triangle[(k + 1) % 3] == to) return triangle[(k + 2) % 3];
+  }
+
+  return triangle[0];
+}
+
+/*
+ * Grows a strip from a triangle, starting with the vertex `rotation`.
+ * Triangle k of a strip is (s[k], s[k+1], s[k+2]) when k is even and
+ * (s[k+1], s[k], s[k+2]) when odd, so the next triangle has to be on the
+ * left of the last edge walked forwards or backwards in turn. Triangles
+ * used are stamped with `stamp`, so trial runs don't need to be undone
+ */
+size_t grow(const std::vector<int>& indices, const EdgeMap& edges, std::vector<uint32_t>& stamps,
+            const uint32_t stamp, const size_t triangle, const int rotation,
+            std::vector<int>* strip)
+{
+  const int* first = &indices[triangle * 3];
+  int previous = first[(rotation + 1) % 3];
+  int last = first[(rotation + 2) % 3];
+
+  stamps[triangle] = stamp;
+
+  if (strip != nullptr) strip->insert(strip->end(), {first[rotation], previous, last});
+
+  size_t count = 1;
+
+  for (;;)
+  {
+    const bool even = count % 2 == 0;
+    auto found = edges.find(even ? edge_key(previous, last) : edge_key(last, previous));
+
+    if (found == edges.end()) break;
+
+    const size_t next = found->second;
+
+    if (stamps[next] == kDone || stamps[next] == stamp) break;
+
+    int vertex = even ? opposite(&indices[next * 3], previous, last)
+                      : opposite(&indices[next * 3], last, previous);
+
+    stamps[next] = stamp;
+
+    if (strip != nullptr) strip->push_back(vertex);
+
+    previous = last;
+    last = vertex;
+    ++count;
+  }
+
+  return count;
+}
+} // end of anonymous namespace
+
+const int Stripifier::restart_index;
+
+/*
+ * Each strip is tried from all three rotations of its first triangle, since
+ * which edge it leaves by decides which way it runs
+ */
+std::vector<int> Stripifier::stripify(const std::vector<int>& indices) const
+{
+  const size_t triangle_count = indices.size() / 3;
+  std::vector<uint32_t> stamps(triangle_count, 0);
+  EdgeMap edges;
+  edges.reserve(indices.size());
+
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    const int* triangle = &indices[t * 3];
+
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+    {
+      stamps[t] = kDone;
+      continue;
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+      edges.emplace(edge_key(triangle[k], triangle[(k + 1) % 3]), t);
+    }
+  }
+
+  // Start with the triangles with the fewest neighbours, e.g. the corners of a grid
+  std::vector<int> neighbours(triangle_count, 0);
+  std::vector<size_t> order(triangle_count);
+
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    const int* triangle = &indices[t * 3];
+    order[t] = t;
+
+    for (int k = 0; k < 3; ++k)
+    {
+      neighbours[t] += edges.count(edge_key(triangle[(k + 1) % 3], triangle[k])) > 0 ? 1 : 0;
+    }
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&neighbours](size_t a, size_t b) {
+    return neighbours[a] < neighbours[b];
+  });
+
+  std::vector<int> strips;
+  strips.reserve(indices.size() / 2);
+  uint32_t trial = 0;
+
+  for (size_t t : order)
+  {
+    if (stamps[t] == kDone) continue;
+
+    int best_rotation = 0;
+    size_t best_length = 0;
+
+    for (int rotation = 0; rotation < 3; ++rotation)
+    {
+      size_t length = grow(indices, edges, stamps, ++trial, t, rotation, nullptr);
+
+      if (length > best_length)
+      {
+        best_length = length;
+        best_rotation = rotation;
+      }
+    }
+
+    if (!strips.empty()) strips.push_back(restart_index);
+
+    grow(indices, edges, stamps, kDone, t, best_rotation, &strips);
+  }
+
+  return strips;
+}
+
+size_t Stripifier::triangle_count(const std::vector<int>& strips)
+{
+  size_t count = 0;
+  size_t run = 0;
+
+  for (size_t i = 0; i <= strips.size(); ++i)
+  {
+    if (i == strips.size() || strips[i] == restart_index)
+    {
+      count += run > 2 ? run - 2 : 0;
+      run = 0;
+    }
+    else
+    {
+      ++run;
+    }
+  }
+
+  return count;
+}
+} // end of namespace BarelyGL
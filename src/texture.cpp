@@ -5,64 +5,300 @@
 
 #include <OpenGL/gl3.h>
 #include "texture.h"
+#include "handle_pool.h"
+#include "capabilities.h"
+#include "memory_tracker.h"
+#include "mipmap_generator.h"
+#include "pixel_converter.h"
+#include "texture_units.h"
 #include "exception.h"
+#include <algorithm>
 #include <iostream>
 
 namespace BarelyGL {
+namespace {
+/*
+ * Immutable storage needs a sized internal format, so textures asking for
+ * an unsized one stay on the mutable path
+ */
+bool is_sized(const GLenum internal_format)
+{
+  switch (internal_format)
+  {
+    case GL_RED: case GL_RG: case GL_RGB: case GL_RGBA:
+    case GL_DEPTH_COMPONENT: case GL_DEPTH_STENCIL:
+      return false;
+    default:
+      return true;
+  }
+}
+} // end of anonymous namespace
+
 Texture::Texture(const int width, const int height, const GLenum format,
                  const GLenum internal_format, const uint8_t unpack_alignment, const void* pixels)
-  : width_(width)
+  : Texture(GL_TEXTURE_2D, width, height, 1, format, GL_UNSIGNED_BYTE, internal_format,
+            unpack_alignment, pixels) {};
+
+// Construct from pixels run through a converter, uploaded as whatever type it outputs
+Texture::Texture(const int width, const int height, const GLenum internal_format,
+                 const PixelConverter& converter, const uint8_t* pixels)
+  : Texture(GL_TEXTURE_2D, width, height, 1, converter.format(), converter.type(),
+            internal_format, 4,
+            pixels != nullptr
+              ? convert(converter, pixels, static_cast<size_t>(width) * height).data()
+              : nullptr) {};
+
+// Construct and default to an unpack alignment of 4 bytes, which is the most usual
+Texture::Texture(int width, int height, GLenum format, GLenum internal_format, const void* pixels)
+  : Texture(width, height, format, internal_format, 4, pixels) {};
+
+// Construct and default to an internal format of GL_RGBA8
+Texture::Texture(int width, int height, GLenum format, const void* pixels)
+  : Texture(width, height, format, GL_RGBA8, pixels) {};
+
+// Construct an array or 3D texture, defaulting to an unpack alignment of 4 bytes
+Texture::Texture(const GLenum target, const int width, const int height, const int depth,
+                 const GLenum format, const GLenum internal_format, const void* pixels)
+  : Texture(target, width, height, depth, format, GL_UNSIGNED_BYTE, internal_format, 4, pixels)
+{
+}
+
+/*
+ * Levels are tightly packed (as `MipmapGenerator` produces them), so the
+ * unpack alignment is 1. Empty levels are allocated but not uploaded, for
+ * textures whose levels are filled by `generate_mipmaps()`
+ */
+Texture::Texture(const int width, const int height, const GLenum format,
+                 const GLenum internal_format, const void* pixels,
+                 const std::vector<std::vector<uint8_t>>& mipmaps)
+  : target_(GL_TEXTURE_2D)
+  , width_(width)
   , height_(height)
   , format_(format)
-  , unpack_alignment_(unpack_alignment)
+  , internal_format_(internal_format)
+  , type_(GL_UNSIGNED_BYTE)
+  , unpack_alignment_(1)
+  , levels_(1 + static_cast<int>(mipmaps.size()))
 {
+  if (levels_ > MipmapGenerator::level_count(width, height))
+  {
+    throw Exception("Texture has more mipmap levels than its size allows");
+  }
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access() && is_sized(internal_format))
+  {
+    create_storage(internal_format, pixels);
+
+    for (int level = 1; level < levels_; ++level)
+    {
+      if (mipmaps[level - 1].empty()) continue;
+
+      glTextureSubImage2D(id_, level, 0, 0, std::max(1, width_ >> level),
+                          std::max(1, height_ >> level), format_, type_,
+                          mipmaps[level - 1].data());
+    }
+
+    return;
+  }
+#endif
+
   generate();
   bind();
   set_data(internal_format, pixels);
+
+  for (int level = 1; level < levels_; ++level)
+  {
+    const std::vector<uint8_t>& data = mipmaps[level - 1];
+
+    glTexImage2D(target_, level, internal_format, std::max(1, width_ >> level),
+                 std::max(1, height_ >> level), 0, format_, type_,
+                 data.empty() ? nullptr : data.data());
+  }
+
   set_parameters();
   unbind();
+  TextureUnits::get().invalidate_active();
 }
 
-// Construct and default to an unpack alignment of 4 bytes, which is the most usual
-Texture::Texture(int width, int height, GLenum format, GLenum internal_format, const void* pixels)
-  : Texture(width, height, format, internal_format, 4, pixels) {};
+Texture::Texture(Texture&& other) noexcept
+  : id_(other.id_)
+  , target_(other.target_)
+  , width_(other.width_)
+  , height_(other.height_)
+  , depth_(other.depth_)
+  , format_(other.format_)
+  , internal_format_(other.internal_format_)
+  , type_(other.type_)
+  , unpack_alignment_(other.unpack_alignment_)
+  , levels_(other.levels_)
+  , immutable_(other.immutable_)
+  , byte_size_(other.byte_size_)
+{
+  other.id_ = 0;
+  other.byte_size_ = 0;
+}
 
-// Construct and default to an internal format of GL_RGBA8
-Texture::Texture(int width, int height, GLenum format, const void* pixels)
-  : Texture(width, height, format, GL_RGBA8, pixels) {};
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    target_ = other.target_;
+    width_ = other.width_;
+    height_ = other.height_;
+    depth_ = other.depth_;
+    format_ = other.format_;
+    internal_format_ = other.internal_format_;
+    type_ = other.type_;
+    unpack_alignment_ = other.unpack_alignment_;
+    levels_ = other.levels_;
+    immutable_ = other.immutable_;
+    byte_size_ = other.byte_size_;
+
+    other.id_ = 0;
+    other.byte_size_ = 0;
+  }
+
+  return *this;
+}
 
 void Texture::bind() const
 {
-  glBindTexture(GL_TEXTURE_2D, id_);
+  glBindTexture(target_, id_);
+}
+
+void Texture::bind(const GLuint unit) const
+{
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(target_, id_);
 }
 
 void Texture::sub_data(const int x_offset, const int y_offset, const int width, const int height,
                        const void* data)
 {
+  if (target_ != GL_TEXTURE_2D)
+  {
+    sub_data(x_offset, y_offset, 0, width, height, 1, data);
+    return;
+  }
 
   glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_);
-  glTexSubImage2D(GL_TEXTURE_2D,    // target of the texture
+
+#if defined(GL_VERSION_4_5)
+  if (immutable_)
+  {
+    glTextureSubImage2D(id_, 0, x_offset, y_offset, width, height, format_, type_,
+                        data);
+    return;
+  }
+#endif
+
+  glTexSubImage2D(target_,          // target of the texture
                   0,                // mipmap level
                   x_offset,         // the x offset within the texture
                   y_offset,         // the y offset within the texture
                   width,            // width of texture
                   height,           // height of texture
                   format_,          // format of texture being uploaded
-                  GL_UNSIGNED_BYTE, // type of pixel data being uploaded
+                  type_,            // type of pixel data being uploaded
                   data              // pixel data
                  );
 }
 
+void Texture::sub_data(const int x_offset, const int y_offset, const int z_offset,
+                       const int width, const int height, const int depth, const void* data)
+{
+  if (target_ == GL_TEXTURE_2D)
+  {
+    if (z_offset != 0 || depth != 1) throw Exception("2D textures only have one layer");
+
+    sub_data(x_offset, y_offset, width, height, data);
+    return;
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_);
+
+#if defined(GL_VERSION_4_5)
+  if (immutable_)
+  {
+    glTextureSubImage3D(id_, 0, x_offset, y_offset, z_offset, width, height, depth, format_,
+                        type_, data);
+    return;
+  }
+#endif
+
+  glTexSubImage3D(target_, 0, x_offset, y_offset, z_offset, width, height, depth, format_, type_,
+                  data);
+}
+
+void Texture::set_layer(const int layer, const void* data)
+{
+  if (layer < 0 || layer >= depth_) throw Exception("Texture layer out of range");
+
+  sub_data(0, 0, layer, width_, height_, 1, data);
+}
+
+/*
+ * Mutable textures get every level allocated by `glGenerateMipmap`, so the
+ * texture is switched over to sampling them. `GL_TEXTURE_MAX_LEVEL` has to be
+ * raised first, since only the levels up to it are generated. Immutable
+ * textures can only fill the levels they were created with
+ */
+void Texture::generate_mipmaps()
+{
+#if defined(GL_VERSION_4_5)
+  if (immutable_)
+  {
+    glGenerateTextureMipmap(id_);
+    return;
+  }
+#endif
+
+  if (levels_ == 1)
+  {
+    // Array layers aren't filtered together, but the depth of a 3D texture is
+    int depth = target_ == GL_TEXTURE_3D ? depth_ : 1;
+    levels_ = MipmapGenerator::level_count(std::max(width_, depth), height_);
+    set_parameters();
+    account();
+  }
+
+  glGenerateMipmap(target_);
+}
+
 void Texture::unbind() const
 {
-  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindTexture(target_, 0);
+}
+
+void Texture::purge()
+{
+  destroy(false);
 }
 
-void Texture::destroy()
+void Texture::destroy(const bool recycle)
 {
   if (id_ != 0)
   {
-    glDeleteTextures(1, &id_);
+    if (immutable_ || !recycle)
+    {
+      // Deleting unbinds it everywhere, and the name may be handed straight back out
+      TextureUnits::get().invalidate(id_);
+      glDeleteTextures(1, &id_);
+    }
+    else
+    {
+      HandlePool::textures(target_).release(id_);
+    }
+
+    MemoryTracker::get().resize(MemoryTracker::Category::Textures, byte_size_, 0);
+
+    id_ = 0;
+    immutable_ = false;
+    byte_size_ = 0;
   }
 }
 
@@ -72,38 +308,172 @@ void Texture::destroy()
 // =============================
 //
 
-void Texture::generate()
+Texture::Texture(const GLenum target, const int width, const int height, const int depth,
+                 const GLenum format, const GLenum type, const GLenum internal_format,
+                 const uint8_t unpack_alignment, const void* pixels)
+  : target_(target)
+  , width_(width)
+  , height_(height)
+  , depth_(depth)
+  , format_(format)
+  , internal_format_(internal_format)
+  , type_(type)
+  , unpack_alignment_(unpack_alignment)
 {
-  glGenTextures(1, &id_);
+  if (target_ != GL_TEXTURE_2D && target_ != GL_TEXTURE_2D_ARRAY && target_ != GL_TEXTURE_3D)
+  {
+    throw Exception("Unsupported texture target");
+  }
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access() && is_sized(internal_format))
+  {
+    create_storage(internal_format, pixels);
+    return;
+  }
+#endif
 
-  if (id_ == 0) throw Exception("Could not generate texture");
+  generate();
+  bind();
+  set_data(internal_format, pixels);
+  set_parameters();
+  unbind();
+  TextureUnits::get().invalidate_active();
+}
+
+/*
+ * Converts into a temporary that lives until the delegated constructor has
+ * uploaded it
+ */
+std::vector<uint8_t> Texture::convert(const PixelConverter& converter, const uint8_t* pixels,
+                                      const size_t pixel_count)
+{
+  std::vector<uint8_t> converted(converter.output_size(pixel_count));
+  converter.convert(pixels, converted.data(), pixel_count);
+
+  return converted;
+}
+
+void Texture::generate()
+{
+  id_ = HandlePool::textures(target_).acquire();
 }
 
 void Texture::set_data(const GLenum internal_format, const void* data)
 {
+  account();
   glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_);
-  glTexImage2D(GL_TEXTURE_2D,    // target of the texture
+
+  if (target_ != GL_TEXTURE_2D)
+  {
+    glTexImage3D(target_, 0, internal_format, width_, height_, depth_, 0, format_, type_, data);
+    return;
+  }
+
+  glTexImage2D(target_,          // target of the texture
                0,                // mipmap level
                internal_format,  // internal color format
                width_,           // width of texture
                height_,          // height of texture
                0,                // border (must be 0)
                format_,          // format of texture being uploaded
-               GL_UNSIGNED_BYTE, // type of pixel data being uploaded
+               type_,            // type of pixel data being uploaded
                data              // pixel data
               );
 }
 
+#if defined(GL_VERSION_4_5)
+/*
+ * Creates the texture with immutable storage and uploads to it by name, so
+ * nothing is bound. Immutable textures can't go back to the handle pool, so
+ * they are created on their own
+ */
+void Texture::create_storage(const GLenum internal_format, const void* data)
+{
+  glCreateTextures(target_, 1, &id_);
+
+  if (id_ == 0) throw Exception("Could not create texture");
+
+  immutable_ = true;
+  account();
+
+  if (target_ == GL_TEXTURE_2D)
+  {
+    glTextureStorage2D(id_, levels_, internal_format, width_, height_);
+  }
+  else
+  {
+    glTextureStorage3D(id_, levels_, internal_format, width_, height_, depth_);
+  }
+
+  if (data != nullptr)
+  {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_);
+
+    if (target_ == GL_TEXTURE_2D)
+    {
+      glTextureSubImage2D(id_, 0, 0, 0, width_, height_, format_, type_, data);
+    }
+    else
+    {
+      glTextureSubImage3D(id_, 0, 0, 0, 0, width_, height_, depth_, format_, type_, data);
+    }
+  }
+
+  set_parameters();
+}
+#endif
+
+/*
+ * Every level is counted, including ones a mutable texture hasn't had
+ * uploaded yet, since they are what the texture will hold once complete.
+ * Array layers all have the same size, the depth of a 3D texture halves
+ */
+void Texture::account()
+{
+  const size_t texel = MemoryTracker::texel_size(internal_format_);
+  size_t bytes = 0;
+
+  for (int level = 0; level < levels_; ++level)
+  {
+    size_t depth = target_ == GL_TEXTURE_3D ? std::max(1, depth_ >> level) : depth_;
+
+    bytes += static_cast<size_t>(std::max(1, width_ >> level)) * std::max(1, height_ >> level)
+             * depth * texel;
+  }
+
+  MemoryTracker::get().resize(MemoryTracker::Category::Textures, byte_size_, bytes);
+  byte_size_ = bytes;
+}
+
 /*
  * Sets the texture paramaters. This makes sure the texture doesn't wrap and
- * uses a linear filter for resizing
+ * uses a nearest filter for resizing, or trilinear filtering if it has
+ * mipmaps
  */
 void Texture::set_parameters()
 {
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  const GLint min_filter = levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST;
+  const GLint mag_filter = levels_ > 1 ? GL_LINEAR : GL_NEAREST;
+
+#if defined(GL_VERSION_4_5)
+  if (immutable_)
+  {
+    glTextureParameteri(id_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(id_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(id_, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, mag_filter);
+    return;
+  }
+#endif
+
+  glTexParameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  glTexParameteri(target_, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+  glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, min_filter);
+  glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, mag_filter);
+  glTexParameteri(target_, GL_TEXTURE_MAX_LEVEL, levels_ - 1);
 }
 
 Texture::~Texture()
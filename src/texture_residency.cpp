@@ -0,0 +1,217 @@
+//
+// texture_residency.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "texture_residency.h"
+#include "texture_units.h"
+#include "exception.h"
+#include <algorithm>
+
+namespace BarelyGL {
+TextureResidency::TextureResidency(const size_t budget, const int max_dropped_levels)
+  : budget_(budget)
+  , max_dropped_levels_(std::max(0, max_dropped_levels))
+{
+}
+
+TextureResidency::Handle TextureResidency::add(const int width, const int height,
+                                               const GLenum format, const GLenum internal_format,
+                                               std::vector<uint8_t> pixels,
+                                               std::vector<std::vector<uint8_t>> mipmaps)
+{
+  Handle handle = entries_.size();
+
+  if (!free_.empty())
+  {
+    handle = free_.back();
+    free_.pop_back();
+  }
+  else
+  {
+    entries_.emplace_back();
+  }
+
+  Entry& added = entries_[handle];
+  added.width = width;
+  added.height = height;
+  added.format = format;
+  added.internal_format = internal_format;
+  added.pixels = std::move(pixels);
+  added.mipmaps = std::move(mipmaps);
+  added.texture.reset();
+  added.dropped = 0;
+  added.last_used = frame_;
+  added.live = true;
+
+  return handle;
+}
+
+void TextureResidency::remove(const Handle handle)
+{
+  Entry& removed = entry(handle);
+
+  evict(removed);
+  removed.pixels = std::vector<uint8_t>();
+  removed.mipmaps = std::vector<std::vector<uint8_t>>();
+  removed.live = false;
+
+  free_.push_back(handle);
+}
+
+const Texture& TextureResidency::bind(const Handle handle, const GLuint unit)
+{
+  Entry& bound = entry(handle);
+
+  if (!bound.texture || bound.dropped > 0)
+  {
+    if (bound.texture) ++restreams_;
+
+    upload(bound, 0);
+  }
+
+  bound.last_used = frame_;
+  TextureUnits::get().bind(unit, bound.texture.get());
+
+  return *bound.texture;
+}
+
+/*
+ * Shrinks in two passes over the least recently used textures: the first
+ * only drops levels, so that many textures losing detail is preferred to
+ * any texture disappearing, and the second evicts
+ */
+void TextureResidency::end_frame()
+{
+  size_t resident = resident_bytes();
+
+  if (resident > budget_)
+  {
+    std::vector<Entry*> candidates;
+
+    for (Entry& candidate : entries_)
+    {
+      if (candidate.live && candidate.texture && candidate.last_used < frame_)
+      {
+        candidates.push_back(&candidate);
+      }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+      return a->last_used < b->last_used;
+    });
+
+    for (size_t i = 0; i < candidates.size() && resident > budget_; ++i)
+    {
+      Entry& candidate = *candidates[i];
+      int dropped = std::min(max_dropped_levels_, static_cast<int>(candidate.mipmaps.size()));
+
+      if (dropped <= candidate.dropped) continue;
+
+      resident -= candidate.texture->byte_size();
+      upload(candidate, dropped);
+      resident += candidate.texture->byte_size();
+    }
+
+    for (size_t i = 0; i < candidates.size() && resident > budget_; ++i)
+    {
+      resident -= candidates[i]->texture->byte_size();
+      evict(*candidates[i]);
+    }
+  }
+
+  ++frame_;
+}
+
+size_t TextureResidency::resident_bytes() const
+{
+  size_t bytes = 0;
+
+  for (const Entry& resident : entries_)
+  {
+    if (resident.texture) bytes += resident.texture->byte_size();
+  }
+
+  return bytes;
+}
+
+int TextureResidency::dropped_levels(const Handle handle) const
+{
+  const Entry& found = entry(handle);
+  return found.texture ? found.dropped : 0;
+}
+
+bool TextureResidency::resident(const Handle handle) const
+{
+  return entry(handle).texture != nullptr;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+TextureResidency::Entry& TextureResidency::entry(const Handle handle)
+{
+  if (handle >= entries_.size() || !entries_[handle].live)
+  {
+    throw Exception("Invalid texture handle");
+  }
+
+  return entries_[handle];
+}
+
+const TextureResidency::Entry& TextureResidency::entry(const Handle handle) const
+{
+  if (handle >= entries_.size() || !entries_[handle].live)
+  {
+    throw Exception("Invalid texture handle");
+  }
+
+  return entries_[handle];
+}
+
+/*
+ * The old texture is destroyed first so the two are never resident at once.
+ * Only the levels below the dropped ones are copied for the upload, which
+ * are a small fraction of the whole chain
+ */
+void TextureResidency::upload(Entry& entry, const int dropped)
+{
+  evict(entry);
+
+  if (dropped == 0)
+  {
+    entry.texture.reset(new Texture(entry.width, entry.height, entry.format,
+                                    entry.internal_format, entry.pixels.data(), entry.mipmaps));
+  }
+  else
+  {
+    std::vector<std::vector<uint8_t>> mipmaps(entry.mipmaps.begin() + dropped,
+                                              entry.mipmaps.end());
+
+    entry.texture.reset(new Texture(std::max(1, entry.width >> dropped),
+                                    std::max(1, entry.height >> dropped), entry.format,
+                                    entry.internal_format, entry.mipmaps[dropped - 1].data(),
+                                    mipmaps));
+  }
+
+  entry.dropped = dropped;
+}
+
+/*
+ * The texture is purged rather than released, since a released name would
+ * keep its data store in the pool after the budget stopped counting it
+ */
+void TextureResidency::evict(Entry& entry)
+{
+  if (entry.texture)
+  {
+    entry.texture->purge();
+    entry.texture.reset();
+    entry.dropped = 0;
+  }
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,227 @@
+//
+// texture_units.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "texture_units.h"
+#include "texture.h"
+#include "sampler.h"
+#include "capabilities.h"
+#include "exception.h"
+
+namespace BarelyGL {
+TextureUnits& TextureUnits::get()
+{
+  static TextureUnits units;
+  return units;
+}
+
+void TextureUnits::bind(const GLuint unit, const Texture* texture)
+{
+  if (unit >= bound_.size()) throw Exception("Texture unit out of range");
+
+  GLuint id = texture != nullptr ? texture->id() : 0;
+
+  if (known_[unit] && bound_[unit] == id) return;
+
+  bind_single(unit, texture);
+}
+
+void TextureUnits::bind(const GLuint unit, const Texture* texture, const Sampler* sampler)
+{
+  bind(unit, texture);
+  bind_sampler(unit, sampler);
+}
+
+/*
+ * Finds the span of units that actually changed, then binds just that span,
+ * in one call if multi-bind is available
+ */
+void TextureUnits::bind(const std::vector<const Texture*>& textures, const GLuint first_unit)
+{
+  if (first_unit + textures.size() > bound_.size())
+  {
+    throw Exception("Texture unit out of range");
+  }
+
+  size_t first = textures.size();
+  size_t last = 0;
+
+  for (size_t i = 0; i < textures.size(); ++i)
+  {
+    GLuint unit = first_unit + static_cast<GLuint>(i);
+    GLuint id = textures[i] != nullptr ? textures[i]->id() : 0;
+
+    if (!known_[unit] || bound_[unit] != id)
+    {
+      if (first == textures.size()) first = i;
+      last = i;
+    }
+  }
+
+  if (first == textures.size()) return;
+
+#if defined(GL_VERSION_4_4)
+  if (multi_bind_)
+  {
+    names_.clear();
+
+    for (size_t i = first; i <= last; ++i)
+    {
+      GLuint unit = first_unit + static_cast<GLuint>(i);
+
+      names_.push_back(textures[i] != nullptr ? textures[i]->id() : 0);
+      bound_[unit] = names_.back();
+      known_[unit] = true;
+
+      // glBindTextures binds each name to its own target (and 0 clears every target)
+      if (textures[i] != nullptr) targets_[unit] = textures[i]->target();
+    }
+
+    glBindTextures(first_unit + static_cast<GLuint>(first), static_cast<GLsizei>(names_.size()),
+                   names_.data());
+    return;
+  }
+#endif
+
+  for (size_t i = first; i <= last; ++i)
+  {
+    bind(first_unit + static_cast<GLuint>(i), textures[i]);
+  }
+}
+
+void TextureUnits::bind_sampler(const GLuint unit, const Sampler* sampler)
+{
+  if (unit >= samplers_.size()) throw Exception("Texture unit out of range");
+
+  GLuint id = sampler != nullptr ? sampler->id() : 0;
+
+  if (samplers_known_[unit] && samplers_[unit] == id) return;
+
+  glBindSampler(unit, id);
+
+  samplers_[unit] = id;
+  samplers_known_[unit] = true;
+}
+
+void TextureUnits::bind_samplers(const std::vector<const Sampler*>& samplers,
+                                 const GLuint first_unit)
+{
+  if (first_unit + samplers.size() > samplers_.size())
+  {
+    throw Exception("Texture unit out of range");
+  }
+
+#if defined(GL_VERSION_4_4)
+  if (multi_bind_)
+  {
+    bool changed = false;
+    names_.clear();
+
+    for (size_t i = 0; i < samplers.size(); ++i)
+    {
+      GLuint unit = first_unit + static_cast<GLuint>(i);
+
+      names_.push_back(samplers[i] != nullptr ? samplers[i]->id() : 0);
+      changed = changed || !samplers_known_[unit] || samplers_[unit] != names_.back();
+      samplers_[unit] = names_.back();
+      samplers_known_[unit] = true;
+    }
+
+    if (changed)
+    {
+      glBindSamplers(first_unit, static_cast<GLsizei>(names_.size()), names_.data());
+    }
+
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < samplers.size(); ++i)
+  {
+    bind_sampler(first_unit + static_cast<GLuint>(i), samplers[i]);
+  }
+}
+
+void TextureUnits::invalidate()
+{
+  known_.assign(known_.size(), false);
+  samplers_known_.assign(samplers_known_.size(), false);
+  active_unit_ = -1;
+}
+
+void TextureUnits::invalidate_active()
+{
+  if (active_unit_ < 0)
+  {
+    invalidate();
+    return;
+  }
+
+  known_[active_unit_] = false;
+}
+
+void TextureUnits::invalidate(const GLuint texture)
+{
+  for (size_t unit = 0; unit < bound_.size(); ++unit)
+  {
+    if (bound_[unit] == texture) known_[unit] = false;
+  }
+}
+
+void TextureUnits::invalidate_sampler(const GLuint sampler)
+{
+  for (size_t unit = 0; unit < samplers_.size(); ++unit)
+  {
+    if (samplers_[unit] == sampler) samplers_known_[unit] = false;
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+TextureUnits::TextureUnits()
+{
+  GLint count = 0;
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &count);
+
+  bound_.assign(count > 0 ? count : 0, 0);
+  known_.assign(bound_.size(), false);
+  targets_.assign(bound_.size(), GL_TEXTURE_2D);
+  samplers_.assign(bound_.size(), 0);
+  samplers_known_.assign(bound_.size(), false);
+
+#if defined(GL_VERSION_4_4)
+  const Capabilities& caps = Capabilities::get();
+  multi_bind_ = caps.version_at_least(4, 4) || caps.has_extension("GL_ARB_multi_bind");
+#endif
+}
+
+void TextureUnits::bind_single(const GLuint unit, const Texture* texture)
+{
+  if (active_unit_ != static_cast<GLint>(unit))
+  {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    active_unit_ = static_cast<GLint>(unit);
+  }
+
+  GLuint id = texture != nullptr ? texture->id() : 0;
+  GLenum target = texture != nullptr ? texture->target() : targets_[unit];
+
+  // An unknown unit could have anything bound to the old target, so clear it too
+  if (target != targets_[unit] && (!known_[unit] || bound_[unit] != 0))
+  {
+    glBindTexture(targets_[unit], 0);
+  }
+
+  glBindTexture(target, id);
+
+  bound_[unit] = id;
+  known_[unit] = true;
+  targets_[unit] = target;
+}
+} // end of namespace BarelyGL
@@ -0,0 +1,50 @@
+//
+// vertex_array_cache.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "vertex_array_cache.h"
+#include "capabilities.h"
+#include "handle_pool.h"
+
+namespace BarelyGL {
+VertexArrayCache& VertexArrayCache::get()
+{
+  static VertexArrayCache cache;
+  return cache;
+}
+
+/*
+ * The VAOs hand their names back to the pool when destroyed, so the pool is
+ * made first to make sure it is destroyed after the cache at exit
+ */
+VertexArrayCache::VertexArrayCache()
+{
+  HandlePool::vertex_arrays();
+}
+
+VertexArrayObject& VertexArrayCache::vertex_array(const VertexAttributeArray& attributes)
+{
+  auto found = vertex_arrays_.find(attributes);
+
+  if (found == vertex_arrays_.end())
+  {
+    found = vertex_arrays_.emplace(attributes, VertexArrayObject()).first;
+    VertexArrayObject& vertex_array = found->second;
+
+    if (Capabilities::get().direct_state_access())
+    {
+      vertex_array.set_format(attributes);
+    }
+    else
+    {
+      vertex_array.bind();
+      vertex_array.set_format(attributes);
+      vertex_array.unbind();
+    }
+  }
+
+  return found->second;
+}
+} // end of namespace BarelyGL
@@ -7,6 +7,8 @@
 #include "vertex_array_object.h"
 #include "vertex_buffer_object.h"
 #include "index_buffer_object.h"
+#include "handle_pool.h"
+#include "capabilities.h"
 #include "exception.h"
 
 namespace BarelyGL {
@@ -26,6 +28,34 @@ VertexArrayObject::VertexArrayObject(const VertexAttributeArray& attributes,
   set_attributes(attributes);
 }
 
+VertexArrayObject::VertexArrayObject(VertexArrayObject&& other) noexcept
+  : id_(other.id_)
+  , vertex_buffer_(other.vertex_buffer_)
+  , index_buffer_(other.index_buffer_)
+  , attributes_(std::move(other.attributes_))
+  , vertex_size_(other.vertex_size_)
+{
+  other.id_ = 0;
+}
+
+VertexArrayObject& VertexArrayObject::operator=(VertexArrayObject&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    vertex_buffer_ = other.vertex_buffer_;
+    index_buffer_ = other.index_buffer_;
+    attributes_ = std::move(other.attributes_);
+    vertex_size_ = other.vertex_size_;
+
+    other.id_ = 0;
+  }
+
+  return *this;
+}
+
 VertexArrayObject::~VertexArrayObject()
 {
   destroy();
@@ -36,8 +66,104 @@ void VertexArrayObject::bind() const
   glBindVertexArray(id_);
 }
 
+void VertexArrayObject::attach(const VertexAttributeArray& attributes,
+                               const VertexBufferObject& vertex_buffer,
+                               const IndexBufferObject* index_buffer)
+{
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    set_format(attributes);
+    bind_buffers(vertex_buffer, index_buffer);
+    return;
+  }
+#endif
+
+  bind();
+  set_format(attributes);
+  bind_buffers(vertex_buffer, index_buffer);
+  unbind();
+  vertex_buffer.unbind();
+}
+
+/*
+ * Separate formats describe the layout once, with a single vertex buffer
+ * binding (0) that every attribute reads from
+ */
+void VertexArrayObject::set_format(const VertexAttributeArray& attributes)
+{
+  set_attributes(attributes);
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    GLuint offset = 0;
+
+    for (GLuint i = 0; i < attributes.attributes().size(); ++i)
+    {
+      GLint size = attributes.attributes()[i].size;
+
+      glEnableVertexArrayAttrib(id_, i);
+      glVertexArrayAttribFormat(id_, i, size, GL_FLOAT, GL_FALSE, offset * sizeof(float));
+      glVertexArrayAttribBinding(id_, i, 0);
+
+      offset += size;
+    }
+
+    return;
+  }
+#endif
+
+  if (Capabilities::get().vertex_attrib_binding()) attributes.set_format(0);
+}
+
+/*
+ * Without separate formats the attribute pointers capture the buffer bound
+ * to GL_ARRAY_BUFFER, so they have to be reissued for every buffer
+ */
+void VertexArrayObject::bind_buffers(const VertexBufferObject& vertex_buffer,
+                                     const IndexBufferObject* index_buffer)
+{
+  vertex_buffer_ = &vertex_buffer;
+  index_buffer_ = index_buffer;
+
+  const GLsizei stride = static_cast<GLsizei>(attributes_.size() * sizeof(float));
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glVertexArrayVertexBuffer(id_, 0, vertex_buffer.id(), 0, stride);
+    glVertexArrayElementBuffer(id_, index_buffer != nullptr ? index_buffer->id() : 0);
+    return;
+  }
+#endif
+
+#if defined(GL_VERSION_4_3)
+  if (Capabilities::get().vertex_attrib_binding())
+  {
+    glBindVertexBuffer(0, vertex_buffer.id(), 0, stride);
+  }
+  else
+#endif
+  {
+    (void)stride;
+    vertex_buffer.bind();
+    attributes_.enable();
+  }
+
+  if (index_buffer != nullptr)
+  {
+    index_buffer->bind();
+  }
+  else
+  {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+}
+
 void VertexArrayObject::set_attributes(const VertexAttributeArray& attributes)
 {
+  attributes_ = attributes;
   vertex_size_ = attributes.size();
 }
 
@@ -78,9 +204,7 @@ void VertexArrayObject::unbind() const
 
 void VertexArrayObject::generate_array()
 {
-  glGenVertexArrays(1, &id_);
-
-  if (id_ == 0) throw Exception("Could not generate vertex array");
+  id_ = HandlePool::vertex_arrays().acquire();
 }
 
 void VertexArrayObject::draw_arrays(const GLenum mode, const GLsizei count) const
@@ -88,16 +212,44 @@ void VertexArrayObject::draw_arrays(const GLenum mode, const GLsizei count) cons
   glDrawArrays(mode, 0, count);
 }
 
+/*
+ * The fixed restart index (the largest value of the index type) is used when
+ * available, since it needs no extra state. Restart is turned off again
+ * afterwards so it never affects buffers that weren't made for it
+ */
 void VertexArrayObject::draw_elements(const GLenum mode) const
 {
+  if (!index_buffer_->primitive_restart())
+  {
+    glDrawElements(mode, static_cast<GLsizei>(index_buffer_->size()), GL_UNSIGNED_INT, 0);
+    return;
+  }
+
+  GLenum restart = GL_PRIMITIVE_RESTART;
+
+#if defined(GL_VERSION_4_3)
+  const Capabilities& caps = Capabilities::get();
+
+  if (caps.version_at_least(4, 3) || caps.has_extension("GL_ARB_ES3_compatibility"))
+  {
+    restart = GL_PRIMITIVE_RESTART_FIXED_INDEX;
+  }
+#endif
+
+  glEnable(restart);
+
+  if (restart == GL_PRIMITIVE_RESTART) glPrimitiveRestartIndex(0xFFFFFFFF);
+
   glDrawElements(mode, static_cast<GLsizei>(index_buffer_->size()), GL_UNSIGNED_INT, 0);
+  glDisable(restart);
 }
 
 void VertexArrayObject::destroy()
 {
   if (id_ != 0)
   {
-    glDeleteVertexArrays(1, &id_);
+    HandlePool::vertex_arrays().release(id_);
+    id_ = 0;
   }
 }
 } // end of namespace BarelyGL
@@ -19,6 +19,7 @@ VertexAttributeArray::VertexAttributeArray(std::vector<VertexAttribute> attribut
 void VertexAttributeArray::set_attributes(std::vector<VertexAttribute> attributes)
 {
   attributes_ = std::move(attributes);
+  size_ = 0;
 
   for (auto& attribute : attributes_)
   {
@@ -26,7 +27,7 @@ void VertexAttributeArray::set_attributes(std::vector<VertexAttribute> attribute
   }
 }
 
-void VertexAttributeArray::enable()
+void VertexAttributeArray::enable() const
 {
   int cur_offset = 0;
 
@@ -60,4 +61,51 @@ void VertexAttributeArray::enable()
     cur_offset += attr_size;
   }
 }
+
+void VertexAttributeArray::set_format(const GLuint binding) const
+{
+#if defined(GL_VERSION_4_3)
+  GLuint offset = 0;
+
+  for (GLuint i = 0; i < attributes_.size(); ++i)
+  {
+    GLint size = attributes_[i].size;
+
+    glEnableVertexAttribArray(i);
+    glVertexAttribFormat(i, size, GL_FLOAT, GL_FALSE, offset * sizeof(float));
+    glVertexAttribBinding(i, binding);
+
+    offset += size;
+  }
+#else
+  (void)binding;
+#endif
+}
+
+bool VertexAttributeArray::operator==(const VertexAttributeArray& other) const
+{
+  if (attributes_.size() != other.attributes_.size()) return false;
+
+  for (size_t i = 0; i < attributes_.size(); ++i)
+  {
+    if (attributes_[i].size != other.attributes_[i].size) return false;
+  }
+
+  return true;
+}
+
+/*
+ * FNV-1a over the attribute sizes
+ */
+size_t VertexAttributeArray::hash() const
+{
+  uint32_t hash = 2166136261u;
+
+  for (const VertexAttribute& attribute : attributes_)
+  {
+    hash = (hash ^ attribute.size) * 16777619u;
+  }
+
+  return hash;
+}
 } // end of namespace BarelyGL
@@ -7,6 +7,9 @@
 #include <OpenGL/gl3.h>
 #include "vertex_buffer_object.h"
 #include "index_buffer_object.h"
+#include "handle_pool.h"
+#include "capabilities.h"
+#include "memory_tracker.h"
 #include "exception.h"
 
 namespace BarelyGL {
@@ -17,6 +20,40 @@ VertexBufferObject::VertexBufferObject(const GLenum target, const GLenum usage)
   generate_buffer();
 }
 
+VertexBufferObject::VertexBufferObject(VertexBufferObject&& other) noexcept
+  : id_(other.id_)
+  , target_(other.target_)
+  , usage_(other.usage_)
+  , vertex_count_(other.vertex_count_)
+  , immutable_(other.immutable_)
+  , byte_size_(other.byte_size_)
+{
+  other.id_ = 0;
+  other.byte_size_ = 0;
+  other.vertex_count_ = 0;
+}
+
+VertexBufferObject& VertexBufferObject::operator=(VertexBufferObject&& other) noexcept
+{
+  if (this != &other)
+  {
+    destroy();
+
+    id_ = other.id_;
+    target_ = other.target_;
+    usage_ = other.usage_;
+    vertex_count_ = other.vertex_count_;
+    immutable_ = other.immutable_;
+    byte_size_ = other.byte_size_;
+
+    other.id_ = 0;
+    other.byte_size_ = 0;
+    other.vertex_count_ = 0;
+  }
+
+  return *this;
+}
+
 void VertexBufferObject::bind() const
 {
   glBindBuffer(target_, id_);
@@ -24,18 +61,62 @@ void VertexBufferObject::bind() const
 
 void VertexBufferObject::init_buffer(const GLsizeiptr size)
 {
-  glBufferData(target_, size * sizeof(float), 0, usage_);
+  set_data(size * sizeof(float), nullptr);
 }
 
 void VertexBufferObject::set_vertices(const std::vector<float>& vertices)
 {
-  vertex_count_ = vertices.size();
-  glBufferData(target_, vertices.size() * sizeof(float), vertices.data(), usage_);
+  set_vertices(vertices.data(), vertices.size());
+}
+
+void VertexBufferObject::set_vertices(const float* vertices, const size_t count)
+{
+  set_data(count * sizeof(float), vertices);
+  vertex_count_ = count;
+}
+
+/*
+ * Immutable storage can't be resized or orphaned, which lets the driver
+ * place it once. It is still dynamic so `sub_vertices` can update it
+ */
+void VertexBufferObject::set_storage(const std::vector<float>& vertices)
+{
+  set_storage(vertices.data(), vertices.size());
+}
+
+void VertexBufferObject::set_storage(const float* vertices, const size_t count)
+{
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    if (immutable_) throw Exception("Buffer storage is immutable");
+
+    vertex_count_ = count;
+    glNamedBufferStorage(id_, count * sizeof(float), vertices, GL_DYNAMIC_STORAGE_BIT);
+    immutable_ = true;
+
+    MemoryTracker::get().resize(MemoryTracker::Category::VertexBuffers, byte_size_,
+                                count * sizeof(float));
+    byte_size_ = count * sizeof(float);
+    return;
+  }
+#endif
+
+  set_vertices(vertices, count);
 }
 
 void VertexBufferObject::sub_vertices(const std::vector<float>& vertices, const GLintptr offset)
 {
   vertex_count_ = vertices.size();
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferSubData(id_, offset, vertices.size() * sizeof(float), vertices.data());
+    return;
+  }
+#endif
+
   glBufferSubData(target_, offset, vertices.size() * sizeof(float), vertices.data());
 }
 
@@ -57,16 +138,45 @@ VertexBufferObject::~VertexBufferObject()
 
 void VertexBufferObject::generate_buffer()
 {
-  glGenBuffers(1, &id_);
+  id_ = HandlePool::buffers().acquire();
+}
+
+void VertexBufferObject::set_data(const GLsizeiptr size, const void* data)
+{
+  if (immutable_) throw Exception("Buffer storage is immutable");
 
-  if (id_ == 0) throw Exception("Could not generate buffer");
+  MemoryTracker::get().resize(MemoryTracker::Category::VertexBuffers, byte_size_, size);
+  byte_size_ = size;
+
+#if defined(GL_VERSION_4_5)
+  if (Capabilities::get().direct_state_access())
+  {
+    glNamedBufferData(id_, size, data, usage_);
+    return;
+  }
+#endif
+
+  glBufferData(target_, size, data, usage_);
 }
 
 void VertexBufferObject::destroy()
 {
   if (id_ != 0)
   {
-    glDeleteBuffers(1, &id_);
+    if (immutable_)
+    {
+      glDeleteBuffers(1, &id_);
+    }
+    else
+    {
+      HandlePool::buffers().release(id_);
+    }
+
+    MemoryTracker::get().resize(MemoryTracker::Category::VertexBuffers, byte_size_, 0);
+
+    id_ = 0;
+    immutable_ = false;
+    byte_size_ = 0;
   }
 }
 } // end of namespace BarelyGL
@@ -0,0 +1,252 @@
+//
+// vertex_welder.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include "vertex_welder.h"
+#include "vertex_buffer_object.h"
+#include "index_buffer_object.h"
+#include "exception.h"
+
+namespace BarelyGL {
+namespace {
+/// Soups with fewer vertices than this are welded on the calling thread
+const size_t kParallelThreshold = 1 << 16;
+
+/*
+ * Finalizer from MurmurHash3, to spread the bits of each value over the hash
+ */
+uint32_t mix(uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+
+  return h;
+}
+} // end of anonymous namespace
+
+void WeldedMesh::upload(VertexBufferObject& vertex_buffer, IndexBufferObject& index_buffer) const
+{
+  vertex_buffer.set_vertices(vertices);
+  index_buffer.set_indices(indices);
+}
+
+VertexWelder::VertexWelder(const float epsilon, const size_t thread_count)
+  : epsilon_(epsilon)
+  , thread_count_(thread_count)
+{
+  if (thread_count_ == 0) thread_count_ = std::thread::hardware_concurrency();
+  if (thread_count_ == 0) thread_count_ = 1;
+}
+
+/*
+ * Welding happens in three passes:
+ *    1. Every vertex is hashed (split into ranges across threads)
+ *    2. Each thread takes the vertices whose hash falls in its bucket and
+ *       points every vertex at the first copy of it (`canonical`). Equal
+ *       vertices always hash to the same bucket, so no two threads ever need
+ *       to look at the same vertex.
+ *    3. The first copies are given output indices in order, which is cheap
+ *       enough to do serially
+ */
+WeldedMesh VertexWelder::weld(const std::vector<float>& soup,
+                              const VertexAttributeArray& attributes) const
+{
+  size_t stride = attributes.size();
+
+  if (stride == 0) throw Exception("Vertex welding needs vertex attributes");
+
+  size_t vertex_count = soup.size() / stride;
+  size_t threads = vertex_count >= kParallelThreshold ? thread_count_ : 1;
+
+  std::vector<uint32_t> hashes(vertex_count);
+  std::vector<int> canonical(vertex_count);
+
+  if (threads == 1)
+  {
+    hash_vertices(soup.data(), stride, 0, vertex_count, hashes);
+    find_duplicates(soup.data(), stride, hashes, 0, 1, canonical);
+  }
+  else
+  {
+    std::vector<std::thread> workers;
+    size_t chunk = (vertex_count + threads - 1) / threads;
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+      size_t first = std::min(vertex_count, t * chunk);
+      size_t last = std::min(vertex_count, first + chunk);
+
+      workers.emplace_back(&VertexWelder::hash_vertices, this, soup.data(), stride, first, last,
+                           std::ref(hashes));
+    }
+
+    for (auto& worker : workers) worker.join();
+
+    workers.clear();
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+      workers.emplace_back(&VertexWelder::find_duplicates, this, soup.data(), stride,
+                           std::cref(hashes), t, threads, std::ref(canonical));
+    }
+
+    for (auto& worker : workers) worker.join();
+  }
+
+  WeldedMesh mesh;
+  mesh.indices.resize(vertex_count);
+
+  std::vector<int> remap(vertex_count, -1);
+  int next = 0;
+
+  for (size_t i = 0; i < vertex_count; ++i)
+  {
+    size_t first = canonical[i];
+
+    if (first == i)
+    {
+      remap[i] = next++;
+      mesh.vertices.insert(mesh.vertices.end(), soup.begin() + i * stride,
+                           soup.begin() + (i + 1) * stride);
+    }
+
+    mesh.indices[i] = remap[first];
+  }
+
+  return mesh;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void VertexWelder::hash_vertices(const float* soup, const size_t stride, const size_t first,
+                                 const size_t last, std::vector<uint32_t>& hashes) const
+{
+  for (size_t i = first; i < last; ++i)
+  {
+    const float* vertex = soup + i * stride;
+    uint32_t h = 0x9747b28c;
+
+    for (size_t k = 0; k < stride; ++k)
+    {
+      int64_t value = quantize(vertex[k]);
+
+      h = mix(h ^ static_cast<uint32_t>(value)) ^ mix(static_cast<uint32_t>(value >> 32) + k);
+    }
+
+    hashes[i] = h;
+  }
+}
+
+/*
+ * Uses an open-addressed table of vertex indices, sized for the share of the
+ * vertices expected to land in this bucket. Vertices are visited in order, so
+ * whichever copy is found in the table is always the first one
+ */
+void VertexWelder::find_duplicates(const float* soup, const size_t stride,
+                                   const std::vector<uint32_t>& hashes, const size_t bucket,
+                                   const size_t bucket_count, std::vector<int>& canonical) const
+{
+  size_t vertex_count = hashes.size();
+  size_t expected = vertex_count / bucket_count + 1;
+  size_t table_size = 16;
+
+  while (table_size < expected * 2) table_size *= 2;
+
+  std::vector<int> table(table_size, -1);
+  size_t filled = 0;
+
+  for (size_t i = 0; i < vertex_count; ++i)
+  {
+    uint32_t h = hashes[i];
+
+    if (h % bucket_count != bucket) continue;
+
+    // Keep the load factor below a half by rehashing into a bigger table
+    if (filled * 2 >= table_size)
+    {
+      std::vector<int> old;
+      old.swap(table);
+
+      table_size *= 2;
+      table.assign(table_size, -1);
+
+      for (int entry : old)
+      {
+        if (entry < 0) continue;
+
+        size_t slot = (hashes[entry] / bucket_count) & (table_size - 1);
+
+        while (table[slot] >= 0) slot = (slot + 1) & (table_size - 1);
+
+        table[slot] = entry;
+      }
+    }
+
+    size_t current_mask = table_size - 1;
+    size_t slot = (h / bucket_count) & current_mask;
+
+    canonical[i] = static_cast<int>(i);
+
+    while (table[slot] >= 0)
+    {
+      int other = table[slot];
+
+      if (hashes[other] == h && equal(soup + other * stride, soup + i * stride, stride))
+      {
+        canonical[i] = other;
+        break;
+      }
+
+      slot = (slot + 1) & current_mask;
+    }
+
+    if (table[slot] < 0)
+    {
+      table[slot] = static_cast<int>(i);
+      ++filled;
+    }
+  }
+}
+
+bool VertexWelder::equal(const float* a, const float* b, const size_t stride) const
+{
+  for (size_t k = 0; k < stride; ++k)
+  {
+    if (quantize(a[k]) != quantize(b[k])) return false;
+  }
+
+  return true;
+}
+
+/*
+ * Exact comparisons use the bit pattern of the value (with -0 folded into 0,
+ * since they compare equal). Otherwise the value is snapped to the epsilon
+ * grid
+ */
+int64_t VertexWelder::quantize(const float value) const
+{
+  if (epsilon_ > 0.0f)
+  {
+    return static_cast<int64_t>(std::floor(value / epsilon_));
+  }
+
+  float normalized = value == 0.0f ? 0.0f : value;
+  uint32_t bits;
+  std::memcpy(&bits, &normalized, sizeof(bits));
+
+  return bits;
+}
+} // end of namespace BarelyGL
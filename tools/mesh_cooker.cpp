@@ -0,0 +1,241 @@
+//
+// mesh_cooker.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+// Cooks Wavefront OBJ meshes into the format `MeshFile` maps:
+//    mesh_cooker input.obj output.mesh [weld_epsilon]
+//
+// Polygons are triangulated as fans and the triangle soup is welded into an
+// indexed mesh. Each `usemtl` starts a new submesh. The layout is a position,
+// then a UV and a normal if the file has any.
+//
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mesh_file.h"
+#include "vertex_welder.h"
+#include "exception.h"
+
+using namespace BarelyGL;
+
+namespace {
+/**
+ * @brief The raw data of an OBJ file
+ */
+struct ObjData
+{
+  /// The positions (x, y, z)
+  std::vector<float> positions;
+  /// The texture coordinates (u, v)
+  std::vector<float> uvs;
+  /// The normals (x, y, z)
+  std::vector<float> normals;
+  /// The corners of each triangle, as (position, uv, normal) indices (-1 if missing)
+  std::vector<int> corners;
+  /// The first corner of each submesh
+  std::vector<size_t> submesh_starts;
+};
+
+/*
+ * OBJ indices start from 1, and negative ones count back from the end
+ */
+int resolve(const int index, const size_t count)
+{
+  if (index > 0) return index - 1;
+  if (index < 0) return static_cast<int>(count) + index;
+
+  throw Exception("Invalid index of 0 in OBJ face");
+}
+
+/*
+ * Reads a face corner of the form v, v/vt, v//vn or v/vt/vn
+ */
+void read_corner(const std::string& token, const ObjData& obj, int corner[3])
+{
+  corner[0] = corner[1] = corner[2] = -1;
+
+  std::istringstream stream(token);
+  std::string part;
+
+  for (int i = 0; i < 3 && std::getline(stream, part, '/'); ++i)
+  {
+    if (part.empty()) continue;
+
+    const size_t counts[3] = {obj.positions.size() / 3, obj.uvs.size() / 2,
+                              obj.normals.size() / 3};
+    corner[i] = resolve(std::atoi(part.c_str()), counts[i]);
+
+    if (corner[i] < 0 || static_cast<size_t>(corner[i]) >= counts[i])
+    {
+      throw Exception("OBJ face refers to a missing vertex: '" + token + "'");
+    }
+  }
+
+  // UVs and normals are optional, but every corner needs a position
+  if (corner[0] < 0) throw Exception("OBJ face corner has no position: '" + token + "'");
+}
+
+ObjData read_obj(const std::string& path)
+{
+  std::ifstream file(path);
+
+  if (!file) throw Exception("Could not open OBJ file: '" + path + "'");
+
+  ObjData obj;
+  std::string line;
+
+  while (std::getline(file, line))
+  {
+    std::istringstream stream(line);
+    std::string type;
+    stream >> type;
+
+    if (type == "v")
+    {
+      float x = 0.0f, y = 0.0f, z = 0.0f;
+      stream >> x >> y >> z;
+      obj.positions.insert(obj.positions.end(), {x, y, z});
+    }
+    else if (type == "vt")
+    {
+      float u = 0.0f, v = 0.0f;
+      stream >> u >> v;
+      obj.uvs.insert(obj.uvs.end(), {u, v});
+    }
+    else if (type == "vn")
+    {
+      float x = 0.0f, y = 0.0f, z = 0.0f;
+      stream >> x >> y >> z;
+      obj.normals.insert(obj.normals.end(), {x, y, z});
+    }
+    else if (type == "usemtl")
+    {
+      // Materials set before any face don't need a submesh of their own
+      if (!obj.submesh_starts.empty() && obj.submesh_starts.back() == obj.corners.size() / 3)
+      {
+        continue;
+      }
+
+      obj.submesh_starts.push_back(obj.corners.size() / 3);
+    }
+    else if (type == "f")
+    {
+      std::vector<int> polygon;
+      std::string token;
+
+      while (stream >> token)
+      {
+        int corner[3];
+        read_corner(token, obj, corner);
+        polygon.insert(polygon.end(), corner, corner + 3);
+      }
+
+      for (size_t i = 2; i < polygon.size() / 3; ++i)
+      {
+        obj.corners.insert(obj.corners.end(), polygon.begin(), polygon.begin() + 3);
+        obj.corners.insert(obj.corners.end(), polygon.begin() + (i - 1) * 3,
+                           polygon.begin() + (i + 1) * 3);
+      }
+    }
+  }
+
+  if (obj.submesh_starts.empty() || obj.submesh_starts.front() != 0)
+  {
+    obj.submesh_starts.insert(obj.submesh_starts.begin(), 0);
+  }
+
+  return obj;
+}
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " input.obj output.mesh [weld_epsilon]" << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    ObjData obj = read_obj(argv[1]);
+
+    const bool has_uvs = !obj.uvs.empty();
+    const bool has_normals = !obj.normals.empty();
+
+    std::vector<VertexAttribute> layout = {VertexAttribute::Position};
+    if (has_uvs) layout.push_back(VertexAttribute::UV);
+    if (has_normals) layout.push_back(VertexAttribute{3});
+
+    VertexAttributeArray attributes(layout);
+    std::vector<float> soup;
+    soup.reserve(obj.corners.size() / 3 * attributes.size());
+
+    for (size_t i = 0; i < obj.corners.size(); i += 3)
+    {
+      const int* corner = &obj.corners[i];
+
+      soup.insert(soup.end(), &obj.positions[corner[0] * 3], &obj.positions[corner[0] * 3] + 3);
+
+      if (has_uvs)
+      {
+        if (corner[1] >= 0)
+        {
+          soup.insert(soup.end(), &obj.uvs[corner[1] * 2], &obj.uvs[corner[1] * 2] + 2);
+        }
+        else
+        {
+          soup.insert(soup.end(), {0.0f, 0.0f});
+        }
+      }
+
+      if (has_normals)
+      {
+        if (corner[2] >= 0)
+        {
+          soup.insert(soup.end(), &obj.normals[corner[2] * 3], &obj.normals[corner[2] * 3] + 3);
+        }
+        else
+        {
+          soup.insert(soup.end(), {0.0f, 0.0f, 0.0f});
+        }
+      }
+    }
+
+    float epsilon = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 0.0f;
+    WeldedMesh mesh = VertexWelder(epsilon).weld(soup, attributes);
+
+    // Welding keeps every index in place, so submesh ranges carry straight over
+    std::vector<MeshSubmesh> submeshes;
+
+    for (size_t i = 0; i < obj.submesh_starts.size(); ++i)
+    {
+      size_t first = obj.submesh_starts[i];
+      size_t last = i + 1 < obj.submesh_starts.size() ? obj.submesh_starts[i + 1]
+                                                      : mesh.indices.size();
+
+      if (last == first) continue;
+
+      submeshes.push_back(MeshFile::make_submesh(attributes, mesh.vertices, mesh.indices,
+                                                 static_cast<uint32_t>(first),
+                                                 static_cast<uint32_t>(last - first)));
+    }
+
+    MeshFile::write(argv[2], attributes, mesh.vertices, mesh.indices, submeshes);
+
+    std::cout << argv[2] << ": " << mesh.vertices.size() / attributes.size() << " vertices, "
+              << mesh.indices.size() / 3 << " triangles, " << submeshes.size() << " submeshes"
+              << std::endl;
+  }
+  catch (const Exception& exception)
+  {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}